@@ -173,6 +173,15 @@ struct DrawOverFilter
 
 #define DEFAULT_HISTOGRAM_BINS 40
 
+// Images with more voxels than this get an approximate histogram from a
+// sample of HISTOGRAM_SAMPLE_SIZE voxels, which is refined in the background
+#define HISTOGRAM_SAMPLING_THRESHOLD (1 << 26)
+#define HISTOGRAM_SAMPLE_SIZE (1 << 20)
+
+// Memory for recently shown display slices kept for each view of a layer, in
+// bytes. This holds 16 RGBA slices of 512x512 pixels
+#define DISPLAY_SLICE_CACHE_MEMORY (16 << 20)
+
 /**
   A debugging function to get the system time in ms. Actual definition is
   in SystemInterface.cxx
@@ -72,6 +72,9 @@ itkEventMacro(MainImagePoseChangeEvent, LayerChangeEvent)
 /** The segmentation has changed */
 itkEventMacro(SegmentationChangeEvent, IRISEvent)
 
+/** A new undo point has been committed for a segmentation */
+itkEventMacro(SegmentationUndoPointEvent, IRISEvent)
+
 /** The level set image has changed (due to iteration) */
 itkEventMacro(LevelSetImageChangeEvent, IRISEvent)
 
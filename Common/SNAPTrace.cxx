@@ -0,0 +1,122 @@
+#include "SNAPTrace.h"
+
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> SNAPTrace::m_Enabled(false);
+
+namespace
+{
+
+struct TraceEvent
+{
+  const char *Category, *Name;
+  long long Start, Duration;
+  int Thread;
+};
+
+// State of the recording. It is allocated once and never freed, so that
+// probes in static destructors that run after main() are still safe
+struct TraceState
+{
+  std::mutex Mutex;
+  std::string FileName;
+  std::vector<TraceEvent> Events;
+  size_t Dropped = 0;
+  std::chrono::steady_clock::time_point Origin = std::chrono::steady_clock::now();
+  std::atomic<int> NextThread{1};
+};
+
+TraceState &GetState()
+{
+  static TraceState *state = new TraceState();
+  return *state;
+}
+
+// Small sequential thread ids read better in the trace viewer
+int GetThreadId()
+{
+  thread_local int id = GetState().NextThread++;
+  return id;
+}
+
+void WriteJSONString(std::ostream &os, const char *s)
+{
+  os << '"';
+  for(; *s; s++)
+    {
+    if(*s == '"' || *s == '\\')
+      os << '\\' << *s;
+    else if((unsigned char) *s >= 0x20)
+      os << *s;
+    }
+  os << '"';
+}
+
+}
+
+void SNAPTrace::Start(const std::string &filename)
+{
+  TraceState &st = GetState();
+  std::lock_guard<std::mutex> guard(st.Mutex);
+  st.FileName = filename;
+  st.Events.clear();
+  st.Events.reserve(4096);
+  st.Dropped = 0;
+  st.Origin = std::chrono::steady_clock::now();
+  m_Enabled = true;
+}
+
+long long SNAPTrace::Now()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - GetState().Origin).count();
+}
+
+void SNAPTrace::Record(const char *category, const char *name,
+                       long long start, long long duration)
+{
+  TraceEvent ev = { category, name, start, duration, GetThreadId() };
+
+  TraceState &st = GetState();
+  std::lock_guard<std::mutex> guard(st.Mutex);
+  if(!m_Enabled)
+    return;
+
+  if(st.Events.size() < MaximumNumberOfEvents)
+    st.Events.push_back(ev);
+  else
+    st.Dropped++;
+}
+
+bool SNAPTrace::Stop()
+{
+  TraceState &st = GetState();
+  std::lock_guard<std::mutex> guard(st.Mutex);
+  if(!m_Enabled)
+    return true;
+
+  m_Enabled = false;
+
+  // Complete ("X") events, one per probe
+  std::ofstream fout(st.FileName.c_str());
+  fout << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":"
+       << st.Dropped << "},\"traceEvents\":[";
+  for(size_t i = 0; i < st.Events.size(); i++)
+    {
+    const TraceEvent &ev = st.Events[i];
+    fout << (i ? ",\n" : "\n") << "{\"name\":";
+    WriteJSONString(fout, ev.Name);
+    fout << ",\"cat\":";
+    WriteJSONString(fout, ev.Category);
+    fout << ",\"ph\":\"X\",\"ts\":" << ev.Start << ",\"dur\":" << ev.Duration
+         << ",\"pid\":1,\"tid\":" << ev.Thread << "}";
+    }
+  fout << "\n]}\n";
+
+  st.Events.clear();
+  st.Events.shrink_to_fit();
+  return fout.good();
+}
@@ -0,0 +1,74 @@
+#ifndef SNAPTRACE_H
+#define SNAPTRACE_H
+
+#include <atomic>
+#include <string>
+
+/**
+ * Lightweight timing instrumentation of the stages between user input and a
+ * repaint: event propagation, slicing, color mapping, rendering and mesh
+ * updates. Code is instrumented with the SNAP_TRACE macro, which times the
+ * enclosing scope. Recording is off by default, in which case a probe costs
+ * a single relaxed atomic load. When it is turned on (with the --trace option
+ * or the ITKSNAP_TRACE environment variable), the probes are kept in memory
+ * and written on Stop() in the Chrome trace event format, which can be
+ * opened in chrome://tracing or https://ui.perfetto.dev.
+ */
+class SNAPTrace
+{
+public:
+
+  /** Start recording, to be written to the given file when stopped */
+  static void Start(const std::string &filename);
+
+  /** Stop recording and write the trace. Returns false if writing failed */
+  static bool Stop();
+
+  /** Whether probes are being recorded */
+  static bool IsEnabled()
+    { return m_Enabled.load(std::memory_order_relaxed); }
+
+  /** Microseconds since the recording started */
+  static long long Now();
+
+  /**
+   * Record a completed probe. The name and category must be string literals
+   * or otherwise outlive the recording, since only the pointers are kept.
+   */
+  static void Record(const char *category, const char *name,
+                     long long start, long long duration);
+
+  /** Maximum number of probes kept; later probes are counted and dropped */
+  static const size_t MaximumNumberOfEvents = 1 << 20;
+
+private:
+  static std::atomic<bool> m_Enabled;
+};
+
+/** Times the scope in which it is declared */
+class SNAPTraceProbe
+{
+public:
+  SNAPTraceProbe(const char *category, const char *name)
+    : m_Category(category), m_Name(name),
+      m_Start(SNAPTrace::IsEnabled() ? SNAPTrace::Now() : -1) {}
+
+  ~SNAPTraceProbe()
+    {
+    if(m_Start >= 0)
+      SNAPTrace::Record(m_Category, m_Name, m_Start, SNAPTrace::Now() - m_Start);
+    }
+
+private:
+  const char *m_Category, *m_Name;
+  long long m_Start;
+};
+
+#define SNAP_TRACE_CONCAT_IMPL(a, b) a##b
+#define SNAP_TRACE_CONCAT(a, b) SNAP_TRACE_CONCAT_IMPL(a, b)
+
+/** Time the enclosing scope under the given category and name */
+#define SNAP_TRACE(category, name) \
+  SNAPTraceProbe SNAP_TRACE_CONCAT(snap_trace_probe_, __LINE__)(category, name)
+
+#endif // SNAPTRACE_H
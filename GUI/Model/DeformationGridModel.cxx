@@ -52,6 +52,14 @@ GetVertices(ImageWrapperBase *layer, DeformationGridVertices &v) const
       d_grid_d_ind[b] = m_Parent->ComputeGridPosition(phi, ind, vecimg) - G0;
       }
 
+    // When zoomed out, the slice may be taken from a downsampled copy of the
+    // image, so that each slice voxel spans several image voxels
+    if(vecimg->IsSlicingOrthogonal())
+      {
+      for(int b = 0; b < 2; b++)
+        d_grid_d_ind[b] *= slice->GetSpacing()[b] / m_Parent->GetSliceSpacing()[b];
+      }
+
     size_t nd0[2] {0, 0}, nd1[2] {0, 0};
     bool counted = false;
 
@@ -70,7 +78,7 @@ GetVertices(ImageWrapperBase *layer, DeformationGridVertices &v) const
         // Figure out how frequently to sample lines. The spacing on the screen should be at
         // most every 4 pixels. Zoom is in units of px/mm. Spacing is in units of mm/vox, so
         // zoom * spacing is (display pixels) / (image voxels).
-        double disp_pix_per_vox = m_Parent->GetSliceSpacing()[d] * m_Parent->GetViewZoom();
+        double disp_pix_per_vox = slice->GetSpacing()[d] * m_Parent->GetViewZoom();
         vox_increment = (int) ceil(8.0 / disp_pix_per_vox);
         }
       else
@@ -362,6 +362,30 @@ GenericSliceModel::GetSliceCornersInWindowCoordinates() const
   return corners;
 }
 
+std::pair<Vector2d, Vector2d>
+GenericSliceModel::GetDisplaySliceCornersInWindowCoordinates(ImageWrapperBase *layer) const
+{
+  // The origin of the display slice is the position of its corner in the
+  // slice, and its spacing may be coarser than the image spacing
+  ImageWrapperBase::DisplaySliceType *slice = layer->GetDisplaySlice(m_Id);
+  slice->UpdateOutputInformation();
+  auto size = slice->GetLargestPossibleRegion().GetSize();
+  if(size[0] == 0 || size[1] == 0)
+    return this->GetSliceCornersInWindowCoordinates();
+
+  auto origin = slice->GetOrigin();
+  auto spacing = slice->GetSpacing();
+  Vector2d uv0(origin[0], origin[1]);
+  Vector2d uv1(origin[0] + size[0] * spacing[0], origin[1] + size[1] * spacing[1]);
+
+  std::pair<Vector2d, Vector2d> corners;
+  Vector2ui canvas = this->GetCanvasSize();
+  Vector2d ctr(0.5 * canvas[0], 0.5 * canvas[1]);
+  corners.first = m_ViewZoom * (uv0 - m_ViewPosition) + ctr;
+  corners.second = m_ViewZoom * (uv1 - m_ViewPosition) + ctr;
+  return corners;
+}
+
 Vector3d GenericSliceModel::MapWindowToSlice(const Vector2d &uvWindow)
 {
   assert(IsSliceInitialized() && m_ViewZoom > 0);
@@ -179,6 +179,14 @@ public:
    */
   std::pair<Vector2d, Vector2d> GetSliceCornersInWindowCoordinates() const;
 
+  /**
+   * Get the corners of a layer's display slice in window coordinates. This
+   * differs from the above when the slice is taken from a downsampled copy
+   * of the image, which may not cover the full slice.
+   */
+  std::pair<Vector2d, Vector2d> GetDisplaySliceCornersInWindowCoordinates(
+      ImageWrapperBase *layer) const;
+
   /**
    * Map a point in slice coordinates to a point in PHYISCAL window coordinates
    */
@@ -982,6 +982,26 @@ void GlobalUIModel::AnimateLayerComponents()
     }
 }
 
+void GlobalUIModel::UpdateDeferredTimePoints()
+{
+  for(LayerIterator it = m_Driver->GetCurrentImageData()->GetLayers();
+      !it.IsAtEnd(); ++it)
+    {
+    if(it.GetLayer()->IsInitialized())
+      it.GetLayer()->UpdateDeferredTimePoints();
+    }
+}
+
+void GlobalUIModel::UpdateRefinedHistograms()
+{
+  for(LayerIterator it = m_Driver->GetCurrentImageData()->GetLayers();
+      !it.IsAtEnd(); ++it)
+    {
+    if(it.GetLayer()->IsInitialized())
+      it.GetLayer()->UpdateRefinedHistogram();
+    }
+}
+
 void GlobalUIModel::IncrementDrawingColorLabel(int delta)
 {
   ColorLabelTable *clt = m_Driver->GetColorLabelTable();
@@ -336,6 +336,18 @@ public:
    */
   void AnimateLayerComponents();
 
+  /**
+   * Bring in the time points of 4D layers that have been read from disk in
+   * the background since the last call. Called periodically by the GUI.
+   */
+  void UpdateDeferredTimePoints();
+
+  /**
+   * Bring in the exact histograms of large layers that have been computed in
+   * the background since the last call. Called periodically by the GUI.
+   */
+  void UpdateRefinedHistograms();
+
   /** Increment the current color label (delta = 1 or -1) */
   void IncrementDrawingColorLabel(int delta);
 
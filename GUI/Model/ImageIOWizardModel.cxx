@@ -330,6 +330,7 @@ void ImageIOWizardModel::OpenImage(std::string filename, ImageReadingProgressAcc
     m_LoadDelegate->UnloadCurrentImage();
 
     // Load the data from the image
+    m_GuidedIO->SetDeferTimePointLoading(m_LoadDelegate->CanDeferTimePointLoading());
 		m_GuidedIO->ReadNativeImageData(dataProgCmd);
 
     // Validate the image data
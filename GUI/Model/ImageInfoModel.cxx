@@ -1,8 +1,11 @@
 #include "ImageInfoModel.h"
 #include "LayerAssociation.txx"
 #include "MetaDataAccess.h"
+#include "LabelImageWrapper.h"
 #include <cctype>
 #include <algorithm>
+#include <sstream>
+#include <iomanip>
 
 
 // This compiles the LayerAssociation for the color map
@@ -48,6 +51,9 @@ ImageInfoModel::ImageInfoModel()
   m_ImageScalarIntensityUnderCursorModel = wrapGetterSetterPairAsProperty(
         this, &Self::GetImageScalarIntensityUnderCursor);
 
+  m_ImageMemoryUsageModel = wrapGetterSetterPairAsProperty(
+        this, &Self::GetImageMemoryUsage);
+
   // Create the property model for the filter
   m_MetadataFilterModel = ConcreteSimpleStringProperty::New();
 
@@ -234,6 +240,29 @@ bool ImageInfoModel::GetImageScalarIntensityUnderCursor(double &value)
   return false;
 }
 
+bool ImageInfoModel::GetImageMemoryUsage(std::string &value)
+{
+  ImageWrapperBase *l = dynamic_cast<ImageWrapperBase*>(this->GetLayer());
+
+  if(!l) return false;
+
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(1) << l->GetImageMemoryInMB() << " MB";
+  if(l->GetNumberOfTimePoints() > 1)
+    oss << " (" << l->GetNumberOfTimePoints() << " time points)";
+
+  double derived = l->GetDerivedDataMemoryInMB();
+  if(derived > 0.0)
+    oss << " + " << derived << " MB display";
+
+  LabelImageWrapper *seg = dynamic_cast<LabelImageWrapper *>(l);
+  if(seg && seg->GetUndoMemoryInMB() > 0.0)
+    oss << " + " << seg->GetUndoMemoryInMB() << " MB undo";
+
+  value = oss.str();
+  return true;
+}
+
 bool
 ImageInfoModel
 ::GetCurrentTimePointValueAndRange(
@@ -60,6 +60,7 @@ public:
   irisGetMacro(ImageNumberOfTimePointsModel, AbstractSimpleUIntProperty *)
   irisGetMacro(ImageCurrentTimePointModel, AbstractRangedUIntProperty *)
   irisGetMacro(ImageScalarIntensityUnderCursorModel, AbstractSimpleDoubleProperty *)
+  irisGetMacro(ImageMemoryUsageModel, AbstractSimpleStringProperty *)
 
   /** This model reports whether the active layer is in reference space */
   irisGetMacro(ImageIsInReferenceSpaceModel, AbstractSimpleBooleanProperty* )
@@ -97,6 +98,7 @@ protected:
   SmartPtr<AbstractSimpleUIntProperty> m_ImageNumberOfTimePointsModel;
   SmartPtr<AbstractRangedUIntProperty> m_ImageCurrentTimePointModel;
   SmartPtr<AbstractSimpleDoubleProperty> m_ImageScalarIntensityUnderCursorModel;
+  SmartPtr<AbstractSimpleStringProperty> m_ImageMemoryUsageModel;
 
 
   bool GetImageIsInReferenceSpace(bool &value);
@@ -110,6 +112,7 @@ protected:
   bool GetImageOrientation(std::string &value);
   bool GetImageNumberOfTimePoints(unsigned int &value);
   bool GetImageScalarIntensityUnderCursor(double &value);
+  bool GetImageMemoryUsage(std::string &value);
 
   // Current time point model
   bool GetCurrentTimePointValueAndRange(unsigned int &value, NumericValueRange<unsigned int> *range);
@@ -17,6 +17,7 @@
 #include "RandomForestClassifyImageFilter.h"
 #include "NumericPropertyToggleAdaptor.h"
 #include "itkStreamingImageFilter.h"
+#include <iomanip>
 
 SnakeWizardModel::SnakeWizardModel()
 {
@@ -154,6 +155,20 @@ SnakeWizardModel::SnakeWizardModel()
         GMMModifiedEvent(),
         GMMModifiedEvent());
 
+  m_ClusterAllVoxelsModel = wrapGetterSetterPairAsProperty(
+        this,
+        &Self::GetClusterAllVoxelsValue,
+        &Self::SetClusterAllVoxelsValue,
+        GMMModifiedEvent(),
+        GMMModifiedEvent());
+
+  void (Self::*nullstringsetter)(std::string) = NULL;
+  m_ClusteringIterationTimeModel = wrapGetterSetterPairAsProperty(
+        this,
+        &Self::GetClusteringIterationTimeValue,
+        nullstringsetter,
+        GMMModifiedEvent());
+
   m_ForegroundClusterModel = wrapGetterSetterPairAsProperty(
         this,
         &Self::GetForegroundClusterValueAndRange,
@@ -1561,6 +1576,38 @@ bool SnakeWizardModel::GetNumberOfGMMSamplesValueAndRange(int &value, NumericVal
   return false;
 }
 
+bool SnakeWizardModel::GetClusterAllVoxelsValue(bool &value)
+{
+  UnsupervisedClustering *uc = m_Driver->GetClusteringEngine();
+  if(!uc)
+    return false;
+
+  value = uc->GetUseAllVoxels();
+  return true;
+}
+
+void SnakeWizardModel::SetClusterAllVoxelsValue(bool value)
+{
+  // This only affects the iterations that follow, so the clusters are kept
+  UnsupervisedClustering *uc = m_Driver->GetClusteringEngine();
+  assert(uc);
+  uc->SetUseAllVoxels(value);
+  this->InvokeEvent(GMMModifiedEvent());
+}
+
+bool SnakeWizardModel::GetClusteringIterationTimeValue(std::string &value)
+{
+  // There is nothing to show until an iteration has been performed
+  UnsupervisedClustering *uc = m_Driver->GetClusteringEngine();
+  if(!uc || uc->GetLastIterationTime() <= 0.0)
+    return false;
+
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(0) << uc->GetLastIterationTime() << " ms";
+  value = oss.str();
+  return true;
+}
+
 void SnakeWizardModel::SetNumberOfGMMSamplesValue(int value)
 {
   UnsupervisedClustering *uc = m_Driver->GetClusteringEngine();
@@ -224,6 +224,9 @@ public:
   /** Model controlling the number of sampled for GMM optimization */
   irisRangedPropertyAccessMacro(NumberOfGMMSamples, int)
 
+  /** Model for whether GMM iterations use all voxels instead of the samples */
+  irisSimplePropertyAccessMacro(ClusterAllVoxels, bool)
+
   /** Model controlling the cluster used for the foreground probability */
   irisRangedPropertyAccessMacro(ForegroundCluster, int)
 
@@ -236,6 +239,9 @@ public:
 
   void PerformClusteringIteration();
 
+  /** Time taken by the last clustering iteration, for display */
+  irisGetMacro(ClusteringIterationTimeModel, AbstractSimpleStringProperty *)
+
   // TODO: get rid of this?
   bool SetClusterForegroundState(int cluster, bool state);
 
@@ -412,6 +418,12 @@ protected:
 
   // Model for the number of clusters
   SmartPtr<AbstractRangedIntProperty> m_NumberOfGMMSamplesModel;
+  SmartPtr<AbstractSimpleBooleanProperty> m_ClusterAllVoxelsModel;
+  bool GetClusterAllVoxelsValue(bool &value);
+  void SetClusterAllVoxelsValue(bool value);
+
+  SmartPtr<AbstractSimpleStringProperty> m_ClusteringIterationTimeModel;
+  bool GetClusteringIterationTimeValue(std::string &value);
   bool GetNumberOfGMMSamplesValueAndRange(int &value, NumericValueRange<int> *range);
   void SetNumberOfGMMSamplesValue(int value);
 
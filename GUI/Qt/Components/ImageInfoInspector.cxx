@@ -72,6 +72,8 @@ void ImageInfoInspector::SetModel(ImageInfoModel *model)
 
   makeCoupling(ui->outIntensityUnderCursor, m_Model->GetImageScalarIntensityUnderCursorModel(), tr_real);
 
+  makeCoupling(ui->outMemory, m_Model->GetImageMemoryUsageModel());
+
   // The page used to display the voxel coordinate depends on if the layer is in reference space
   // makePagedWidgetCoupling(ui->stkVoxelCoord, m_Model->GetImageIsInReferenceSpaceModel(),
   //                        std::map<bool, QWidget *>({{true, ui->pageReference}, {false, ui->pageOblique}}));
@@ -14,6 +14,7 @@
 #include "QtDoubleSpinBoxCoupling.h"
 #include "QtSliderCoupling.h"
 #include "QtRadioButtonCoupling.h"
+#include "QtLabelCoupling.h"
 #include "ColorLabelQuickListWidget.h"
 #include "IRISException.h"
 #include <QMessageBox>
@@ -225,6 +226,7 @@ void SnakeWizardPanel::SetModel(GlobalUIModel *model)
   // Couple the clustering controls
   makeCoupling(ui->inClusterCount, m_Model->GetNumberOfClustersModel());
   makeCoupling(ui->inClusterActive, m_Model->GetForegroundClusterModel());
+  makeCoupling(ui->outClusterIterationTime, m_Model->GetClusteringIterationTimeModel());
 
   // Set up activation on classification controls
   activateOnFlag(ui->lstClassifyForeground, m_Model, SnakeWizardModel::UIF_CLASSIFIER_TRAINED);
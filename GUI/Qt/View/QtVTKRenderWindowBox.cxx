@@ -8,6 +8,7 @@
 #include "QtReporterDelegates.h"
 #include "LatentITKEventNotifier.h"
 #include "SNAPQtCommon.h"
+#include "SNAPTrace.h"
 
 #include <vtkSphereSource.h>
 #include <vtkPolyDataMapper.h>
@@ -44,6 +45,8 @@ public:
   {
     if(m_NeedRender)
       {
+      // Rendering pulls the display slices and uploads them as textures
+      SNAP_TRACE("render", "QtVTKRenderWindowBox::Render");
       this->renderWindow()->Render();
       m_NeedRender = false;
       }
@@ -112,6 +115,7 @@ public:
 
   void paintEvent(QPaintEvent *evt) override
     {
+    SNAP_TRACE("render", "QtVTKRenderWindowBox::Render");
     m_RenderWindow->SetSize(this->width(), this->height());
     m_RenderWindow->Render();
     m_ImageFilter->Modified();
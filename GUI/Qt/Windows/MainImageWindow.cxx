@@ -1565,7 +1565,11 @@ void MainImageWindow::LoadProjectInNewInstance(const QString &file)
 void MainImageWindow::onAnimationTimeout()
 {
   if(m_Model)
+    {
     m_Model->AnimateLayerComponents();
+    m_Model->UpdateDeferredTimePoints();
+    m_Model->UpdateRefinedHistograms();
+    }
 }
 
 void MainImageWindow::on4DReplayTimeout()
@@ -2332,6 +2336,9 @@ void MainImageWindow::Update4DReplay()
     m_4DReplayTimer->setInterval(interval);
     }
 
+  // While replaying, slice the next few frames in the background
+  GetModel()->GetDriver()->SetTimePointPrefetchCount(isReplayOn ? 4 : 0);
+
   if (isReplayOn)
     this->m_4DReplayTimer->start();
   else
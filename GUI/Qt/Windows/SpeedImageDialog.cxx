@@ -105,6 +105,7 @@ void SpeedImageDialog::SetModel(SnakeWizardModel *model)
   // Couple the clustering widgets
   makeCoupling(ui->inNumClusters, model->GetNumberOfClustersModel());
   makeCoupling(ui->inNumSamples, model->GetNumberOfGMMSamplesModel());
+  makeCoupling(ui->inClusterAllVoxels, model->GetClusterAllVoxelsModel());
   makeCoupling(ui->inClusterXComponent, model->GetClusterPlottedComponentModel());
 
   // Couple the classification widgets
@@ -13,6 +13,7 @@
 #include "QtCursorOverride.h"
 #include "SNAPQtCommon.h"
 #include "SNAPTestQt.h"
+#include "SNAPTrace.h"
 
 #include "GenericSliceView.h"
 #include "GenericSliceModel.h"
@@ -158,6 +159,7 @@ void usage(const char *progname)
 #ifdef SNAP_DEBUG_EVENTS
   cout << "   --debug-events       : Dump information regarding UI events" << endl;
 #endif // SNAP_DEBUG_EVENTS
+  cout << "   --trace FILE         : Record timings of UI updates to FILE in Chrome trace format" << endl;
   cout << "   --test list          : List available tests. " << endl;
   cout << "   --test TESTID        : Execute a test. " << endl;
   cout << "   --testdir DIR        : Set the root directory for tests. " << endl;
@@ -218,6 +220,9 @@ public:
   // Number of threads
   int nThreads;
 
+  // Output file for timing traces
+  std::string fnTrace;
+
   // GUI scaling
   int nDevicePixelRatio;
 
@@ -329,6 +334,7 @@ int parse(int argc, char *argv[], CommandLineRequest &argdata)
   parser.AddSynonim("--help", "-h");
 
   parser.AddOption("--debug-events", 0);
+  parser.AddOption("--trace", 1);
 
   parser.AddOption("--no-fork", 0);
   parser.AddOption("--console", 0);
@@ -397,6 +403,10 @@ int parse(int argc, char *argv[], CommandLineRequest &argdata)
 #endif
     }
 
+  // Timing trace
+  if(parseResult.IsOptionPresent("--trace"))
+    argdata.fnTrace = parseResult.GetOptionParameter("--trace");
+
   // Initial directory
   if(parseResult.IsOptionPresent("--cwd"))
     argdata.cwd = parseResult.GetOptionParameter("--cwd");
@@ -674,6 +684,13 @@ int main(int argc, char *argv[])
   flag_snap_debug_events = argdata.flagDebugEvents;
 #endif
 
+  // Start recording timings if requested on the command line or environment
+  std::string fnTrace = argdata.fnTrace;
+  if(fnTrace.empty() && getenv("ITKSNAP_TRACE"))
+    fnTrace = getenv("ITKSNAP_TRACE");
+  if(fnTrace.size())
+    SNAPTrace::Start(fnTrace);
+
   // Setup crash signal handlers
   SetupSignalHandlers();
 
@@ -1040,6 +1057,10 @@ int main(int argc, char *argv[])
     // Run application
     int rc = app.exec();
 
+    // Write the timing trace
+    if(SNAPTrace::IsEnabled() && !SNAPTrace::Stop())
+      std::cerr << "Failed to write timing trace" << std::endl;
+
     // If everything cool, save the preferences
     if(!rc)
       gui->SaveUserPreferences();
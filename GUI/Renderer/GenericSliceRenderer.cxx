@@ -38,6 +38,7 @@
 #include "LayerAssociation.txx"
 #include "SliceWindowCoordinator.h"
 #include "PaintbrushSettingsModel.h"
+#include "SNAPTrace.h"
 #include <itkImageLinearConstIteratorWithIndex.h>
 
 
@@ -303,6 +304,8 @@ void GenericSliceRenderer::UpdateSceneAppearanceSettings()
 
 void GenericSliceRenderer::OnUpdate()
 {
+  SNAP_TRACE("render", "GenericSliceRenderer::OnUpdate");
+
   // Make sure the model has been updated first
   m_Model->Update();
 
@@ -722,8 +725,10 @@ void GenericSliceRenderer::UpdateRendererCameras()
       auto sz = m_Model->GetViewportLayout().vpList.front().size;
       if(it.GetLayer()->IsSlicingOrthogonal())
         {
-        // Map the corners of the slice into the viewport coordinates
-        auto sc = m_Model->GetSliceCornersInWindowCoordinates();
+        // Map the corners of the slice into the viewport coordinates. The
+        // slice may come from a downsampled copy of the image, so its own
+        // origin and spacing are used to place it
+        auto sc = m_Model->GetDisplaySliceCornersInWindowCoordinates(it.GetLayer());
         lta->m_ImageRect->SetCorners(sc.first[0], sc.first[1], sc.second[0], sc.second[1]);
         }
       else
@@ -4,6 +4,8 @@
 #include <iomanip>
 #include <fstream>
 #include <string>
+#include <cstring>
+#include <limits>
 
 using namespace std;
 
@@ -63,6 +65,8 @@ const char *ColorLabelTable::m_ColorList[ColorLabelTable::m_ColorListSize] = {
 ColorLabelTable
 ::ColorLabelTable()
 {
+  m_DisplayColorsMTime = 0;
+
   // Copy default labels to active labels
   InitializeToDefaults();
 }
@@ -450,6 +454,49 @@ const ColorLabel ColorLabelTable::GetColorLabel(size_t id) const
     return it->second;
 }
 
+// Pack the RGBA bytes of a label into a word, in memory order
+static uint32_t PackDisplayColor(const ColorLabel &cl)
+{
+  unsigned char rgba[4];
+  cl.GetRGBAVector(rgba);
+
+  uint32_t word;
+  memcpy(&word, rgba, 4);
+  return word;
+}
+
+const uint32_t *ColorLabelTable::GetDisplayColorArray() const
+{
+  if(m_DisplayColors.empty() || m_DisplayColorsMTime != this->GetMTime())
+    {
+    // The default colors repeat with the color list, so they are only
+    // generated once
+    static const std::vector<uint32_t> palette = []()
+      {
+      std::vector<uint32_t> colors;
+      for(size_t i = 0; i < m_ColorListSize; i++)
+        colors.push_back(PackDisplayColor(GetDefaultColorLabel(i + 1)));
+      return colors;
+      }();
+
+    // Invalid labels are drawn in their default colors
+    size_t n = (size_t) std::numeric_limits<LabelType>::max() + 1;
+    m_DisplayColors.resize(n);
+    for(size_t id = 1; id < n; id++)
+      m_DisplayColors[id] = palette[(id - 1) % m_ColorListSize];
+
+    // Valid labels are drawn in their own colors, unless they are hidden
+    uint32_t clear = PackDisplayColor(this->GetColorLabel(0));
+    m_DisplayColors[0] = clear;
+    for(ValidLabelConstIterator it = m_LabelMap.begin(); it != m_LabelMap.end(); ++it)
+      m_DisplayColors[it->first] = it->second.IsVisible() ? PackDisplayColor(it->second) : clear;
+
+    m_DisplayColorsMTime = this->GetMTime();
+    }
+
+  return &m_DisplayColors[0];
+}
+
 LabelType ColorLabelTable::GetFirstValidLabel() const
 {
   if(m_LabelMap.size() > 1)
@@ -42,6 +42,8 @@
 #include "SNAPEvents.h"
 #include "itkObjectFactory.h"
 #include "itkTimeStamp.h"
+#include <vector>
+#include <stdint.h>
 
 /**
  * \class ColorLabelTable
@@ -118,6 +120,15 @@ public:
   /** Get the collection of defined/valid labels */
   const ValidLabelMap &GetValidLabels() const { return m_LabelMap; }
 
+  /**
+    Get the colors in which all the label values, valid or not, are drawn.
+    The array is indexed by label value, and each entry holds the RGBA bytes
+    of the color in memory order. Labels that are not visible are drawn in
+    the color of the clear label. The array is recomputed when the table has
+    been modified since the last call.
+    */
+  const uint32_t *GetDisplayColorArray() const;
+
 protected:
 
   ColorLabelTable();
@@ -129,6 +140,10 @@ protected:
   // A flat array of color labels
   // ColorLabel m_Label[MAX_COLOR_LABELS], m_DefaultLabel[MAX_COLOR_LABELS];
 
+  // Display colors of all label values, and the time they were computed
+  mutable std::vector<uint32_t> m_DisplayColors;
+  mutable itk::ModifiedTimeType m_DisplayColorsMTime;
+
   static const char *m_ColorList[];
   static const size_t m_ColorListSize;
 };
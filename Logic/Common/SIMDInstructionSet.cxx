@@ -0,0 +1,51 @@
+#include "SIMDInstructionSet.h"
+
+#if defined(SIMD_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+static SIMDInstructionSet::InstructionSet DetectInstructionSet()
+{
+#if defined(SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2"))
+    return SIMDInstructionSet::AVX2;
+  if(__builtin_cpu_supports("sse2"))
+    return SIMDInstructionSet::SSE2;
+#elif defined(SIMD_X86) && defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  int n_ids = info[0];
+  if(n_ids >= 7)
+    {
+    // AVX2 needs the OS to save the YMM registers (OSXSAVE and XCR0 bits)
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    __cpuidex(info, 7, 0);
+    bool avx2 = (info[1] & (1 << 5)) != 0;
+    if(avx2 && osxsave && (_xgetbv(0) & 0x6) == 0x6)
+      return SIMDInstructionSet::AVX2;
+    }
+  return SIMDInstructionSet::SSE2;
+#endif
+  return SIMDInstructionSet::SCALAR;
+}
+
+SIMDInstructionSet::InstructionSet
+SIMDInstructionSet::GetBestInstructionSet()
+{
+  static const InstructionSet isa = DetectInstructionSet();
+  return isa;
+}
+
+const char *
+SIMDInstructionSet::GetInstructionSetName(InstructionSet isa)
+{
+  switch(isa)
+    {
+    case AVX2: return "AVX2";
+    case SSE2: return "SSE2";
+    default: return "scalar";
+    }
+}
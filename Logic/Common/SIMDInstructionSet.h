@@ -0,0 +1,38 @@
+#ifndef SIMDINSTRUCTIONSET_H
+#define SIMDINSTRUCTIONSET_H
+
+// x86 processors, for which the kernels have vectorized versions
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SIMD_X86
+#endif
+
+// GCC and Clang only emit SSE2 and AVX2 instructions in functions that ask
+// for them, so that the rest of the library still runs on older processors
+#if defined(SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_TARGET_SSE2 __attribute__((target("sse2")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SIMD_TARGET_SSE2
+#define SIMD_TARGET_AVX2
+#endif
+
+/**
+ * Run-time selection of the instruction set used by the kernels that have
+ * vectorized versions, such as the display slice lookup table mapping.
+ * Kernels are compiled for an instruction set with SIMD_TARGET_SSE2 or
+ * SIMD_TARGET_AVX2, and are called only when the processor supports it.
+ */
+class SIMDInstructionSet
+{
+public:
+
+  enum InstructionSet { SCALAR = 0, SSE2, AVX2 };
+
+  /** The most capable instruction set supported by this machine */
+  static InstructionSet GetBestInstructionSet();
+
+  /** Name of an instruction set, for reporting */
+  static const char *GetInstructionSetName(InstructionSet isa);
+};
+
+#endif // SIMDINSTRUCTIONSET_H
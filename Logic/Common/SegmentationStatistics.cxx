@@ -36,15 +36,17 @@
 #include "GenericImageData.h"
 #include "IRISApplication.h"
 #include "ImageCollectionToImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkMultiThreaderBase.h"
 
 #include <iostream>
 #include <iomanip>
+#include <mutex>
 
 
 using namespace std;
 
 
-// TODO: improve efficiency by using filters to integrate label intensities
 void
 SegmentationStatistics
 ::Compute(IRISApplication *app)
@@ -55,11 +57,9 @@ SegmentationStatistics
   // Get the selected segmentation layer
   LabelImageWrapper *seg = app->GetSelectedSegmentationLayer();
 
-  // A list of image sources
+  // A list of image sources and their column names
   vector<ScalarImageWrapperBase *> layers;
-
-  // Clear the list of column names
-  m_ImageStatisticsColumnNames.clear();
+  vector<string> names;
 
   // Find all the images available for statistics computation
   for(LayerIterator it(id, MAIN_ROLE | OVERLAY_ROLE); !it.IsAtEnd(); ++it)
@@ -67,7 +67,7 @@ SegmentationStatistics
     ScalarImageWrapperBase *lscalar = it.GetLayerAsScalar();
     if(lscalar)
       {
-      m_ImageStatisticsColumnNames.push_back(lscalar->GetNickname());
+      names.push_back(lscalar->GetNickname());
       layers.push_back(lscalar);
       }
     else
@@ -79,59 +79,106 @@ SegmentationStatistics
         oss << lvector->GetNickname();
         if(lvector->GetNumberOfComponents() > 1)
           oss << " [" << j << "]";
-        m_ImageStatisticsColumnNames.push_back(oss.str());
+        names.push_back(oss.str());
         layers.push_back(lvector->GetScalarRepresentation(
               SCALAR_REP_COMPONENT, j));
         }
       }
     }
 
+  // Compute the size of a voxel, in mm^3
+  const double *spacing = 
+    id->GetMain()->GetImageBase()->GetSpacing().GetDataPointer();
+  double volVoxel = spacing[0] * spacing[1] * spacing[2];
+
+  this->Compute(seg, layers, names, volVoxel);
+}
+
+void
+SegmentationStatistics
+::Compute(LabelImageWrapper *seg,
+          const vector<ScalarImageWrapperBase *> &layers,
+          const vector<string> &column_names,
+          double voxel_volume_mm3)
+{
+  typedef LabelImageWrapper::ImageType LabelImageType;
+  typedef LabelImageType::BufferType BufferType;
+  typedef LabelImageType::RLLine RLLine;
+  typedef BufferType::RegionType BufferRegionType;
+
   // Get the number of gray image layers
   size_t ngray = layers.size();
+  m_ImageStatisticsColumnNames = column_names;
 
-  // Clear and initialize the statistics table
+  // Clear and initialize the statistics table. The clear label is always
+  // listed, even if there are no voxels with that label
   m_Stats.clear();
+  m_Stats[0].resize(ngray);
 
-  // Start the label image iteration
-  LabelImageWrapper::ConstIterator itLabel = seg->GetImageConstIterator();
-  itk::ImageRegion<3> region = itLabel.GetRegion();
+  LabelImageType *image = seg->GetImage();
+  itk::ImageRegion<3> region = image->GetBufferedRegion();
 
-  // Cache the entry to avoid many calls to std::map
-  LabelType runLabel = 0;
-  Entry *cachedEntry = &m_Stats[runLabel];
-  cachedEntry->resize(ngray);
-  itk::Index<3> runStart = itLabel.GetIndex();
-  long runLength = 0;
+  // The label image is stored as one list of runs per line. Blocks of lines
+  // are handed to the threads, and every block is accumulated into a table
+  // of its own, which is added to the totals once the block is done
+  std::mutex mutex;
+  itk::MultiThreaderBase::Pointer mt = itk::MultiThreaderBase::New();
+  if(m_NumberOfThreads > 0)
+    {
+    mt->SetMaximumNumberOfThreads(m_NumberOfThreads);
+    mt->SetNumberOfWorkUnits(m_NumberOfThreads);
+    }
 
-  // Aggregate the statistical data
-  for( ; !itLabel.IsAtEnd(); ++itLabel, ++runLength)
+  if(region.GetNumberOfPixels() > 0)
     {
-    // Get the label and the corresponding entry (use cache to reduce time wasted in std::map)
-    LabelType label = itLabel.Value();
-    if(label != runLabel)
+    mt->ParallelizeImageRegion<2>(
+          LabelImageType::truncateRegion(region),
+          [&](const BufferRegionType &block)
       {
-      // Record the statistics from the last run
-      this->RecordRunLength(ngray, layers, region, runStart, runLength, cachedEntry);
+      EntryMap local;
 
-      // Change the cached entry
-      runLabel = label;
-      cachedEntry = &m_Stats[runLabel];
-      if(cachedEntry->count == 0)
-        cachedEntry->resize(ngray);
+      // Cache the entry to avoid many calls to std::map
+      LabelType runLabel = 0;
+      Entry *cachedEntry = NULL;
+      itk::Index<3> runStart;
 
-      runStart = itLabel.GetIndex();
-      runLength = 0;
-      }
-    }
+      typedef itk::ImageRegionConstIterator<BufferType> LineIterator;
+      for(LineIterator itLine(image->GetBuffer(), block); !itLine.IsAtEnd(); ++itLine)
+        {
+        const RLLine &line = itLine.Value();
+        runStart[0] = region.GetIndex(0);
+        runStart[1] = itLine.GetIndex()[0];
+        runStart[2] = itLine.GetIndex()[1];
+
+        for(size_t i = 0; i < line.size(); i++)
+          {
+          if(!cachedEntry || line[i].second != runLabel)
+            {
+            runLabel = line[i].second;
+            cachedEntry = &local[runLabel];
+            if(cachedEntry->count == 0)
+              cachedEntry->resize(ngray);
+            }
+
+          RecordRunLength(ngray, layers, region, runStart, line[i].first, cachedEntry);
+          runStart[0] += line[i].first;
+          }
+        }
 
-  // Record the statistics from the last run
-  this->RecordRunLength(ngray, layers, region, runStart, runLength, cachedEntry);
+      // Add the block's statistics to the totals
+      std::lock_guard<std::mutex> lock(mutex);
+      for(EntryMap::const_iterator it = local.begin(); it != local.end(); ++it)
+        {
+        Entry &total = m_Stats[it->first];
+        if(total.count == 0)
+          total.resize(ngray);
+        total.count += it->second.count;
+        total.sum += it->second.sum;
+        total.sumsq += it->second.sumsq;
+        }
+      }, nullptr);
+    }
 
-  // Compute the size of a voxel, in mm^3
-  const double *spacing = 
-    id->GetMain()->GetImageBase()->GetSpacing().GetDataPointer();
-  double volVoxel = spacing[0] * spacing[1] * spacing[2];
-  
   // Compute the mean and standard deviation
   for(EntryMap::iterator it = m_Stats.begin(); it != m_Stats.end(); ++it)
     {
@@ -148,13 +195,13 @@ SegmentationStatistics
       // Map with just shift
       entry.stdev[j] = layers[j]->GetNativeIntensityMapping()->MapGradientMagnitudeToNative(stdev);
       }
-    entry.volume_mm3 = entry.count * volVoxel;
+    entry.volume_mm3 = entry.count * voxel_volume_mm3;
     }
 }
 
 void SegmentationStatistics
-::RecordRunLength(size_t ngray, vector<ScalarImageWrapperBase *> &layers,
-                  itk::ImageRegion<3> &region, itk::Index<3> &runStart,
+::RecordRunLength(size_t ngray, const vector<ScalarImageWrapperBase *> &layers,
+                  const itk::ImageRegion<3> &region, const itk::Index<3> &runStart,
                   long runLength, Entry *cachedEntry)
 {
   // Record the statistics from the last run
@@ -175,40 +222,13 @@ void SegmentationStatistics
   // Get selected segmentation layer
   LabelImageWrapper *liw = app->GetSelectedSegmentationLayer();
 
-  // Get the iterator from the segmentation
-  LabelImageWrapper::ConstIterator it = liw->GetImageConstIterator();
-
-  // Iterate through image and update count
-  LabelType runLabel = 0;
-  unsigned long *cachedCnt = &result[runLabel];
-  unsigned long runLength = 0;
-
-  // Start counting
-  for (; !it.IsAtEnd(); ++it, ++runLength)
-    {
-      LabelType label = it.Value();
-      if (label != runLabel)
-        {
-          // std::cout << "run length: " << runLength << endl;
-          *cachedCnt += runLength;
-
-          // Reset for new count
-          runLabel = label;
-          cachedCnt = &result[runLabel];
-          runLength = 0;
-        }
-    }
-
-  // Add last run Length
-  *cachedCnt += runLength;
-
-  // Debug
-  /*
-  for (auto cit = result.cbegin(); cit != result.cend(); ++cit)
+  // The segmentation layer keeps an up to date index of voxel counts
+  const LabelImageWrapper::LabelVoxelCountMap &counts = liw->GetLabelVoxelCounts();
+  for(LabelImageWrapper::LabelVoxelCountMap::const_iterator it = counts.begin();
+      it != counts.end(); ++it)
     {
-      std::cout << cit->first << "=>" << cit->second << std::endl;
+    result[it->first] += it->second;
     }
-    */
 }
 
 void 
@@ -44,6 +44,7 @@
 class GenericImageData;
 class ColorLabelTable;
 class ScalarImageWrapperBase;
+class LabelImageWrapper;
 class IRISApplication;
 
 namespace itk {
@@ -81,8 +82,30 @@ public:
   /* A light-weight struct storing voxel count for each label */
   typedef std::map<LabelType, unsigned long> LabelVoxelCount;
 
+  SegmentationStatistics() : m_NumberOfThreads(0) {}
+
   /* Compute statistics from a segmentation image */
   void Compute(IRISApplication *app);
+
+  /**
+   * Compute statistics of the segmentation over a list of scalar layers.
+   * This is the engine behind Compute(IRISApplication *), and it only needs
+   * the wrappers, so command-line tools can use it as well. The runs of the
+   * label image are split between threads, each of which accumulates its
+   * own table. The tables are added up at the end. The column names are
+   * used when the statistics are exported.
+   */
+  void Compute(LabelImageWrapper *seg,
+               const std::vector<ScalarImageWrapperBase *> &layers,
+               const std::vector<std::string> &column_names,
+               double voxel_volume_mm3);
+
+  /* Number of threads used by Compute. Zero means the ITK default */
+  void SetNumberOfThreads(unsigned int n)
+    { m_NumberOfThreads = n; }
+
+  unsigned int GetNumberOfThreads() const
+    { return m_NumberOfThreads; }
   
   /* Export to a text file using legacy format */
   void ExportLegacy(std::ostream &oss, const ColorLabelTable &clt);
@@ -106,12 +129,15 @@ private:
 
   // Column information
   std::vector<std::string> m_ImageStatisticsColumnNames;
+
+  // Number of threads, zero for default
+  unsigned int m_NumberOfThreads;
   
-  void RecordRunLength(
+  static void RecordRunLength(
       size_t ngray,
-      std::vector<ScalarImageWrapperBase *> &layers,
-      itk::ImageRegion<3> &region,
-      itk::Index<3> &runStart,
+      const std::vector<ScalarImageWrapperBase *> &layers,
+      const itk::ImageRegion<3> &region,
+      const itk::Index<3> &runStart,
       long runLength,
       Entry *cachedEntry);
 };
@@ -33,4 +33,7 @@ DefaultBehaviorSettings::DefaultBehaviorSettings()
   // Paintbrush defaults
   m_PaintbrushDefaultInitialSizeModel = NewRangedProperty("PaintbrushDefaultInitialSize", 8, 1, 10000, 1);
   m_PaintbrushDefaultMaximumSizeModel = NewRangedProperty("PaintbrushDefaultMaximumSize", 40, 10, 10000, 1);
+
+  // Memory budget in megabytes (0 = unlimited)
+  m_MemoryBudgetModel = NewRangedProperty("MemoryBudget", 0, 0, 1048576, 256);
 }
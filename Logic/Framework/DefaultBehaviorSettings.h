@@ -43,6 +43,11 @@ public:
   irisRangedPropertyAccessMacro(PaintbrushDefaultInitialSize, int)
   irisRangedPropertyAccessMacro(PaintbrushDefaultMaximumSize, int)
 
+  // Upper bound on the memory held by loaded layers, in megabytes. When this
+  // is exceeded, derived data (display pipelines, undo history) is released.
+  // A value of zero means there is no limit.
+  irisRangedPropertyAccessMacro(MemoryBudget, int)
+
 protected:
 
   // Default behaviors
@@ -67,6 +72,9 @@ protected:
   SmartPtr<ConcreteRangedIntProperty> m_PaintbrushDefaultInitialSizeModel;
   SmartPtr<ConcreteRangedIntProperty> m_PaintbrushDefaultMaximumSizeModel;
 
+  // Memory budget
+  SmartPtr<ConcreteRangedIntProperty> m_MemoryBudgetModel;
+
   // Constructor
   DefaultBehaviorSettings();
 };
@@ -70,6 +70,9 @@ GenericImageData
   // Make main image wrapper point to grey wrapper initially
   m_MainImageWrapper = NULL;
 
+  // No background slicing until 4D replay asks for it
+  m_TimePointPrefetchCount = 0;
+
   // Add to the relevant lists
   m_Wrappers[MAIN_ROLE].push_back(m_MainImageWrapper);
 
@@ -162,10 +165,17 @@ GenericImageData::CreateAnatomicWrapper(GuidedNativeImageIO *io, ITKTransformTyp
     // Set properties
     wrapper->SetDisplayGeometry(m_DisplayGeometry);
     wrapper->SetImage4D(image, refSpace, transform);
+    wrapper->SetDeferredTimePointReader(io->GetDeferredTimePointReader());
     wrapper->SetNativeMapping(mapper);
     for(int i = 0; i < 3; i++)
       wrapper->SetDisplayViewportGeometry(i, m_DisplayViewportGeometry[i]);
 
+    // Large anatomical images are sliced from downsampled copies when zoomed out
+    wrapper->SetUseImagePyramid(true);
+
+    // Keep recently shown slices for scrolling back and forth
+    wrapper->SetDisplaySliceCacheMemory(DISPLAY_SLICE_CACHE_MEMORY);
+
     out_wrapper = wrapper.GetPointer();
     }
 
@@ -188,11 +198,18 @@ GenericImageData::CreateAnatomicWrapper(GuidedNativeImageIO *io, ITKTransformTyp
     // Set properties
     wrapper->SetDisplayGeometry(m_DisplayGeometry);
     wrapper->SetImage4D(image, refSpace, transform);
+    wrapper->SetDeferredTimePointReader(io->GetDeferredTimePointReader());
     wrapper->SetNativeMapping(mapper);
 
     for(int i = 0; i < 3; i++)
       wrapper->SetDisplayViewportGeometry(i, m_DisplayViewportGeometry[i]);
 
+    // Large anatomical images are sliced from downsampled copies when zoomed out
+    wrapper->SetUseImagePyramid(true);
+
+    // Keep recently shown slices for scrolling back and forth
+    wrapper->SetDisplaySliceCacheMemory(DISPLAY_SLICE_CACHE_MEMORY);
+
     out_wrapper = wrapper.GetPointer();
     }
 
@@ -369,6 +386,9 @@ GenericImageData
   // Send the color table to the new wrapper
   wrapper->GetDisplayMapping()->SetLabelColorTable(m_Parent->GetColorLabelTable());
 
+  // Keep recently shown slices for scrolling back and forth
+  wrapper->SetDisplaySliceCacheMemory(DISPLAY_SLICE_CACHE_MEMORY);
+
   // Sync up spacing between the main and label image
   wrapper->CopyImageCoordinateTransform(m_MainImageWrapper);
 }
@@ -406,6 +426,7 @@ GenericImageData
   // Intensity changes in the image wrapper are broadcast as segmentation events
   Rebroadcaster::Rebroadcast(seg_wrapper, WrapperImageChangeEvent(),
                              this, SegmentationChangeEvent());
+  Rebroadcaster::RebroadcastAsSourceEvent(seg_wrapper, SegmentationUndoPointEvent(), this);
 
   // Return the newly added wrapper
   return seg_wrapper;
@@ -448,6 +469,7 @@ LabelImageWrapper *GenericImageData::AddBlankSegmentation()
   // Intensity changes in the image wrapper are broadcast as segmentation events
   Rebroadcaster::Rebroadcast(seg, WrapperImageChangeEvent(),
                              this, SegmentationChangeEvent());
+  Rebroadcaster::RebroadcastAsSourceEvent(seg, SegmentationUndoPointEvent(), this);
 
   // Return the added wrapper
   return seg;
@@ -522,6 +544,25 @@ GenericImageData
       lit.GetLayer()->SetTimePointIndex(tp);
       }
     }
+
+  // Start on the slices of the time points that follow
+  if(m_TimePointPrefetchCount > 0)
+    SetTimePointPrefetchCount(m_TimePointPrefetchCount);
+}
+
+void
+GenericImageData
+::SetTimePointPrefetchCount(unsigned int n_ahead)
+{
+  m_TimePointPrefetchCount = n_ahead;
+
+  // Segmentations and other layers that may be edited while the time point
+  // changes are not sliced in the background
+  for(LayerIterator lit(this, MAIN_ROLE | OVERLAY_ROLE); !lit.IsAtEnd(); ++lit)
+    {
+    if(lit.GetLayer() && lit.GetLayer()->IsInitialized())
+      lit.GetLayer()->PrefetchTimePointSlices(n_ahead);
+    }
 }
 
 void GenericImageData::SetDisplayGeometry(const IRISDisplayGeometry &dispGeom)
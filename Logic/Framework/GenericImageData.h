@@ -315,6 +315,14 @@ public:
    */
   virtual void SetTimePoint(unsigned int time_point);
 
+  /**
+   * Set the number of time points after the selected one whose slices are
+   * computed in the background in the main image and overlays. This is used
+   * during 4D replay. Zero (default) turns this off.
+   */
+  void SetTimePointPrefetchCount(unsigned int n_ahead);
+  irisGetMacro(TimePointPrefetchCount, unsigned int)
+
   /**
    * Set the display to anatomy coordinate mapping, and propagate it to
    * all of the loaded layers
@@ -387,6 +395,9 @@ protected:
   // TimePointProperties - Nickname, tags etc. for timepoint
   SmartPtr<TimePointProperties> m_TimePointProperties;
 
+  // Number of upcoming time points sliced in the background
+  unsigned int m_TimePointPrefetchCount;
+
   friend class SNAPImageData;
   friend class LayerIterator;
 
@@ -65,6 +65,7 @@
 #include "vtkPointData.h"
 #include "SNAPRegistryIO.h"
 #include "Rebroadcaster.h"
+#include "SNAPEventListenerCallbacks.h"
 #include "HistoryManager.h"
 #include "IRISSlicer.h"
 #include "EdgePreprocessingSettings.h"
@@ -93,6 +94,7 @@
 #include <stdio.h>
 #include <sstream>
 #include <iomanip>
+#include <cmath>
 
 IRISApplication
 ::IRISApplication() 
@@ -144,6 +146,13 @@ IRISApplication
   Rebroadcaster::Rebroadcast(m_GlobalState->GetSelectedSegmentationLayerIdModel(), ValueChangedEvent(),
                              this, SegmentationChangeEvent());
 
+  // Every undo commit grows the undo history, so the memory budget is
+  // checked again after each one
+  AddListener(m_IRISImageData, SegmentationUndoPointEvent(),
+              this, &IRISApplication::OnSegmentationUndoPoint);
+  AddListener(m_SNAPImageData, SegmentationUndoPointEvent(),
+              this, &IRISApplication::OnSegmentationUndoPoint);
+
   // Initialize the preprocessing settings
   // TODO: m_ThresholdSettings = ThresholdSettings::New();
   m_EdgePreprocessingSettings = EdgePreprocessingSettings::New();
@@ -168,6 +177,10 @@ IRISApplication
 
   // Data saved for restoring IRIS state while in SNAP state
   m_SavedIRISSelectedSegmentationLayerId = 0;
+
+  // Memory measured by the last memory budget check
+  m_LoadedDataMemoryInMB = 0.0;
+  m_ReleasableMemoryInMB = 0.0;
 }
 
 
@@ -520,6 +533,9 @@ IRISApplication
   // Let the GUI know that segmentation changed
   InvokeEvent(SegmentationChangeEvent());
 
+  // Keep the loaded data within the memory budget
+  this->EnforceMemoryBudget();
+
   // Return the pointer to the new layer
   return seg_wrapper;
 }
@@ -811,6 +827,14 @@ IRISApplication
     }
 }
 
+void
+IRISApplication
+::SetTimePointPrefetchCount(unsigned int n_ahead)
+{
+  m_IRISImageData->SetTimePointPrefetchCount(n_ahead);
+  m_SNAPImageData->SetTimePointPrefetchCount(n_ahead);
+}
+
 unsigned int
 IRISApplication
 ::GetCursorTimePoint() const
@@ -997,6 +1021,25 @@ IRISApplication::GetAnatomicalDirectionForDisplayWindow(int iWin) const
   return m_DisplayGeometry.GetAnatomicalDirectionForDisplayWindow(iWin);
 }
 
+/**
+ * Makes a layer slice its full-resolution image while in scope, even if the
+ * code in the scope throws
+ */
+class FullResolutionSlicingScope
+{
+public:
+  FullResolutionSlicingScope(ImageWrapperBase *layer)
+    : m_Layer(layer), m_Saved(layer->GetFullResolutionSlicing())
+    { m_Layer->SetFullResolutionSlicing(true); }
+
+  ~FullResolutionSlicingScope()
+    { m_Layer->SetFullResolutionSlicing(m_Saved); }
+
+private:
+  ImageWrapperBase *m_Layer;
+  bool m_Saved;
+};
+
 void
 IRISApplication
 ::ExportSlice(AnatomicalDirection iSliceAnat, const char *file)
@@ -1008,14 +1051,20 @@ IRISApplication
   // TODO: should this not export using the default scalar representation,
   // rather than RGB? Not sure...
 
+  // The slice is exported at full resolution, even if the view is zoomed
+  // out far enough for it to be taken from a downsampled copy of the image.
+  // The downsampled copies are kept for when the view is drawn next
+  ImageWrapperBase *main = m_CurrentImageData->GetMain();
+  FullResolutionSlicingScope full_resolution(main);
+
   // Find the slicer that slices along that direction
   typedef ImageWrapperBase::DisplaySliceType SliceType;
   SmartPtr<SliceType> imgGrey = NULL;
   for(size_t i = 0; i < 3; i++)
     {
-    if(iSliceImg == m_CurrentImageData->GetMain()->GetDisplaySliceImageAxis(i))
+    if(iSliceImg == main->GetDisplaySliceImageAxis(i))
       {
-      imgGrey = m_CurrentImageData->GetMain()->GetDisplaySlice(i);
+      imgGrey = main->GetDisplaySlice(i);
       break;
       }
     }
@@ -1187,9 +1236,8 @@ IRISApplication
                                 this->GetSelectedSegmentationLayer()->GetBufferedRegion(),
                                 drawing, DrawOverFilter(PAINT_OVER_ONE, drawover));
 
-  // Perform iteration
-  for(; !it.IsAtEnd(); ++it)
-    it.PaintAsForeground();
+  // Perform the update one RLE run at a time
+  it.PaintRegionAsForeground();
 
   // Register that the image has been updated
   if(it.Finalize("Replace label"))
@@ -1200,8 +1248,6 @@ IRISApplication
   return it.GetNumberOfChangedVoxels();
 }
 
-// TODO: This information should be cached at the segmentation layer level
-// by keeping track of label counts after every update operation.
 size_t
 IRISApplication
 ::GetNumberOfVoxelsWithLabel(LabelType label)
@@ -1209,25 +1255,174 @@ IRISApplication
   // Number of voxels matching current label
   size_t nvoxels = 0;
 
-  // We must iterate over all the label images
+  // We must iterate over all the label images. Each keeps an index of the
+  // voxel counts, so this does not require traversing the images
   for(LayerIterator it = this->GetCurrentImageData()->GetLayers(LABEL_ROLE);
       !it.IsAtEnd(); ++it)
     {
     LabelImageWrapper *wrapper = dynamic_cast<LabelImageWrapper *>(it.GetLayer());
-    const LabelImageType *seg = wrapper->GetImage();
+    nvoxels += wrapper->GetNumberOfVoxelsWithLabel(label);
+    }
+
+  return nvoxels;
+}
+
+
+std::list<GenericImageData *>
+IRISApplication
+::GetLoadedImageData()
+{
+  // The IRIS data is always present; the SNAP data only in snake mode
+  std::list<GenericImageData *> data;
+  data.push_back(m_IRISImageData);
+  if(IsSnakeModeActive())
+    data.push_back(m_SNAPImageData);
+  return data;
+}
 
-    // Get the number of voxels
-    for(LabelImageWrapper::ConstIterator it(seg, seg->GetBufferedRegion());
-        !it.IsAtEnd(); ++it)
+double
+IRISApplication
+::GetLoadedDataMemoryInMB()
+{
+  double memory = 0.0;
+
+  std::list<GenericImageData *> data = this->GetLoadedImageData();
+  for(std::list<GenericImageData *>::iterator itd = data.begin(); itd != data.end(); ++itd)
+    {
+    for(LayerIterator it = (*itd)->GetLayers(); !it.IsAtEnd(); ++it)
+      memory += it.GetLayer()->GetImageMemoryInMB();
+
+    ImageMeshLayers *mesh_layers = (*itd)->GetMeshLayers();
+    std::vector<unsigned long> ids = mesh_layers->GetLayerIds();
+    for(unsigned int i = 0; i < ids.size(); i++)
+      memory += mesh_layers->GetLayer(ids[i])->GetTotalMemoryInMB();
+    }
+
+  return memory;
+}
+
+double
+IRISApplication
+::GetReleasableMemoryInMB()
+{
+  double memory = 0.0;
+
+  std::list<GenericImageData *> data = this->GetLoadedImageData();
+  for(std::list<GenericImageData *>::iterator itd = data.begin(); itd != data.end(); ++itd)
+    {
+    for(LayerIterator it = (*itd)->GetLayers(); !it.IsAtEnd(); ++it)
       {
-      if(it.Get() == label)
-        ++nvoxels;
+      ImageWrapperBase *layer = it.GetLayer();
+      memory += layer->GetDerivedDataMemoryInMB();
+
+      LabelImageWrapper *seg = dynamic_cast<LabelImageWrapper *>(layer);
+      if(seg)
+        memory += seg->GetUndoMemoryInMB();
       }
     }
 
-  return nvoxels;
+  return memory;
 }
 
+double
+IRISApplication
+::GetTotalMemoryInMB()
+{
+  return this->GetLoadedDataMemoryInMB() + this->GetReleasableMemoryInMB();
+}
+
+bool
+IRISApplication
+::IsLayerShown(ImageWrapperBase *layer, LayerRole role)
+{
+  if(!layer->IsDrawable())
+    return false;
+
+  // Only the selected segmentation is drawn
+  if(role == LABEL_ROLE)
+    return layer->GetUniqueId() == m_GlobalState->GetSelectedSegmentationLayerId();
+
+  // Overlays are drawn over every view
+  if(role != MAIN_ROLE && layer->IsSticky())
+    return true;
+
+  // Every other layer has a tile of its own in the tiled layout, but only
+  // the selected one is shown in full in the stacked layout
+  return m_GlobalState->GetSliceViewLayerLayout() == LAYOUT_TILED
+      || layer->GetUniqueId() == m_GlobalState->GetSelectedLayerId();
+}
+
+void
+IRISApplication
+::EnforceMemoryBudget()
+{
+  // Loading data is the only thing that changes the memory held by the
+  // images and meshes themselves, so it is measured here and kept for the
+  // checks that follow undo commits
+  m_LoadedDataMemoryInMB = this->GetLoadedDataMemoryInMB();
+  m_ReleasableMemoryInMB = this->GetReleasableMemoryInMB();
+  this->ApplyMemoryBudget();
+}
+
+void
+IRISApplication
+::OnSegmentationUndoPoint()
+{
+  int budget = m_GlobalState->GetDefaultBehaviorSettings()->GetMemoryBudget();
+  if(budget <= 0)
+    return;
+
+  // Nothing to do unless the undo history and derived data have grown since
+  // the last check
+  double releasable = this->GetReleasableMemoryInMB();
+  bool grown = releasable > m_ReleasableMemoryInMB;
+  m_ReleasableMemoryInMB = releasable;
+  if(grown)
+    this->ApplyMemoryBudget();
+}
+
+void
+IRISApplication
+::ApplyMemoryBudget()
+{
+  int budget = m_GlobalState->GetDefaultBehaviorSettings()->GetMemoryBudget();
+  double excess = m_LoadedDataMemoryInMB + m_ReleasableMemoryInMB - budget;
+  if(budget <= 0 || excess <= 0)
+    return;
+
+  std::list<GenericImageData *> data = this->GetLoadedImageData();
+  std::list<GenericImageData *>::iterator itd;
+
+  // The oldest undo points of the segmentations go first, only as many as
+  // it takes to get back under the budget
+  for(itd = data.begin(); itd != data.end() && excess > 0; ++itd)
+    {
+    for(LayerIterator it = (*itd)->GetLayers(LABEL_ROLE); !it.IsAtEnd() && excess > 0; ++it)
+      {
+      LabelImageWrapper *seg = dynamic_cast<LabelImageWrapper *>(it.GetLayer());
+      if(seg)
+        excess -= seg->PruneUndoHistory(excess);
+      }
+    }
+
+  // Then the derived data of the layers that are not on screen. It is
+  // rebuilt on demand the next time the layer is displayed. The layers on
+  // screen keep theirs, or it would be rebuilt on the next repaint
+  for(itd = data.begin(); itd != data.end() && excess > 0; ++itd)
+    {
+    for(LayerIterator it = (*itd)->GetLayers(); !it.IsAtEnd() && excess > 0; ++it)
+      {
+      ImageWrapperBase *layer = it.GetLayer();
+      if(*itd != m_CurrentImageData || !this->IsLayerShown(layer, it.GetRole()))
+        {
+        excess -= layer->GetDerivedDataMemoryInMB();
+        layer->ReleaseDerivedData();
+        }
+      }
+    }
+
+  m_ReleasableMemoryInMB = this->GetReleasableMemoryInMB();
+}
 
 int
 IRISApplication
@@ -1244,26 +1439,40 @@ IRISApplication
   // Adjust the intercept by 0.5 for voxel offset
   intercept -= 0.5 * (normal[0] + normal[1] + normal[2]);
 
-  // Iterate over the image, relabeling labels on one side of the plane
-  while(!it.IsAtEnd())
-    {
-    // Compute the distance to the plane
-    itk::Index<3> index = it.GetIndex();
-    double distance = 
-      index[0]*normal[0] + 
-      index[1]*normal[1] + 
-      index[2]*normal[2] - intercept;
-
-    // Check the side of the plane
-    if(distance > 0)
-      it.PaintAsForegroundPreserveClear();
-
-    // Next voxel
-    ++it;
-    }
+  // Distance from a voxel to the plane
+  auto distance = [normal, intercept](long x, long y, long z)
+  {
+    return x*normal[0] + y*normal[1] + z*normal[2] - intercept;
+  };
 
-  // Finalize
+  // Along each image line, the voxels on the positive side of the plane form
+  // a single interval, so we only need to find its endpoint
+  auto span = [distance, normal](const itk::Index<3> &idx, long &x0, long &x1)
+  {
+    long y = idx[1], z = idx[2];
+    if(normal[0] == 0.0)
+      return distance(x0, y, z) > 0;
+
+    // Estimate where the line crosses the plane, then correct the estimate
+    // using the same test as would be applied to each voxel
+    bool increasing = normal[0] > 0;
+    double root = -distance(0, y, z) / normal[0];
+    long xc = (long) std::min(std::max(std::ceil(root), (double) x0), (double) x1);
+    while(xc > x0 && (distance(xc - 1, y, z) > 0) == increasing) --xc;
+    while(xc < x1 && (distance(xc, y, z) > 0) != increasing) ++xc;
+    if(increasing)
+      x0 = xc;
+    else
+      x1 = xc;
+    return x1 > x0;
+  };
 
+  // Relabel labels on one side of the plane, leaving clear label alone
+  LabelType active = m_GlobalState->GetDrawingColorLabel();
+  it.RelabelRuns(
+        [&it, active](LabelType lOld) {
+          return lOld == 0 ? lOld : it.GetPaintedLabel(lOld, active); },
+        span);
 
   // Store the undo point if needed
   if(it.Finalize("3D scalpel"))
@@ -1497,6 +1706,9 @@ IRISApplication
   // not sticky!
   if(!layer->IsSticky())
     m_GlobalState->SetSelectedLayerId(layer->GetUniqueId());
+
+  // Keep the loaded data within the memory budget
+  this->EnforceMemoryBudget();
 }
 
 void
@@ -1542,6 +1754,9 @@ IRISApplication
   // Set the selected layer ID to be the new overlay
   if(!overlay->IsSticky())
     m_GlobalState->SetSelectedLayerId(overlay->GetUniqueId());
+
+  // Keep the loaded data within the memory budget
+  this->EnforceMemoryBudget();
 }
 
 void
@@ -1655,6 +1870,9 @@ IRISApplication
 
   // Reset timepoint properties
   m_IRISImageData->GetTimePointProperties()->CreateNewData();
+
+  // Keep the loaded data within the memory budget
+  this->EnforceMemoryBudget();
 }
 
 void IRISApplication::LoadMetaDataAssociatedWithLayer(
@@ -1851,7 +2069,9 @@ IRISApplication
   // Unload the current image data
   del->UnloadCurrentImage();
 
-  // Read the image body
+  // Read the image body. For 4D anatomical images, only the first time point
+  // may be read here and the rest after the image is shown
+  io->SetDeferTimePointLoading(del->CanDeferTimePointLoading());
 	io->ReadNativeImageData(dataProgCmd);
 
   // Validate the image data
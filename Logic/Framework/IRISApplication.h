@@ -491,6 +491,13 @@ public:
    */
   void SetCursorTimePoint(unsigned int time_point, bool force = false);
 
+  /**
+   * Set how many time points after the current one are sliced in the
+   * background, so that stepping through them during 4D replay is fast.
+   * Zero turns this off. See GenericImageData::SetTimePointPrefetchCount
+   */
+  void SetTimePointPrefetchCount(unsigned int n_ahead);
+
   /**
    * Get the current time point
    */
@@ -535,6 +542,23 @@ public:
     */
   size_t GetNumberOfVoxelsWithLabel(LabelType label);
 
+  /**
+    Total memory held by the loaded layers, in megabytes. This includes the
+    image data, the derived data (display pipelines) and the undo history
+    of every image layer, as well as the meshes.
+    */
+  double GetTotalMemoryInMB();
+
+  /**
+    If the memory budget in the default behavior settings is set and the
+    loaded layers exceed it, prune the undo history of the segmentations and
+    then release the derived data of the layers that are not on screen,
+    until the total falls under the budget or nothing more can be released.
+    Called after loading images; after undo commits, the check is repeated
+    only when the undo history and derived data have grown.
+    */
+  void EnforceMemoryBudget();
+
   /*
    * Cut the segmentation using a plane and relabed the segmentation
    * on the side of that plane
@@ -817,6 +841,29 @@ protected:
   // -------------- Saving IRIS state during SNAP mode --------------------
   unsigned long m_SavedIRISSelectedSegmentationLayerId;
 
+  // Memory held by the loaded images and meshes, and by the undo history and
+  // derived data, as of the last memory budget check
+  double m_LoadedDataMemoryInMB, m_ReleasableMemoryInMB;
+
+  // The image data objects whose layers are held in memory
+  std::list<GenericImageData *> GetLoadedImageData();
+
+  // Memory held by the loaded images and meshes. This walks every line of
+  // the run-length encoded segmentations
+  double GetLoadedDataMemoryInMB();
+
+  // Memory held by the undo history and derived data, which can be released
+  double GetReleasableMemoryInMB();
+
+  // Whether the layer is drawn in the slice views
+  bool IsLayerShown(ImageWrapperBase *layer, LayerRole role);
+
+  // Memory budget check after an undo point is committed to a segmentation
+  void OnSegmentationUndoPoint();
+
+  // Release memory until the last measured total is within the budget
+  void ApplyMemoryBudget();
+
 };
 
 #endif // __IRISApplication_h_
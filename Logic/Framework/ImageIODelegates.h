@@ -56,6 +56,12 @@ public:
   virtual bool GetUseRegistration() const { return false; }
   virtual bool IsOverlay() const { return false; }
 
+  /**
+   * Whether the time points of a 4D image after the first one may be read
+   * after the image has been added to the application
+   */
+  virtual bool CanDeferTimePointLoading() const { return false; }
+
 protected:
   AbstractOpenImageDelegate() : m_MetaDataRegistry(NULL) {}
   virtual ~AbstractOpenImageDelegate() {}
@@ -80,6 +86,8 @@ public:
 
   virtual void ValidateHeader(GuidedNativeImageIO *io, IRISWarningList &wl) ITK_OVERRIDE;
 
+  virtual bool CanDeferTimePointLoading() const ITK_OVERRIDE { return true; }
+
 protected:
   LoadAnatomicImageDelegate() {}
   virtual ~LoadAnatomicImageDelegate() {}
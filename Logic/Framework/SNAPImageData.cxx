@@ -543,10 +543,11 @@ void SNAPImageData::SwapLabelImageWithCompressedAlternative()
   if(m_CompressedAlternateLabelImage)
     {
     LabelImageWrapper::Iterator it_write(liw->GetModifiableImage(), liw->GetBufferedRegion());
-    for(size_t i = 0; i < m_CompressedAlternateLabelImage->GetNumberOfRLEs(); ++i)
+    for(CompressedLabelImageType::RunIterator rit(m_CompressedAlternateLabelImage);
+        !rit.IsAtEnd(); ++rit)
       {
-      LabelType value = m_CompressedAlternateLabelImage->GetRLEValue(i);
-      for(size_t j = 0; j < m_CompressedAlternateLabelImage->GetRLELength(i); ++j, ++it_write)
+      LabelType value = rit.GetValue();
+      for(size_t j = 0; j < rit.GetLength(); ++j, ++it_write)
         it_write.Set(value);
       }
     }
@@ -47,6 +47,7 @@
 #include "ImageWrapperTraits.h"
 #include "UndoDataManager.h"
 #include "LabelImageWrapper.h"
+#include <algorithm>
 
 /**
  * \class SegmentationUpdate
@@ -126,6 +127,7 @@ public:
         m_VoxelDelta += new_label - lOld;
         m_Iterator.Set(new_label);
         m_ChangedVoxels++;
+        m_LabelCountDelta.RecordChange(lOld, new_label);
         }
       }
   }
@@ -157,6 +159,7 @@ public:
         m_VoxelDelta += m_ActiveLabel - lOld;
         m_Iterator.Set(m_ActiveLabel);
         m_ChangedVoxels++;
+        m_LabelCountDelta.RecordChange(lOld, m_ActiveLabel);
         }
       }
   }
@@ -173,6 +176,7 @@ public:
       m_VoxelDelta += 0 - lOld;
       m_Iterator.Set(0);
       m_ChangedVoxels++;
+      m_LabelCountDelta.RecordChange(lOld, 0);
       }
   }
 
@@ -189,6 +193,7 @@ public:
       m_VoxelDelta += new_label - lOld;
       m_Iterator.Set(new_label);
       m_ChangedVoxels++;
+      m_LabelCountDelta.RecordChange(lOld, new_label);
       }
   }
 
@@ -215,10 +220,148 @@ public:
       m_VoxelDelta += new_label - lOld;
       m_Iterator.Set(new_label);
       m_ChangedVoxels++;
+      m_LabelCountDelta.RecordChange(lOld, new_label);
       }
   }
 
 
+  /**
+   * Get the label that PaintLabel(new_label) would assign to a voxel whose
+   * current label is lOld, taking into account the draw-over mask
+   */
+  LabelType GetPaintedLabel(LabelType lOld, LabelType new_label) const
+  {
+    if(m_DrawOver.CoverageMode == PAINT_OVER_ALL ||
+       (m_DrawOver.CoverageMode == PAINT_OVER_ONE && lOld == m_DrawOver.DrawOverLabel) ||
+       (m_DrawOver.CoverageMode == PAINT_OVER_VISIBLE && lOld != 0))
+      return new_label;
+    return lOld;
+  }
+
+  /**
+   * Runwise equivalent of calling PaintAsForeground() on every voxel in the
+   * region. Must be called instead of iterating.
+   */
+  void PaintRegionAsForeground()
+  {
+    LabelType active = m_ActiveLabel;
+    this->RelabelRuns(
+          [this, active](LabelType lOld) { return this->GetPaintedLabel(lOld, active); });
+  }
+
+  /**
+   * Runwise equivalent of calling ReplaceLabel() on every voxel in the
+   * region. Must be called instead of iterating.
+   */
+  void ReplaceLabelInRegion(LabelType target_label, LabelType new_label)
+  {
+    this->RelabelRuns(
+          [target_label, new_label](LabelType lOld) {
+            return lOld == target_label ? new_label : lOld; });
+  }
+
+  /**
+   * Relabel the region by operating on whole RLE segments rather than on
+   * individual voxels. This is only valid for updates in which the new label
+   * of a voxel depends on nothing but its old label. The relabel functor maps
+   * the old label to the new label. The optional span functor is called for
+   * each line of the region with the index of the first voxel in the line and
+   * may narrow the range [x_begin, x_end) to which the relabel functor is
+   * applied; it returns false if no voxels in the line should be updated.
+   *
+   * This method must be called before any voxels have been visited, and
+   * leaves the iterator at the end of the region. Undo deltas are encoded
+   * one run at a time, and Finalize() should be called as usual.
+   */
+  template <class TRelabelFunctor, class TSpanFunctor>
+  void RelabelRuns(const TRelabelFunctor &relabel, const TSpanFunctor &span)
+  {
+    typedef LabelImageType::BufferType BufferType;
+    typedef LabelImageType::RLLine RLLine;
+
+    assert(m_Iterator.IsAtBegin());
+
+    LabelImageType *image = m_Wrapper->GetModifiableImage();
+    long bri0 = image->GetBufferedRegion().GetIndex(0);
+    long r0 = m_Region.GetIndex(0), r1 = r0 + m_Region.GetSize(0);
+
+    // Lines are visited in the same order as voxels are visited by the iterator
+    itk::ImageRegionIterator<BufferType> itLine(
+          image->GetBuffer(), LabelImageType::truncateRegion(m_Region));
+
+    RLLine out;
+    for(; !itLine.IsAtEnd(); ++itLine)
+      {
+      RLLine &line = itLine.Value();
+
+      // Determine the span of the line that is subject to update
+      IndexType idx;
+      idx[0] = r0;
+      idx[1] = itLine.GetIndex()[0];
+      idx[2] = itLine.GetIndex()[1];
+      long s0 = r0, s1 = r1;
+      bool in_span = span(idx, s0, s1);
+      s0 = std::max(s0, r0);
+      s1 = std::min(s1, r1);
+      if(!in_span || s1 <= s0)
+        {
+        m_Delta->Encode(0, r1 - r0);
+        continue;
+        }
+
+      // Build the updated line, splitting segments at the region and span
+      // boundaries and merging adjacent segments with equal labels
+      out.clear();
+      out.reserve(line.size() + 4);
+      bool changed = false;
+      long x = bri0;
+      for(size_t i = 0; i < line.size(); i++)
+        {
+        long seg_end = x + line[i].first;
+        LabelType lOld = line[i].second;
+        LabelType lNew = relabel(lOld);
+
+        // Pieces of the segment before, inside and after the span
+        long a = std::min(std::max(x, s0), seg_end);
+        long b = std::max(std::min(seg_end, s1), a);
+
+        AppendRun(out, a - x, lOld);
+        AppendRun(out, b - a, lNew);
+        AppendRun(out, seg_end - b, lOld);
+
+        // Encode the undo delta for the part of the segment inside the region
+        long e0 = std::max(x, r0), e1 = std::min(seg_end, r1);
+        if(e1 > e0)
+          {
+          m_Delta->Encode(0, a - e0);
+          m_Delta->Encode(LabelType(lNew - lOld), b - a);
+          m_Delta->Encode(0, e1 - b);
+          }
+
+        if(lNew != lOld && b > a)
+          {
+          m_ChangedVoxels += b - a;
+          m_LabelCountDelta.RecordChange(lOld, lNew, b - a);
+          changed = true;
+          }
+
+        x = seg_end;
+        }
+
+      if(changed)
+        line.swap(out);
+      }
+
+    m_Iterator.GoToEnd();
+  }
+
+  /** RelabelRuns applied to every line of the region in full */
+  template <class TRelabelFunctor>
+  void RelabelRuns(const TRelabelFunctor &relabel)
+  {
+    this->RelabelRuns(relabel, [](const IndexType &, long &, long &) { return true; });
+  }
+
   bool IsAtEnd()
   {
     return m_Iterator.IsAtEnd();
@@ -235,7 +378,7 @@ public:
     m_Delta->FinishEncoding();
     if(m_ChangedVoxels > 0)
       {
-      m_Wrapper->PixelsModified();
+      m_Wrapper->PixelsModified(m_LabelCountDelta);
       if(undo_string)
         m_Wrapper->StoreUndoPoint(undo_string, RelinquishDelta());
       return true;
@@ -265,6 +408,17 @@ public:
 
 protected:
 
+  // Append a run to an RLE line, merging it with the last run if possible
+  static void AppendRun(LabelImageType::RLLine &line, long n, LabelType label)
+  {
+    if(n <= 0)
+      return;
+    if(line.size() && line.back().second == label)
+      line.back().first += n;
+    else
+      line.push_back(LabelImageType::RLSegment(n, label));
+  }
+
   // The label image wrapper to which segmentation is applied
   LabelImageWrapper *m_Wrapper;
 
@@ -291,6 +445,9 @@ protected:
 
   // Number of voxels actually modified
   unsigned long m_ChangedVoxels;
+
+  // Changes in per-label voxel counts, passed on to the wrapper
+  LabelVoxelCountDelta m_LabelCountDelta;
 };
 
 
@@ -44,6 +44,11 @@
  * The Delta class represents a difference between two images used in
  * the Undo system. It only supports linear traversal of images and
  * stores differences in an RLE (run length encoding) format.
+ *
+ * The runs are stored in a byte array, each as a variable-length run
+ * counter followed by the value. Large deltas (e.g., from relabeling or
+ * classification over the whole image) are additionally compressed with
+ * zlib when the encoding is finished.
  */
 template <typename TPixel>
 class UndoDelta
@@ -59,31 +64,71 @@ public:
   const RegionType &GetRegion()
   { return m_Region; }
 
-  void Encode(const TPixel &value);
+  /** Encode the next value, optionally repeated n times */
+  void Encode(const TPixel &value, size_t n = 1);
 
+  /** Store the last run and compress the delta if it is large */
   void FinishEncoding();
 
-  size_t GetNumberOfRLEs()
-  { return m_Array.size(); }
+  size_t GetNumberOfRLEs() const
+  { return m_NumberOfRLEs; }
 
-  TPixel GetRLEValue(size_t i)
-  { return m_Array[i].second; }
+  /** Memory held by the encoded runs, in bytes */
+  size_t GetSizeInBytes() const
+  { return m_Data.capacity(); }
 
-  size_t GetRLELength(size_t i)
-  { return m_Array[i].first; }
+  /** Whether the runs have been compressed */
+  bool IsCompressed() const
+  { return m_UncompressedSize > 0; }
 
   unsigned long GetUniqueID() const
   { return m_UniqueID; }
 
   UndoDelta & operator = (const UndoDelta &other);
 
+  /**
+   * Iterator over the runs of a delta, in the order in which they were
+   * encoded. A compressed delta is decompressed when the iterator is created.
+   */
+  class RunIterator
+  {
+  public:
+    RunIterator(const UndoDelta *delta);
+
+    bool IsAtEnd() const
+    { return m_AtEnd; }
+
+    size_t GetLength() const
+    { return m_Length; }
+
+    const TPixel &GetValue() const
+    { return m_Value; }
+
+    RunIterator & operator ++();
+
+  protected:
+    // Holds the runs of a compressed delta
+    std::vector<unsigned char> m_Buffer;
+    const unsigned char *m_Position, *m_End;
+    size_t m_Length;
+    TPixel m_Value;
+    bool m_AtEnd;
+  };
+
+  /** Encoded size above which a delta is compressed */
+  enum { CompressionThreshold = 0x10000 };
+
 protected:
-  typedef std::pair<size_t, TPixel> RLEPair;
-  typedef std::vector<RLEPair> RLEArray;
-  RLEArray m_Array;
+  void AppendRun(size_t length, const TPixel &value);
+
+  std::vector<unsigned char> m_Data;
+  size_t m_NumberOfRLEs;
   size_t m_CurrentLength;
   TPixel m_LastValue;
 
+  // Size of the runs before compression, zero if not compressed
+  size_t m_UncompressedSize;
+
   // The delta is associated with an image region
   RegionType m_Region;
 
@@ -123,13 +168,18 @@ public:
     Commit(const DList &list, const char *name);
     void DeleteDeltas();
     size_t GetNumberOfRLEs() const;
+    size_t GetSizeInBytes() const;
     const DList &GetDeltas() const { return m_Deltas; }
   protected:
     DList m_Deltas;
     std::string m_Name;
   };
 
-  UndoDataManager(size_t nMinCommits, size_t nMaxTotalSize);
+  /**
+   * Create an undo manager that keeps at least nMinCommits commits, and
+   * otherwise discards the oldest commits to stay within nMaxTotalBytes
+   */
+  UndoDataManager(size_t nMinCommits, size_t nMaxTotalBytes);
 
   /** Add a delta to the staging list. The staging list must be committed */
   void AddDeltaToStaging(Delta *delta);
@@ -149,6 +199,17 @@ public:
   size_t GetNumberOfCommits()
     { return m_CommitList.size(); }
 
+  /** Memory held by the stored commits, in megabytes */
+  double GetTotalMemoryInMB() const
+    { return m_TotalSize / (1024.0 * 1024.0); }
+
+  /**
+   * Discard the oldest commits that can be undone until at least nBytes have
+   * been freed, keeping at least the minimum number of commits given in the
+   * constructor. Used to free memory. Returns the number of bytes freed.
+   */
+  size_t PruneHistory(size_t nBytes);
+
 private:
 
   // Current staging list - where deltas are added
@@ -162,6 +223,8 @@ private:
   // A list of commits
   CList m_CommitList;
   CIterator m_Position;
+
+  // Total size of the commits and its limit, in bytes
   size_t m_TotalSize, m_MinCommits, m_MaxTotalSize;
 };
 
@@ -33,34 +33,63 @@
 
 =========================================================================*/
 
+#include "itk_zlib.h"
+#include <cstring>
+
 template<typename TPixel> unsigned long UndoDelta<TPixel>::m_UniqueIDCounter = 0;
 
 template<typename TPixel>
 UndoDelta<TPixel>
 ::UndoDelta()
 {
+  m_NumberOfRLEs = 0;
   m_CurrentLength = 0;
+  m_UncompressedSize = 0;
   m_UniqueID = m_UniqueIDCounter++;
 }
 
 template<typename TPixel>
 void
 UndoDelta<TPixel>
-::Encode(const TPixel &value)
+::AppendRun(size_t length, const TPixel &value)
 {
+  // The length is stored seven bits at a time, the high bit indicating
+  // that more bytes follow. Most runs fit into one or two bytes
+  while(length >= 0x80)
+    {
+    m_Data.push_back((unsigned char)(length | 0x80));
+    length >>= 7;
+    }
+  m_Data.push_back((unsigned char) length);
+
+  // The value is stored as is
+  const unsigned char *pv = reinterpret_cast<const unsigned char *>(&value);
+  m_Data.insert(m_Data.end(), pv, pv + sizeof(TPixel));
+
+  m_NumberOfRLEs++;
+}
+
+template<typename TPixel>
+void
+UndoDelta<TPixel>
+::Encode(const TPixel &value, size_t n)
+{
+  if(n == 0)
+    return;
+
   if(m_CurrentLength == 0)
     {
     m_LastValue = value;
-    m_CurrentLength = 1;
+    m_CurrentLength = n;
     }
   else if(value == m_LastValue)
     {
-    m_CurrentLength++;
+    m_CurrentLength += n;
     }
   else
     {
-    m_Array.push_back(std::make_pair(m_CurrentLength, m_LastValue));
-    m_CurrentLength = 1;
+    this->AppendRun(m_CurrentLength, m_LastValue);
+    m_CurrentLength = n;
     m_LastValue = value;
     }
 }
@@ -70,8 +99,30 @@ void
 UndoDelta<TPixel>
 ::FinishEncoding()
 {
+  assert(!this->IsCompressed());
+
   if(m_CurrentLength > 0)
-    m_Array.push_back(std::make_pair(m_CurrentLength, m_LastValue));
+    {
+    this->AppendRun(m_CurrentLength, m_LastValue);
+    m_CurrentLength = 0;
+    }
+
+  // Compress large deltas, keeping the result only if it is smaller
+  if(m_Data.size() > size_t(CompressionThreshold))
+    {
+    uLongf packed_size = compressBound(m_Data.size());
+    std::vector<unsigned char> packed(packed_size);
+    if(compress2(&packed[0], &packed_size, &m_Data[0], m_Data.size(), Z_BEST_SPEED) == Z_OK
+       && packed_size < m_Data.size())
+      {
+      packed.resize(packed_size);
+      m_UncompressedSize = m_Data.size();
+      m_Data.swap(packed);
+      }
+    }
+
+  // Release the space left over from growing the array
+  m_Data.shrink_to_fit();
 }
 
 template<typename TPixel>
@@ -79,20 +130,77 @@ UndoDelta<TPixel> &
 UndoDelta<TPixel>
 ::operator = (const UndoDelta<TPixel> &other)
 {
-  m_Array = other.m_Array;
+  m_Data = other.m_Data;
+  m_NumberOfRLEs = other.m_NumberOfRLEs;
   m_CurrentLength = other.m_CurrentLength;
   m_LastValue = other.m_LastValue;
+  m_UncompressedSize = other.m_UncompressedSize;
   m_Region = other.m_Region;
   return *this;
 }
 
+template<typename TPixel>
+UndoDelta<TPixel>::RunIterator
+::RunIterator(const UndoDelta<TPixel> *delta)
+{
+  const std::vector<unsigned char> &data = delta->m_Data;
+  if(delta->IsCompressed())
+    {
+    uLongf size = delta->m_UncompressedSize;
+    m_Buffer.resize(size);
+    if(uncompress(&m_Buffer[0], &size, &data[0], data.size()) != Z_OK
+       || size != delta->m_UncompressedSize)
+      {
+      itkGenericExceptionMacro(<< "Failed to decompress undo data");
+      }
+    m_Position = &m_Buffer[0];
+    m_End = m_Position + m_Buffer.size();
+    }
+  else
+    {
+    m_Position = data.empty() ? NULL : &data[0];
+    m_End = m_Position + data.size();
+    }
+
+  m_Length = 0;
+  m_AtEnd = false;
+  ++(*this);
+}
+
+template<typename TPixel>
+typename UndoDelta<TPixel>::RunIterator &
+UndoDelta<TPixel>::RunIterator
+::operator ++()
+{
+  if(m_Position == m_End)
+    {
+    m_AtEnd = true;
+    return *this;
+    }
+
+  // Decode the length
+  m_Length = 0;
+  for(unsigned int shift = 0; ; shift += 7)
+    {
+    unsigned char byte = *m_Position++;
+    m_Length |= size_t(byte & 0x7f) << shift;
+    if(!(byte & 0x80))
+      break;
+    }
+
+  // Decode the value
+  std::memcpy(&m_Value, m_Position, sizeof(TPixel));
+  m_Position += sizeof(TPixel);
+  return *this;
+}
+
 
 template<typename TPixel>
 UndoDataManager<TPixel>
-::UndoDataManager(size_t nMinCommits, size_t nMaxTotalSize)
+::UndoDataManager(size_t nMinCommits, size_t nMaxTotalBytes)
 {
   this->m_MinCommits = nMinCommits;
-  this->m_MaxTotalSize = nMaxTotalSize;
+  this->m_MaxTotalSize = nMaxTotalBytes;
   this->m_TotalSize = 0;
   m_Position = m_CommitList.begin();
 }
@@ -135,7 +243,7 @@ UndoDataManager<TPixel>
   // to the end. So that's the loop that we do
   while(m_Position != m_CommitList.end())
     {
-    m_TotalSize -= m_Position->GetNumberOfRLEs();
+    m_TotalSize -= m_Position->GetSizeInBytes();
     m_Position->DeleteDeltas();
     m_Position = m_CommitList.erase(m_Position);
     }
@@ -157,10 +265,11 @@ UndoDataManager<TPixel>
     }
 
   // Check whether we need to prune from the back to keep total size under control
+  size_t n_new_bytes = new_commit.GetSizeInBytes();
   CIterator itHead = m_CommitList.begin();
-  while(m_CommitList.size() > m_MinCommits && m_TotalSize + n_new_rles > m_MaxTotalSize)
+  while(m_CommitList.size() > m_MinCommits && m_TotalSize + n_new_bytes > m_MaxTotalSize)
     {
-    m_TotalSize -= itHead->GetNumberOfRLEs();
+    m_TotalSize -= itHead->GetSizeInBytes();
     itHead->DeleteDeltas();
     itHead = m_CommitList.erase(itHead);
     }
@@ -169,12 +278,32 @@ UndoDataManager<TPixel>
   // the current delta to it;
   m_CommitList.push_back(new_commit);
   m_Position = m_CommitList.end();
-  m_TotalSize += n_new_rles;
+  m_TotalSize += n_new_bytes;
 
   // Return the number of RLEs
   return n_new_rles;
 }
 
+template<typename TPixel>
+size_t
+UndoDataManager<TPixel>
+::PruneHistory(size_t nBytes)
+{
+  // Only commits before the current position (i.e., undo steps) are pruned,
+  // so the redo steps and the current position stay valid
+  size_t freed = 0;
+  CIterator itHead = m_CommitList.begin();
+  while(freed < nBytes && m_CommitList.size() > m_MinCommits && itHead != m_Position)
+    {
+    size_t n = itHead->GetSizeInBytes();
+    m_TotalSize -= n;
+    freed += n;
+    itHead->DeleteDeltas();
+    itHead = m_CommitList.erase(itHead);
+    }
+  return freed;
+}
+
 template<typename TPixel>
 bool
 UndoDataManager<TPixel>
@@ -263,3 +392,16 @@ UndoDataManager<TPixel>::Commit::GetNumberOfRLEs() const
     }
   return n;
 }
+
+template<typename TPixel>
+size_t
+UndoDataManager<TPixel>::Commit::GetSizeInBytes() const
+{
+  size_t n = 0;
+  for(DConstIterator dit = m_Deltas.begin(); dit != m_Deltas.end(); ++dit)
+    {
+    if(*dit)
+      n += (*dit)->GetSizeInBytes();
+    }
+  return n;
+}
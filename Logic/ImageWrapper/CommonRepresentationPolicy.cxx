@@ -70,6 +70,29 @@ CastingScalarImageWrapperCommonRepresentation<TOutputPixel, TWrapperTraits>
   return m_CastFilter[channel]->GetOutput();
 }
 
+template<class TOutputPixel, class TWrapperTraits>
+double
+CastingScalarImageWrapperCommonRepresentation<TOutputPixel, TWrapperTraits>
+::GetMemoryInMB() const
+{
+  size_t bytes = 0;
+  for(int i = 0; i < ScalarImageWrapperBase::CHANNEL_COUNT; i++)
+    {
+    const OutputImageType *output = m_CastFilter[i]->GetOutput();
+    if(output->GetPixelContainer())
+      bytes += output->GetPixelContainer()->Capacity() * sizeof(TOutputPixel);
+    }
+  return bytes / (1024.0 * 1024.0);
+}
+
+template<class TOutputPixel, class TWrapperTraits>
+void
+CastingScalarImageWrapperCommonRepresentation<TOutputPixel, TWrapperTraits>
+::ReleaseData(ScalarImageWrapperBase::ExportChannel channel)
+{
+  m_CastFilter[channel]->GetOutput()->ReleaseData();
+}
+
 template class CastingScalarImageWrapperCommonRepresentation<
     GreyType, GreyComponentImageWrapperTraits >;
 
@@ -26,6 +26,18 @@ public:
    * @see ScalarImageWrapperBase::GetCommonFormatImage
    */
   virtual const OutputImageType *GetOutput(ScalarImageWrapperBase::ExportChannel channel) = 0;
+
+  /**
+   * Memory allocated for the exported images that is not shared with the
+   * wrapped image, in megabytes
+   */
+  virtual double GetMemoryInMB() const = 0;
+
+  /**
+   * Release the memory allocated for an export channel. The channel is
+   * recomputed when its output is next updated.
+   */
+  virtual void ReleaseData(ScalarImageWrapperBase::ExportChannel channel) = 0;
 };
 
 /**
@@ -50,6 +62,11 @@ public:
 
   void UpdateInputImage(const InputImageType *image);
 
+  /** The output shares memory with the wrapped image */
+  double GetMemoryInMB() const { return 0.0; }
+
+  void ReleaseData(ScalarImageWrapperBase::ExportChannel) {}
+
 private:
   SmartPtr<const OutputImageType> m_Image;
 };
@@ -75,6 +92,10 @@ public:
 
   void UpdateInputImage(const InputImageType *image);
 
+  double GetMemoryInMB() const;
+
+  void ReleaseData(ScalarImageWrapperBase::ExportChannel channel);
+
 private:
   typedef itk::CastImageFilter<InputImageType, OutputImageType> CastFilterType;
   typedef SmartPtr<CastFilterType>                           CastFilterPointer;
@@ -102,6 +123,10 @@ public:
 
   void UpdateInputImage(const InputImageType *) {};
 
+  double GetMemoryInMB() const { return 0.0; }
+
+  void ReleaseData(ScalarImageWrapperBase::ExportChannel) {}
+
 };
 
 #endif // SCALARIMAGEWRAPPERCOMMONREPRESENTATION_H
@@ -0,0 +1,275 @@
+#include "DeferredTimePointReader.h"
+#include <itkImageIORegion.h>
+#include <algorithm>
+#include <cstring>
+
+DeferredTimePointReader::DeferredTimePointReader()
+{
+  m_Buffer = NULL;
+  m_BytesPerTimePoint = 0;
+  m_ChunkSize = 1;
+  m_NumberOfPending = 0;
+  m_ReadyFirst = 0;
+  m_ReadyCount = 0;
+  m_PrefetchCenter = 0;
+  m_StopPrefetch = false;
+}
+
+DeferredTimePointReader::~DeferredTimePointReader()
+{
+  // Let the background thread finish the chunk it is reading
+    {
+    std::lock_guard<std::mutex> lock(m_StateMutex);
+    m_StopPrefetch = true;
+    }
+  m_ReadyCondition.notify_all();
+  if(m_PrefetchThread.joinable())
+    m_PrefetchThread.join();
+}
+
+void
+DeferredTimePointReader
+::Initialize(itk::ImageIOBase *io,
+             void *buffer, itk::Object *buffer_owner,
+             size_t bytes_per_tp, unsigned int n_tp,
+             unsigned int loaded)
+{
+  m_IO = io;
+  m_Buffer = static_cast<char *>(buffer);
+  m_BufferOwner = buffer_owner;
+  m_BytesPerTimePoint = bytes_per_tp;
+
+  m_Loaded.assign(n_tp, false);
+  m_Loaded[loaded] = true;
+  m_NumberOfPending = n_tp - 1;
+  m_NewlyLoaded.clear();
+  m_ReadyData.clear();
+  m_ReadyCount = 0;
+}
+
+void
+DeferredTimePointReader
+::ReadTimePoints(unsigned int first, unsigned int count, char *target)
+{
+  itk::ImageIORegion region(4);
+  for(unsigned int d = 0; d < 3; d++)
+    {
+    region.SetIndex(d, 0);
+    region.SetSize(d, m_IO->GetDimensions(d));
+    }
+  region.SetIndex(3, first);
+  region.SetSize(3, count);
+
+  m_IO->SetIORegion(region);
+  m_IO->Read(target);
+}
+
+void
+DeferredTimePointReader
+::MarkLoaded(unsigned int first, unsigned int count)
+{
+  for(unsigned int tp = first; tp < first + count; tp++)
+    {
+    m_Loaded[tp] = true;
+    m_NewlyLoaded.push_back(tp);
+    }
+  m_NumberOfPending -= count;
+
+  // Nothing left to read: the file and the buffer can be let go of
+  if(m_NumberOfPending == 0)
+    {
+    m_IO = NULL;
+    m_BufferOwner = NULL;
+    }
+}
+
+void
+DeferredTimePointReader
+::CopyReadyChunk()
+{
+  if(m_ReadyCount == 0)
+    return;
+
+  // Time points in the chunk may have been read on demand in the meantime
+  for(unsigned int k = 0; k < m_ReadyCount; k++)
+    {
+    unsigned int tp = m_ReadyFirst + k;
+    if(!m_Loaded[tp])
+      {
+      memcpy(m_Buffer + tp * m_BytesPerTimePoint,
+             &m_ReadyData[k * m_BytesPerTimePoint], m_BytesPerTimePoint);
+      MarkLoaded(tp, 1);
+      }
+    }
+
+  // Let the background thread read the next chunk
+  std::vector<char>().swap(m_ReadyData);
+  m_ReadyCount = 0;
+  m_ReadyCondition.notify_all();
+}
+
+void
+DeferredTimePointReader
+::LoadTimePoint(unsigned int tp)
+{
+  if(IsTimePointLoaded(tp))
+    return;
+
+  // This waits for the background thread to finish its current chunk, which
+  // may well contain the time point
+  std::lock_guard<std::mutex> io_lock(m_IOMutex);
+  std::lock_guard<std::mutex> lock(m_StateMutex);
+  CopyReadyChunk();
+  if(!m_Loaded[tp])
+    {
+    ReadTimePoints(tp, 1, m_Buffer + tp * m_BytesPerTimePoint);
+    MarkLoaded(tp, 1);
+    }
+}
+
+void
+DeferredTimePointReader
+::LoadAllTimePoints()
+{
+  std::lock_guard<std::mutex> io_lock(m_IOMutex);
+  std::lock_guard<std::mutex> lock(m_StateMutex);
+  CopyReadyChunk();
+
+  // Read the remaining time points in as few requests as possible
+  unsigned int n_tp = m_Loaded.size();
+  for(unsigned int tp = 0; tp < n_tp; )
+    {
+    if(m_Loaded[tp])
+      {
+      ++tp;
+      continue;
+      }
+
+    unsigned int count = 1;
+    while(tp + count < n_tp && !m_Loaded[tp + count])
+      ++count;
+
+    ReadTimePoints(tp, count, m_Buffer + tp * m_BytesPerTimePoint);
+    MarkLoaded(tp, count);
+    tp += count;
+    }
+}
+
+bool
+DeferredTimePointReader
+::IsTimePointLoaded(unsigned int tp) const
+{
+  std::lock_guard<std::mutex> lock(m_StateMutex);
+  return m_Loaded[tp];
+}
+
+bool
+DeferredTimePointReader
+::IsComplete() const
+{
+  std::lock_guard<std::mutex> lock(m_StateMutex);
+  return m_NumberOfPending == 0;
+}
+
+std::vector<unsigned int>
+DeferredTimePointReader
+::PublishTimePoints()
+{
+  std::lock_guard<std::mutex> lock(m_StateMutex);
+  CopyReadyChunk();
+
+  std::vector<unsigned int> result;
+  result.swap(m_NewlyLoaded);
+  return result;
+}
+
+bool
+DeferredTimePointReader
+::FindPendingRange(unsigned int &first, unsigned int &count) const
+{
+  std::lock_guard<std::mutex> lock(m_StateMutex);
+  if(m_NumberOfPending == 0)
+    return false;
+
+  // Find the pending time point nearest to the center, preferring the
+  // ones after it since playback moves forward
+  int n_tp = (int) m_Loaded.size();
+  int center = std::min((int) m_PrefetchCenter, n_tp - 1);
+  for(int d = 0; d < n_tp; d++)
+    {
+    if(center + d < n_tp && !m_Loaded[center + d])
+      {
+      first = center + d;
+      break;
+      }
+    if(center - d >= 0 && !m_Loaded[center - d])
+      {
+      first = center - d;
+      break;
+      }
+    }
+
+  // Extend the range forward over the pending time points
+  count = 1;
+  while(count < m_ChunkSize && first + count < (unsigned int) n_tp && !m_Loaded[first + count])
+    ++count;
+
+  return true;
+}
+
+void
+DeferredTimePointReader
+::PrefetchLoop()
+{
+  unsigned int first = 0, count = 0;
+  while(true)
+    {
+    // Wait until the previous chunk has been copied into the image
+      {
+      std::unique_lock<std::mutex> lock(m_StateMutex);
+      m_ReadyCondition.wait(lock, [this] { return m_StopPrefetch || m_ReadyCount == 0; });
+      if(m_StopPrefetch)
+        return;
+      }
+
+    if(!FindPendingRange(first, count))
+      return;
+
+    std::lock_guard<std::mutex> io_lock(m_IOMutex);
+
+    // A time point in the range may have been read on demand in the meantime
+    while(count > 0 && IsTimePointLoaded(first))
+      { ++first; --count; }
+    for(unsigned int k = 1; k < count; k++)
+      if(IsTimePointLoaded(first + k))
+        count = k;
+    if(count == 0)
+      continue;
+
+    std::vector<char> data(count * m_BytesPerTimePoint);
+    try
+      {
+      ReadTimePoints(first, count, data.data());
+      }
+    catch(...)
+      {
+      // Leave the remaining time points to be read on demand, which will
+      // report the error to the caller
+      return;
+      }
+
+    std::lock_guard<std::mutex> lock(m_StateMutex);
+    m_ReadyData.swap(data);
+    m_ReadyFirst = first;
+    m_ReadyCount = count;
+    }
+}
+
+void
+DeferredTimePointReader
+::StartPrefetch(unsigned int center)
+{
+  m_PrefetchCenter = center;
+  if(!m_PrefetchThread.joinable() && !IsComplete())
+    m_PrefetchThread = std::thread(&DeferredTimePointReader::PrefetchLoop, this);
+}
@@ -0,0 +1,135 @@
+#ifndef DEFERREDTIMEPOINTREADER_H
+#define DEFERREDTIMEPOINTREADER_H
+
+#include <itkObject.h>
+#include <itkObjectFactory.h>
+#include <itkImageIOBase.h>
+#include <SNAPCommon.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+  Reads the time points of a 4D image file into an already allocated image
+  buffer after the image has been handed to the rest of the application.
+
+  GuidedNativeImageIO uses this class for long 4D series: only the first time
+  point is read when the image is loaded, so that it can be shown right away.
+  The other time points are read when they are first requested, or by a
+  background thread that reads them in the order of their distance from the
+  time point being viewed. Time points that have not been read yet are zero.
+
+  The background thread never writes to the image buffer. It reads a chunk of
+  time points into a private buffer and waits until PublishTimePoints() copies
+  the chunk into the image on the thread that uses the image.
+
+  The buffer holds all time points back to back. The reader keeps a reference
+  to the object that owns the buffer, so the buffer stays valid as long as
+  there are time points left to read.
+  */
+class DeferredTimePointReader : public itk::Object
+{
+public:
+  irisITKObjectMacro(DeferredTimePointReader, itk::Object)
+
+  /**
+    Set up the reader. The IO object must have read the image information
+    already. The time points are each bytes_per_tp long in the buffer. The
+    time points listed in loaded have already been read.
+    */
+  void Initialize(itk::ImageIOBase *io,
+                  void *buffer, itk::Object *buffer_owner,
+                  size_t bytes_per_tp, unsigned int n_tp,
+                  unsigned int loaded);
+
+  /**
+    Maximum number of time points read in one request by the background
+    thread. This also bounds the memory held by the private buffer.
+    */
+  irisGetSetMacro(ChunkSize, unsigned int)
+
+  /**
+    Read a time point into the image now if it has not been read yet. Like
+    the methods below that write to the image, this must be called from the
+    thread that uses the image.
+    */
+  void LoadTimePoint(unsigned int tp);
+
+  /** Read all the time points that have not been read yet */
+  void LoadAllTimePoints();
+
+  /** Check whether a time point has been read */
+  bool IsTimePointLoaded(unsigned int tp) const;
+
+  /** Check whether all time points have been read */
+  bool IsComplete() const;
+
+  /**
+    Start reading the remaining time points in the background, nearest to
+    the given time point first. Does nothing if the thread is running.
+    */
+  void StartPrefetch(unsigned int center);
+
+  /** Update the time point around which the background thread reads */
+  void SetPrefetchCenter(unsigned int center)
+    { m_PrefetchCenter = center; }
+
+  /**
+    Copy the time points read by the background thread into the image, and
+    get all the time points that have been read since the last call to this
+    method, so that the images referencing them can be marked as modified.
+    */
+  std::vector<unsigned int> PublishTimePoints();
+
+protected:
+  DeferredTimePointReader();
+  virtual ~DeferredTimePointReader();
+
+  // Read a range of time points from the file. Caller must hold m_IOMutex
+  void ReadTimePoints(unsigned int first, unsigned int count, char *target);
+
+  // Copy the chunk read in the background into the image and mark its time
+  // points as read. Caller must hold m_StateMutex
+  void CopyReadyChunk();
+
+  // Mark a range of time points as read. Caller must hold m_StateMutex
+  void MarkLoaded(unsigned int first, unsigned int count);
+
+  // Find the next range of time points for the background thread
+  bool FindPendingRange(unsigned int &first, unsigned int &count) const;
+
+  // Body of the background thread
+  void PrefetchLoop();
+
+  SmartPtr<itk::ImageIOBase> m_IO;
+  SmartPtr<itk::Object> m_BufferOwner;
+  char *m_Buffer;
+  size_t m_BytesPerTimePoint;
+  unsigned int m_ChunkSize;
+
+  // Which time points have been read, and which of them are new
+  std::vector<bool> m_Loaded;
+  std::vector<unsigned int> m_NewlyLoaded;
+  unsigned int m_NumberOfPending;
+
+  // Chunk read by the background thread that has not been copied yet
+  std::vector<char> m_ReadyData;
+  unsigned int m_ReadyFirst, m_ReadyCount;
+
+  // The IO mutex serializes file access, the state mutex protects the flags
+  // and the ready chunk. The background thread waits on the condition until
+  // the ready chunk has been copied
+  std::mutex m_IOMutex;
+  mutable std::mutex m_StateMutex;
+  std::condition_variable m_ReadyCondition;
+
+  // Background reading
+  std::thread m_PrefetchThread;
+  std::atomic<unsigned int> m_PrefetchCenter;
+  std::atomic<bool> m_StopPrefetch;
+};
+
+#endif // DEFERREDTIMEPOINTREADER_H
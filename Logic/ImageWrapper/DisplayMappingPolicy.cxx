@@ -15,6 +15,7 @@
 #include "itkUnaryFunctorImageFilter.h"
 #include "InputSelectionImageFilter.h"
 #include "Rebroadcaster.h"
+#include <algorithm>
 
 /* ===============================================================
     ColorLabelTableDisplayMappingPolicy implementation
@@ -69,6 +70,17 @@ ColorLabelTableDisplayMappingPolicy<TWrapperTraits>
   return m_RGBAFilter[slice]->GetOutput();
 }
 
+template<class TWrapperTraits>
+bool
+ColorLabelTableDisplayMappingPolicy<TWrapperTraits>
+::GetDisplaySliceMappingMTime(unsigned int slice, itk::ModifiedTimeType &mtime)
+{
+  mtime = m_RGBAFilter[slice]->GetMTime();
+  if(ColorLabelTable *table = m_RGBAFilter[slice]->GetColorTable())
+    mtime = std::max(mtime, table->GetMTime());
+  return true;
+}
+
 template<class TWrapperTraits>
 typename ColorLabelTableDisplayMappingPolicy<TWrapperTraits>::DisplayPixelType
 ColorLabelTableDisplayMappingPolicy<TWrapperTraits>
@@ -254,6 +266,23 @@ CachingCurveAndColorMapDisplayMappingPolicy<TWrapperTraits>
   return m_IntensityFilter[dim]->GetOutput();
 }
 
+template<class TWrapperTraits>
+bool
+CachingCurveAndColorMapDisplayMappingPolicy<TWrapperTraits>
+::GetDisplaySliceMappingMTime(unsigned int dim, itk::ModifiedTimeType &mtime)
+{
+  // The lookup table depends on the curve, the color map and the intensity
+  // range. Its image input only matters through the range, so it is skipped
+  mtime = std::max(m_IntensityFilter[dim]->GetMTime(), m_LookupTableFilter->GetMTime());
+  mtime = std::max(mtime, m_IntensityCurveVTK->GetMTime());
+  mtime = std::max(mtime, m_ColorMap->GetMTime());
+  if(m_LookupTableFilter->GetImageMinInput())
+    mtime = std::max(mtime, m_LookupTableFilter->GetImageMinInput()->GetMTime());
+  if(m_LookupTableFilter->GetImageMaxInput())
+    mtime = std::max(mtime, m_LookupTableFilter->GetImageMaxInput()->GetMTime());
+  return true;
+}
+
 template<class TWrapperTraits>
 ColorMap *
 CachingCurveAndColorMapDisplayMappingPolicy<TWrapperTraits>
@@ -489,6 +518,15 @@ LinearColorMapDisplayMappingPolicy<TWrapperTraits>
   return m_Filter[slice]->GetOutput();
 }
 
+template <class TWrapperTraits>
+bool
+LinearColorMapDisplayMappingPolicy<TWrapperTraits>
+::GetDisplaySliceMappingMTime(unsigned int slice, itk::ModifiedTimeType &mtime)
+{
+  mtime = std::max(m_Filter[slice]->GetMTime(), m_ColorMap->GetMTime());
+  return true;
+}
+
 
 template <class TWrapperTraits>
 inline typename LinearColorMapDisplayMappingPolicy<TWrapperTraits>::DisplayPixelType
@@ -765,6 +803,41 @@ MultiChannelDisplayMappingPolicy<TWrapperTraits>
   return m_DisplaySliceSelector[slice]->GetOutput();
 }
 
+template <class TWrapperTraits>
+bool
+MultiChannelDisplayMappingPolicy<TWrapperTraits>
+::GetDisplaySliceMappingMTime(unsigned int slice, itk::ModifiedTimeType &mtime)
+{
+  if(!m_DisplaySliceSelector[slice])
+    return false;
+
+  // The selector is modified when the display mode changes, which keeps the
+  // slices of different components apart even when they share a curve
+  mtime = std::max(this->GetMTime(), m_DisplaySliceSelector[slice]->GetMTime());
+
+  if(m_ScalarRepresentation)
+    {
+    itk::ModifiedTimeType rep_mtime;
+    if(!m_ScalarRepresentation->GetDisplayMapping()->GetDisplaySliceMappingMTime(slice, rep_mtime))
+      return false;
+    mtime = std::max(mtime, rep_mtime);
+    }
+  else if(m_RGBMapper[slice])
+    {
+    mtime = std::max(mtime, m_RGBMapper[slice]->GetMTime());
+    mtime = std::max(mtime, m_LUTGenerator->GetMTime());
+    mtime = std::max(mtime, m_LUTGenerator->GetIntensityCurve()->GetMTime());
+    mtime = std::max(mtime, m_Wrapper->GetImageMinObject()->GetMTime());
+    mtime = std::max(mtime, m_Wrapper->GetImageMaxObject()->GetMTime());
+    }
+  else
+    {
+    return false;
+    }
+
+  return true;
+}
+
 template <class TWrapperTraits>
 IntensityCurveInterface *
 MultiChannelDisplayMappingPolicy<TWrapperTraits>
@@ -38,6 +38,15 @@ public:
 
   virtual DisplaySlicePointer GetDisplaySlice(unsigned int slice) = 0;
 
+  /**
+   * Get the latest modified time of the filters, curves, color maps and
+   * tables that the display slice depends on, not counting the slicer and
+   * the image data. Returns false if the policy can not tell, in which case
+   * the display slices are not cached by the wrapper.
+   */
+  virtual bool GetDisplaySliceMappingMTime(unsigned int slice, itk::ModifiedTimeType &mtime)
+    { return false; }
+
   virtual void Save(Registry &folder) = 0;
   virtual void Restore(Registry &folder) = 0;
 };
@@ -94,6 +103,8 @@ public:
 
   DisplaySlicePointer GetDisplaySlice(unsigned int slice) ITK_OVERRIDE;
 
+  bool GetDisplaySliceMappingMTime(unsigned int slice, itk::ModifiedTimeType &mtime) ITK_OVERRIDE;
+
   virtual IntensityCurveInterface *GetIntensityCurve() const ITK_OVERRIDE { return NULL; }
   virtual ColorMap *GetColorMap() const ITK_OVERRIDE { return NULL; }
 
@@ -234,6 +245,8 @@ public:
    */
   DisplaySlicePointer GetDisplaySlice(unsigned int dim) ITK_OVERRIDE;
 
+  bool GetDisplaySliceMappingMTime(unsigned int dim, itk::ModifiedTimeType &mtime) ITK_OVERRIDE;
+
   /**
     Get a pointer to the colormap
     */
@@ -366,6 +379,8 @@ public:
 
   virtual DisplaySlicePointer GetDisplaySlice(unsigned int slice) ITK_OVERRIDE;
 
+  bool GetDisplaySliceMappingMTime(unsigned int slice, itk::ModifiedTimeType &mtime) ITK_OVERRIDE;
+
   virtual IntensityCurveInterface *GetIntensityCurve() const ITK_OVERRIDE { return NULL; }
 
   virtual void Save(Registry &folder) ITK_OVERRIDE;
@@ -452,6 +467,8 @@ public:
 
   DisplaySlicePointer GetDisplaySlice(unsigned int slice) ITK_OVERRIDE;
 
+  bool GetDisplaySliceMappingMTime(unsigned int slice, itk::ModifiedTimeType &mtime) ITK_OVERRIDE;
+
   Vector2d GetNativeImageRangeForCurve() ITK_OVERRIDE;
   virtual const ScalarImageHistogram *GetHistogram(int nBins) ITK_OVERRIDE;
 
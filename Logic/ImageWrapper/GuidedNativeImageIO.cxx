@@ -311,6 +311,7 @@ GuidedNativeImageIO
   m_NativeFileName = "";
   m_NativeByteOrder = itk::ImageIOBase::OrderNotApplicable;
   m_NativeSizeInBytes = 0;
+  m_DeferTimePointLoading = false;
 }
 
 GuidedNativeImageIO::FileFormat 
@@ -476,6 +477,9 @@ GuidedNativeImageIO
   // Save the hints
   m_Hints = folder;
 
+  // Any time points of a previous image no longer concern this object
+  m_DeferredTimePointReader = NULL;
+
   // Create the header corresponding to the current image type
   CreateImageIO(FileName, m_Hints, true);
   if(!m_IOBase)
@@ -1232,7 +1236,18 @@ GuidedNativeImageIO
     region.SetSize(dim);
     image->SetRegions(region);
     image->SetVectorLength(ncomp);
-    image->Allocate();
+
+    // A 4D series can be read one time point at a time if the format allows
+    // reading part of the file. Only the first time point is read here, and
+    // the others are left zero until the deferred reader gets to them.
+    // Compressed files have to be decompressed from the start for every
+    // request, so they are read in full right away
+    std::string ext = itksys::SystemTools::GetFilenameLastExtension(m_NativeFileName);
+    bool compressed = m_IOBase->GetUseCompression()
+        || itksys::SystemTools::LowerCase(ext) == ".gz";
+    bool defer = m_DeferTimePointLoading && nd_actual == 4 && dim[3] > 1
+        && m_IOBase->CanStreamRead() && !compressed;
+    image->Allocate(defer);
 
 		regularImageReadingProgSrc->AddProgress(0.05);
 
@@ -1240,8 +1255,12 @@ GuidedNativeImageIO
     if(nd_actual <= 4)
       {
       // This is the old code, which we preserve
+      typename NativeImageType::RegionType readRegion = region;
+      if(defer)
+        readRegion.SetSize(3, 1);
+
       itk::ImageIORegion ioRegion(4);
-      itk::ImageIORegionAdaptor<4>::Convert(region, ioRegion, index);
+      itk::ImageIORegionAdaptor<4>::Convert(readRegion, ioRegion, index);
       m_IOBase->SetIORegion(ioRegion);
       }
     else
@@ -1265,6 +1284,22 @@ GuidedNativeImageIO
 		m_IOBase->Read(image->GetBufferPointer());
     m_NativeImage = image;
 
+    // Hand the rest of the time points to the deferred reader
+    if(defer)
+      {
+      size_t bytes_per_tp = dim[0] * dim[1] * dim[2] * ncomp * sizeof(TScalar);
+
+      m_DeferredTimePointReader = DeferredTimePointReader::New();
+      m_DeferredTimePointReader->Initialize(
+            m_IOBase, image->GetBufferPointer(), image->GetPixelContainer(),
+            bytes_per_tp, dim[3], 0);
+
+      // The background thread reads chunks of about 64MB, so that a request
+      // for a specific time point never waits for long
+      m_DeferredTimePointReader->SetChunkSize(
+            std::max((size_t) 1, (size_t) (64 << 20) / bytes_per_tp));
+      }
+
 		regularImageReadingProgSrc->AddProgress(0.9);
 
 
@@ -1334,6 +1369,10 @@ void
 GuidedNativeImageIO
 ::SaveNativeImage(const char *FileName, Registry &folder)
 {
+  // The native image must be complete
+  if(m_DeferredTimePointReader)
+    m_DeferredTimePointReader->LoadAllTimePoints();
+
   // Cast image from native format to TPixel
   DispatchBase *dispatch = this->CreateDispatch(this->GetComponentTypeInNativeImage());
   dispatch->SaveNative(this, FileName, folder);
@@ -1384,6 +1423,10 @@ GuidedNativeImageIO
 {
   std::string md5;
 
+  // The native image must be complete
+  if(m_DeferredTimePointReader)
+    m_DeferredTimePointReader->LoadAllTimePoints();
+
   // Cast image from native format to TPixel
   DispatchBase *dispatch = this->CreateDispatch(this->GetComponentTypeInNativeImage());
   md5 = dispatch->GetNativeMD5Hash(this);
@@ -1434,6 +1477,10 @@ RescaleNativeImageToIntegralType<TOutputImage>::operator()(
   // Get the native image pointer
   auto *native = nativeIO->GetNativeImage();
 
+  // Deferred time points only have to be read now if the cast has to look
+  // at the data, otherwise the output shares the buffer they are read into
+  m_DeferredReader = nativeIO->GetDeferredTimePointReader();
+
   // Cast image from native format to TPixel
   itk::ImageIOBase::IOComponentType itype = nativeIO->GetComponentTypeInNativeImage();
   switch(itype) 
@@ -1562,6 +1609,10 @@ RescaleNativeImageToIntegralType<TOutputImage>
   // Only bother with computing the scale and shift if the types are different
   if(typeid(OutputComponentType) != typeid(TNative))
     {
+    // The range must be computed over all time points
+    if(m_DeferredReader)
+      m_DeferredReader->LoadAllTimePoints();
+
     // We must compute the range of the input data    
     OutputComponentType omax = itk::NumericTraits<OutputComponentType>::max();
     OutputComponentType omin = itk::NumericTraits<OutputComponentType>::min();
@@ -1677,6 +1728,10 @@ CastNativeImage<TOutputImage,TCastFunctor>
   // Get the native image pointer
   itk::ImageBase<4> *native = nativeIO->GetNativeImage();
 
+  // The cast may not share the native buffer, so all time points are needed
+  if(nativeIO->GetDeferredTimePointReader())
+    nativeIO->GetDeferredTimePointReader()->LoadAllTimePoints();
+
   // Cast image from native format to TPixel
   itk::ImageIOBase::IOComponentType itype = nativeIO->GetComponentTypeInNativeImage();
   switch(itype) 
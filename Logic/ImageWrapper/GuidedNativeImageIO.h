@@ -44,6 +44,7 @@
 #include "itkEventObject.h"
 #include "gdcmTag.h"
 #include "MultiFrameDicomSeriesSorter.h"
+#include "DeferredTimePointReader.h"
 
 
 namespace itk
@@ -146,6 +147,27 @@ public:
 
 	void ReadNativeImageData(itk::Command *progressCmd = nullptr);
 
+  /**
+   * Request that ReadNativeImageData() only read the first time point of a
+   * 4D image. The remaining time points are left to the reader returned by
+   * GetDeferredTimePointReader(), and are zero until they are read. This is
+   * only honored for uncompressed single-file 4D images whose format supports
+   * reading part of the file; other images are read completely.
+   */
+  void SetDeferTimePointLoading(bool flag)
+    { m_DeferTimePointLoading = flag; }
+
+  bool GetDeferTimePointLoading() const
+    { return m_DeferTimePointLoading; }
+
+  /**
+   * The reader for the time points not read by ReadNativeImageData(), or
+   * NULL if the image was read completely. Anyone needing all of the native
+   * image data must call LoadAllTimePoints() on it first.
+   */
+  DeferredTimePointReader *GetDeferredTimePointReader() const
+    { return m_DeferredTimePointReader; }
+
   /**
    * Get the number of components in the native image read by ReadNativeImage.
    */
@@ -217,7 +239,7 @@ public:
    * the format of interest.
    */
   void DeallocateNativeImage()
-    { m_IOBase = NULL; m_NativeImage = NULL; }
+    { m_IOBase = NULL; m_NativeImage = NULL; m_DeferredTimePointReader = NULL; }
 
   /** 
    * Get RAI code for an image. If there is nothing in the registry, this will
@@ -356,6 +378,12 @@ protected:
   // The IO base used to read the files
   IOBasePointer m_IOBase;
 
+  // Whether the time points of 4D images may be read after the first one
+  bool m_DeferTimePointLoading;
+
+  // Reader for the time points that were not read with the image
+  SmartPtr<DeferredTimePointReader> m_DeferredTimePointReader;
+
   // DICOM directory last processed by ParseDicomSeries
   DicomDirectoryParseResult m_LastDicomParseResult;
 
@@ -415,7 +443,7 @@ template<class TOutputImage>
 class RescaleNativeImageToIntegralType
 {
 public:
-  RescaleNativeImageToIntegralType() {}
+  RescaleNativeImageToIntegralType() : m_DeferredReader(NULL) {}
   virtual ~RescaleNativeImageToIntegralType() {}
 
   typedef TOutputImage                                         OutputImageType;
@@ -437,6 +465,9 @@ private:
   typename OutputImageType::Pointer m_Output;
   double m_NativeScale, m_NativeShift;
 
+  // Time points of the native image that may still have to be read
+  DeferredTimePointReader *m_DeferredReader;
+
   // Method that does the casting
   template<typename TNative> void DoCast(NativeImageType *native);
 };
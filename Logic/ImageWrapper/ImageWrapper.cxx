@@ -49,6 +49,8 @@
 #include "itkRegionOfInterestImageFilter.h"
 #include "itkIdentityTransform.h"
 #include "AdaptiveSlicingPipeline.h"
+#include "TimePointSlicePrefetcher.h"
+#include "ImagePyramid.h"
 #include "SNAPSegmentationROISettings.h"
 #include "itkCommand.h"
 #include "ImageCoordinateGeometry.h"
@@ -56,6 +58,7 @@
 #include <itkResampleImageFilter.h>
 #include <itkIdentityTransform.h>
 #include <itkFlipImageFilter.h>
+#include <itkBinShrinkImageFilter.h>
 #include <itkUnaryFunctorImageFilter.h>
 #include "ImageWrapperTraits.h"
 #include "itkNearestNeighborInterpolateImageFunction.h"
@@ -144,6 +147,7 @@ public:
   typedef itk::ImageBase<TImage::ImageDimension> ImageBaseType;
   typedef itk::Transform<double, TImage::ImageDimension, TImage::ImageDimension> TransformType;
   typedef TImage4D Image4DType;
+  typedef itk::FixedArray<unsigned int, TImage::ImageDimension> ShrinkFactors;
 
   static void FillBuffer(ImageType *image, PixelType itkNotUsed(value))
   {
@@ -216,6 +220,19 @@ public:
                         image_4d->GetNameOfClass());
   }
 
+  // Adaptors do not own any pixel data, they read it from the adapted image
+  static size_t GetMemoryFootprint(Image4DType *itkNotUsed(image_4d))
+  {
+    return 0;
+  }
+
+  // Images whose values can not be averaged (labels) are not downsampled
+  static typename ImageType::Pointer DownsampleImage(ImageType *itkNotUsed(image),
+                                                     const ShrinkFactors &itkNotUsed(factors))
+  {
+    return NULL;
+  }
+
   /*
   template <typename TPixel>
   static void UpdateImportPointer(Image4DType *image_4d,
@@ -375,6 +392,24 @@ public:
     image_4d->SetPixelContainer(container);
   }
 
+  static size_t GetMemoryFootprint(Image4DType *image_4d)
+  {
+    typedef typename Image4DType::PixelContainer PixelContainer;
+    const PixelContainer *pc = image_4d->GetPixelContainer();
+    return pc ? pc->Capacity() * sizeof(typename PixelContainer::Element) : 0;
+  }
+
+  static typename ImageType::Pointer DownsampleImage(ImageType *image,
+                                                     const typename Superclass::ShrinkFactors &factors)
+  {
+    typedef itk::BinShrinkImageFilter<ImageType, ImageType> ShrinkFilter;
+    SmartPtr<ShrinkFilter> filter = ShrinkFilter::New();
+    filter->SetInput(image);
+    filter->SetShrinkFactors(factors);
+    filter->Update();
+    return filter->GetOutput();
+  }
+
   /*
   template <class TPixel>
   static void UpdateImportPointer(Image4DType *image_4d,
@@ -719,6 +754,11 @@ public:
   {
     image_4d->GetBuffer()->SetPixelContainer(image_tp->GetBuffer()->GetPixelContainer());
   }  
+
+  static size_t GetMemoryFootprint(Image4DType *image_4d)
+  {
+    return image_4d->GetMemoryFootprint();
+  }
 };
 
 /**
@@ -845,6 +885,15 @@ ImageWrapper<TTraits,TBase>
   m_DisplayMapping = DisplayMapping::New();
   m_DisplayMapping->Initialize(static_cast<typename DisplayMapping::WrapperType *>(this));
 
+  // The display slices are handed out through caches, which pass them
+  // through until SetDisplaySliceCacheMemory() is called
+  for(unsigned int i = 0; i < 3; i++)
+    {
+    m_DisplaySliceCaches[i] = DisplaySliceCacheType::New();
+    m_DisplaySliceCaches[i]->SetKeyFunction(
+          [this, i](DisplaySliceKey &key) { return this->GetDisplaySliceKey(i, key); });
+    }
+
   // Set sticky flag
   m_Sticky = TTraits::StickyByDefault;
 
@@ -852,6 +901,9 @@ ImageWrapper<TTraits,TBase>
   // that are derived from vector wrappers. See VectorImageWrapper::CreateDerivedWrapper
   m_ParentWrapper = NULL;
 
+  // The image pyramid, when it is turned on, is used by the slicers
+  m_FullResolutionSlicing = false;
+
   // Update the image geometry to default value
   this->UpdateImageGeometry();
 }
@@ -872,6 +924,8 @@ ImageWrapper<TTraits,TBase>
   // If the source contains an image, make a copy of that image
   if (copy.IsInitialized() && copy.GetImage())
     {
+    copy.RequireAllTimePoints();
+
     typedef itk::RegionOfInterestImageFilter<Image4DType, Image4DType> roiType;
     typename roiType::Pointer roi = roiType::New();
     roi->SetInput(copy.m_Image4D);
@@ -1020,6 +1074,43 @@ ImageWrapper<TTraits,TBase>
   return m_ImageBase->GetBufferedRegion().GetNumberOfPixels();
 }
 
+template<class TTraits, class TBase>
+double
+ImageWrapper<TTraits,TBase>
+::GetImageMemoryInMB() const
+{
+  // Derived wrappers (components, magnitude, etc.) share the parent's data
+  if(!m_Initialized || m_ParentWrapper)
+    return 0.0;
+
+  typedef ImageWrapperPartialSpecializationTraits<ImageType, Image4DType> Specialization;
+  return Specialization::GetMemoryFootprint(m_Image4D) / (1024.0 * 1024.0);
+}
+
+template<class TTraits, class TBase>
+double
+ImageWrapper<TTraits,TBase>
+::GetDerivedDataMemoryInMB() const
+{
+  size_t bytes = m_ImagePyramid ? m_ImagePyramid->GetMemoryFootprint() : 0;
+  for(unsigned int i = 0; i < 3; i++)
+    bytes += m_DisplaySliceCaches[i]->GetMemoryFootprint();
+  return bytes / (1024.0 * 1024.0);
+}
+
+template<class TTraits, class TBase>
+void
+ImageWrapper<TTraits,TBase>
+::ReleaseDerivedData()
+{
+  // Levels are recomputed when the slice is next drawn zoomed out
+  if(m_ImagePyramid)
+    m_ImagePyramid->ReleaseLevels();
+
+  for(unsigned int i = 0; i < 3; i++)
+    m_DisplaySliceCaches[i]->ReleaseSlices();
+}
+
 template<class TTraits, class TBase>
 Vector3d
 ImageWrapper<TTraits,TBase>
@@ -1241,8 +1332,13 @@ ImageWrapper<TTraits,TBase>
     ImageBaseType *referenceSpace,
     ITKTransformType *transform)
 {
-  // Assign the pointer to the 4D image
+  // Stop slicing the old time points before their buffer may be released
+  m_SlicePrefetcher = NULL;
+
+  // Assign the pointer to the 4D image. The new image is read completely
+  // unless a deferred reader is assigned afterwards
   m_Image4D = image_4d;
+  m_DeferredTimePointReader = NULL;
 
   // The time dimension is the last dimension
   unsigned int nt = image_4d->GetBufferedRegion().GetSize()[3];
@@ -1281,6 +1377,11 @@ ImageWrapper<TTraits,TBase>
     m_Slicers[i]->SetPreviewImage(nullptr);
     }
 
+  // Levels of the old image are of no use. Time series are not downsampled
+  // because the levels would have to be recomputed for every time point
+  if(m_ImagePyramid)
+    m_ImagePyramid->SetImage(nt == 1 ? m_ImageTimePoints[0].GetPointer() : NULL);
+
   // Mark the image as Modified to enforce correct sequence of
   // operations with MinMaxCalc
   m_Image4D->Modified();
@@ -1288,6 +1389,10 @@ ImageWrapper<TTraits,TBase>
   // Update the image in the display mapping
   m_DisplayMapping->UpdateImagePointer(m_Image);
 
+  // The display mapping may have set up new pipelines for the display slices
+  for(unsigned int i = 0; i < 3; i++)
+    m_DisplaySliceCaches[i]->SetUpstreamSlice(m_DisplayMapping->GetDisplaySlice(i));
+
   // Update the time point select filter, so that m_Image and m_ImageBase have the right
   // spatial information. This has to be done before the call to SetITKTransform()
   m_TimePointSelectFilter->Update();
@@ -1387,6 +1492,10 @@ ImageWrapper<TTraits,TBase>
   // Get the referenced time point
   if(time_point < 0)
     time_point = m_TimePointIndex;
+
+  // The time point must not be read from disk over the new data later
+  RequireTimePoint(time_point);
+
   ImageType *idest = m_ImageTimePoints[time_point];
 
   itkAssertOrThrowMacro(
@@ -1404,7 +1513,9 @@ ImageWrapper<TTraits,TBase>
     }
 
   // Set modification (we are not keeping track of number of updated voxels because of
-  // potential added overhead
+  // potential added overhead. The updated time point need not be the current one,
+  // so it is marked as well
+  m_ImageTimePoints[time_point]->Modified();
   PixelsModified();
 }
 
@@ -1501,6 +1612,9 @@ ImageWrapper<TTraits,TBase>
     m_ImageTimePoints.clear();
     m_ImageBase = NULL;
     m_Image = NULL;
+
+    for(unsigned int i = 0; i < 3; i++)
+      m_DisplaySliceCaches[i]->ReleaseSlices();
     }
   m_Initialized = false;
 
@@ -1529,8 +1643,9 @@ ImageWrapper<TTraits,TBase>
   // Update the pixel
   m_Image->SetPixel(index, value);
 
-  // The 4D image must receive the modified event
+  // The 4D image must receive the modified event, as must the time point
   m_Image4D->Modified();
+  m_ImageTimePoints[m_TimePointIndex]->Modified();
 }
 
 template<class TTraits, class TBase>
@@ -1544,6 +1659,7 @@ ImageWrapper<TTraits,TBase>
 
   if(time_point < 0)
     time_point = m_TimePointIndex;
+  RequireTimePoint(time_point);
 
   // Simply use ITK's GetPixel method
   return m_ImageTimePoints[time_point]->GetPixel(index);
@@ -1590,6 +1706,12 @@ ImageWrapper<TTraits,TBase>
 ::SampleIntensityAtReferenceIndexInternal(
     const itk::Index<3> &index, unsigned int tp_begin, unsigned int tp_end) const
 {
+  // Sampling the whole time series reads all of it in as few requests as possible
+  if(tp_end > tp_begin + 1)
+    RequireAllTimePoints();
+  else
+    RequireTimePoint(tp_begin);
+
   // Compute and allocate output dimensions
   unsigned int nc = this->GetNumberOfComponents();
   unsigned int nt = this->GetNumberOfTimePoints();
@@ -1709,6 +1831,15 @@ ImageWrapper<TTraits,TBase>
         index < m_ImageTimePoints.size(),
         "Requested time point out of range")
 
+  // Read the time point if it is not in memory yet, and have the background
+  // reading continue around it
+  if(m_DeferredTimePointReader)
+    {
+    m_DeferredTimePointReader->SetPrefetchCenter(index);
+    RequireTimePoint(index);
+    UpdateDeferredTimePoints();
+    }
+
   // Set the current time index
   if(index != m_TimePointIndex)
     {
@@ -1717,9 +1848,85 @@ ImageWrapper<TTraits,TBase>
     // Update the image selector
     m_TimePointSelectFilter->SetSelectedInput(index);
     m_TimePointSelectFilter->Update();
+
+    // Hand the slices computed in the background to the slicers
+    if(m_SlicePrefetcher)
+      {
+      for(unsigned int i = 0; i < 3; i++)
+        {
+        typename SlicePrefetcherType::SliceState state;
+        if(SlicePrefetcherType::GetSliceState(
+             m_Slicers[i], GetTimePointDataMTime(index), state))
+          {
+          SlicePointer slice = m_SlicePrefetcher->TakeSlice(index, i, state);
+          if(slice)
+            m_Slicers[i]->SetPrecomputedSlice(slice);
+          }
+        }
+      }
     }
 }
 
+template<class TTraits, class TBase>
+void
+ImageWrapper<TTraits,TBase>
+::PrefetchTimePointSlices(unsigned int n_ahead)
+{
+  unsigned int nt = m_ImageTimePoints.size();
+  if(n_ahead == 0 || nt < 2)
+    {
+    m_SlicePrefetcher = NULL;
+    return;
+    }
+
+  if(!m_SlicePrefetcher)
+    m_SlicePrefetcher = SlicePrefetcherType::New();
+
+  // The time points that come next during replay
+  std::vector<unsigned int> upcoming;
+  for(unsigned int k = 1; k <= n_ahead && k < nt; k++)
+    upcoming.push_back((m_TimePointIndex + k) % nt);
+  m_SlicePrefetcher->Retain(upcoming);
+
+  typedef ImageWrapperPartialSpecializationTraits<ImageType, Image4DType> Specialization;
+  for(unsigned int tp : upcoming)
+    {
+    // Time points still being read from disk are skipped for now
+    if(m_DeferredTimePointReader && !m_DeferredTimePointReader->IsTimePointLoaded(tp))
+      continue;
+
+    // The view of the time point is created only if some slice needs it
+    ImagePointer view;
+    for(unsigned int i = 0; i < 3; i++)
+      {
+      typename SlicePrefetcherType::SliceState state;
+      if(!SlicePrefetcherType::GetSliceState(m_Slicers[i], GetTimePointDataMTime(tp), state)
+         || m_SlicePrefetcher->HasRequest(tp, i, state))
+        continue;
+
+      // The background pipeline gets its own view of the time point, so that
+      // it does not share the image object with the time point selector
+      if(!view)
+        {
+        view = ImageType::New();
+        Specialization::ConfigureTimePointImageFromImage4D(m_Image4D, view.GetPointer(), tp);
+        }
+
+      m_SlicePrefetcher->Request(tp, i, state, m_Slicers[i], view);
+      }
+    }
+}
+
+template<class TTraits, class TBase>
+itk::ModifiedTimeType
+ImageWrapper<TTraits,TBase>
+::GetTimePointDataMTime(unsigned int tp) const
+{
+  // Edits mark the time point that they change as modified, so edits to
+  // one time point leave the slices of the others valid
+  return m_ImageTimePoints[tp]->GetMTime();
+}
+
 template<class TTraits, class TBase>
 const typename ImageWrapper<TTraits, TBase>::ImagePointer
 ImageWrapper<TTraits, TBase>::GetImageByTimePoint(unsigned int timepoint) const
@@ -1728,9 +1935,76 @@ ImageWrapper<TTraits, TBase>::GetImageByTimePoint(unsigned int timepoint) const
         timepoint < m_ImageTimePoints.size(),
         "Requested time point out of range")
 
+  RequireTimePoint(timepoint);
   return m_ImageTimePoints[timepoint];
 }
 
+template<class TTraits, class TBase>
+void
+ImageWrapper<TTraits, TBase>
+::SetDeferredTimePointReader(DeferredTimePointReader *reader)
+{
+  if(reader && !reader->IsComplete())
+    {
+    m_DeferredTimePointReader = reader;
+    RequireTimePoint(m_TimePointIndex);
+    reader->StartPrefetch(m_TimePointIndex);
+    }
+  else
+    {
+    m_DeferredTimePointReader = NULL;
+    }
+}
+
+template<class TTraits, class TBase>
+void
+ImageWrapper<TTraits, TBase>
+::RequireTimePoint(unsigned int tp) const
+{
+  if(m_DeferredTimePointReader)
+    m_DeferredTimePointReader->LoadTimePoint(tp);
+}
+
+template<class TTraits, class TBase>
+void
+ImageWrapper<TTraits, TBase>
+::RequireAllTimePoints() const
+{
+  if(m_DeferredTimePointReader)
+    m_DeferredTimePointReader->LoadAllTimePoints();
+}
+
+template<class TTraits, class TBase>
+void
+ImageWrapper<TTraits, TBase>
+::UpdateDeferredTimePoints()
+{
+  if(!m_DeferredTimePointReader)
+    return;
+
+  // Copy the time points read in the background into the image
+  std::vector<unsigned int> tps = m_DeferredTimePointReader->PublishTimePoints();
+  if(m_DeferredTimePointReader->IsComplete())
+    m_DeferredTimePointReader = NULL;
+
+  if(tps.size())
+    {
+    // Reading the image from disk does not make for unsaved changes
+    bool saved = !this->HasUnsavedChanges();
+
+    // Filters that use these time points (min/max, histogram) must update
+    for(unsigned int tp : tps)
+      m_ImageTimePoints[tp]->Modified();
+    m_Image4D->Modified();
+
+    if(saved)
+      m_ImageSaveTime = m_Image4D->GetTimeStamp();
+
+    // The intensity range and the histogram now include the new time points
+    this->InvokeEvent(WrapperHistogramChangeEvent());
+    }
+}
+
 template<class TTraits, class TBase>
 void
 ImageWrapper<TTraits,TBase>
@@ -1748,6 +2022,103 @@ ImageWrapper<TTraits,TBase>
   return m_Slicers[index]->GetObliqueReferenceImage();
 }
 
+template<class TTraits, class TBase>
+void
+ImageWrapper<TTraits,TBase>
+::SetUseImagePyramid(bool flag)
+{
+  if(flag && !m_ImagePyramid)
+    {
+    typedef ImageWrapperPartialSpecializationTraits<ImageType, Image4DType> Specialization;
+    SmartPtr<ImagePyramidType> pyramid = ImagePyramidType::New();
+    pyramid->SetDownsampleFunction(&Specialization::DownsampleImage);
+    this->SetImagePyramid(pyramid);
+    }
+  else if(!flag)
+    {
+    this->SetImagePyramid(NULL);
+    }
+}
+
+template<class TTraits, class TBase>
+void
+ImageWrapper<TTraits,TBase>
+::SetImagePyramid(ImagePyramidType *pyramid)
+{
+  m_ImagePyramid = pyramid;
+  if(m_ImagePyramid && m_Initialized && m_ImageTimePoints.size() == 1)
+    m_ImagePyramid->SetImage(m_ImageTimePoints[0]);
+
+  for(unsigned int i = 0; i < 3; i++)
+    m_Slicers[i]->SetImagePyramid(m_FullResolutionSlicing ? NULL : pyramid);
+}
+
+template<class TTraits, class TBase>
+bool
+ImageWrapper<TTraits,TBase>
+::GetUseImagePyramid() const
+{
+  return m_ImagePyramid.GetPointer() != NULL;
+}
+
+template<class TTraits, class TBase>
+void
+ImageWrapper<TTraits,TBase>
+::SetFullResolutionSlicing(bool flag)
+{
+  m_FullResolutionSlicing = flag;
+  for(unsigned int i = 0; i < 3; i++)
+    m_Slicers[i]->SetImagePyramid(flag ? NULL : m_ImagePyramid.GetPointer());
+}
+
+template<class TTraits, class TBase>
+bool
+ImageWrapper<TTraits,TBase>
+::GetFullResolutionSlicing() const
+{
+  return m_FullResolutionSlicing;
+}
+
+template<class TTraits, class TBase>
+void
+ImageWrapper<TTraits,TBase>
+::SetDisplaySliceCacheMemory(size_t bytes)
+{
+  for(unsigned int i = 0; i < 3; i++)
+    m_DisplaySliceCaches[i]->SetMaximumMemory(bytes);
+}
+
+template<class TTraits, class TBase>
+size_t
+ImageWrapper<TTraits,TBase>
+::GetDisplaySliceCacheMemory() const
+{
+  return m_DisplaySliceCaches[0]->GetMaximumMemory();
+}
+
+template<class TTraits, class TBase>
+bool
+ImageWrapper<TTraits,TBase>
+::GetDisplaySliceKey(unsigned int dim, DisplaySliceKey &key)
+{
+  // Oblique slices change with every pan and zoom, and previews change
+  // without the image being modified, so neither is cached
+  SlicerType *slicer = m_Slicers[dim];
+  if(!m_Initialized || !slicer->GetUseOrthogonalSlicing()
+     || slicer->GetPreviewImage() || !slicer->GetOrthogonalTransform())
+    return false;
+
+  if(!m_DisplayMapping->GetDisplaySliceMappingMTime(dim, key.Mapping))
+    return false;
+
+  // Only the position of the cursor along the slice axis matters
+  key.SliceIndex = slicer->GetSliceIndex()[this->GetDisplaySliceImageAxis(dim)];
+  key.TimePoint = m_TimePointIndex;
+  key.Data = this->GetTimePointDataMTime(m_TimePointIndex);
+  key.Transform = slicer->GetOrthogonalTransform()->GetMTime();
+  return true;
+}
+
 
 template<class TTraits, class TBase>
 void
@@ -1838,6 +2209,11 @@ void ImageWrapper<TTraits, TBase>
         container->Size() == m_Image4D->GetPixelContainer()->Size(),
         "Source array size does not match target array size in SetPixelContainer");
 
+  // The old buffer is being replaced, so there is no use reading into it
+  // or slicing it
+  m_DeferredTimePointReader = NULL;
+  m_SlicePrefetcher = NULL;
+
   typedef ImageWrapperPartialSpecializationTraits<ImageType, Image4DType> Specialization;
   Specialization::UpdatePixelContainer(m_Image4D, container);
   for(unsigned int tp = 0; tp < m_ImageTimePoints.size(); tp++)
@@ -1965,7 +2341,7 @@ template<class TTraits, class TBase>
 typename ImageWrapper<TTraits,TBase>::DisplaySlicePointer
 ImageWrapper<TTraits,TBase>::GetDisplaySlice(unsigned int dim)
 {
-  return m_DisplayMapping->GetDisplaySlice(dim);
+  return m_DisplaySliceCaches[dim]->GetOutput();
 }
 
 template<class TTraits, class TBase>
@@ -2028,6 +2404,8 @@ void
 ImageWrapper<TTraits,TBase>
 ::WriteToFileInInternalFormat(const char *filename, Registry &hints)
 {
+  RequireAllTimePoints();
+
   typedef ImageWrapperPartialSpecializationTraits<ImageType, Image4DType> Specialization;
 
   // Write either in 4D or in 3D
@@ -2043,6 +2421,9 @@ void
 ImageWrapper<TTraits,TBase>
 ::WriteToFile(const char *filename, Registry &hints)
 {
+  // All of the time points are written
+  RequireAllTimePoints();
+
   // What kind of mapping are we using
   if(this->GetNativeMapping().IsIdentity())
     {
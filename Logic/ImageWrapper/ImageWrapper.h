@@ -52,9 +52,15 @@ template <class TFunctor> class UnaryValueToValueFilter;
 template <class TInputImage, class TOutputImage, class TTraits>
 class AdaptiveSlicingPipeline;
 
+template <class TInputImage, class TOutputImage, class TPreviewImage>
+class TimePointSlicePrefetcher;
+
+template <class TImage> class ImagePyramid;
+
 template <class TInputImage, class TTag> class InputSelectionImageFilter;
 
 class SNAPSegmentationROISettings;
+class DeferredTimePointReader;
 
 namespace itk {
   template <unsigned int VDimension> class ImageBase;
@@ -69,6 +75,7 @@ namespace itk {
 }
 
 #include <itkImageSource.h>
+#include "DisplaySliceCache.h"
 
 
 
@@ -131,6 +138,10 @@ public:
   // Slicer type
   typedef AdaptiveSlicingPipeline<ImageType, SliceType, PreviewImageType> SlicerType;
   typedef SmartPtr<SlicerType>                                   SlicerPointer;
+  typedef TimePointSlicePrefetcher<ImageType, SliceType, PreviewImageType> SlicePrefetcherType;
+  typedef ImagePyramid<ImageType>                            ImagePyramidType;
+  typedef DisplaySliceCache<DisplaySliceType>           DisplaySliceCacheType;
+  typedef typename DisplaySliceCacheType::SliceKey            DisplaySliceKey;
 
   // Preview source for preview pipelines
   typedef itk::ImageSource<PreviewImageType>                 PreviewFilterType;
@@ -402,12 +413,39 @@ public:
   /** Set the current time index */
   virtual void SetTimePointIndex(unsigned int index) ITK_OVERRIDE;
 
+  /** Compute the slices of the next time points in the background */
+  virtual void PrefetchTimePointSlices(unsigned int n_ahead) ITK_OVERRIDE;
+
+  /** Copy the time points read from disk in the background into the image */
+  virtual void UpdateDeferredTimePoints() ITK_OVERRIDE;
+
+  /** Wrappers without a histogram have nothing to refine */
+  virtual void UpdateRefinedHistogram() ITK_OVERRIDE {}
+
   const ImageBaseType* GetDisplayViewportGeometry(unsigned int index) const;
 
   virtual void SetDisplayViewportGeometry(
       unsigned int index,
       const ImageBaseType *viewport_image) ITK_OVERRIDE;
 
+  /** Slice downsampled copies of the image when zoomed out */
+  virtual void SetUseImagePyramid(bool flag) ITK_OVERRIDE;
+  virtual bool GetUseImagePyramid() const ITK_OVERRIDE;
+
+  /**
+   * Slice the levels of the given pyramid when zoomed out, rather than those
+   * of a pyramid of this wrapper's own. This lets wrappers that adapt the
+   * image of another wrapper share its pyramid. NULL turns the pyramid off.
+   */
+  void SetImagePyramid(ImagePyramidType *pyramid);
+
+  virtual void SetFullResolutionSlicing(bool flag) ITK_OVERRIDE;
+  virtual bool GetFullResolutionSlicing() const ITK_OVERRIDE;
+
+  /** Keep recently shown display slices of each view */
+  virtual void SetDisplaySliceCacheMemory(size_t bytes) ITK_OVERRIDE;
+  virtual size_t GetDisplaySliceCacheMemory() const ITK_OVERRIDE;
+
   /**
    * Get an ITK pipeline object holding the minimum value in the image. For
    * multi-component images, this is the minimum value over all components.
@@ -440,6 +478,17 @@ public:
   /** Number of voxels */
   virtual size_t GetNumberOfVoxels() const ITK_OVERRIDE;
 
+  /** Get the memory used by the image data (all time points) */
+  virtual double GetImageMemoryInMB() const ITK_OVERRIDE;
+
+  /** Get the memory used by derived representations, i.e., the image pyramid
+   * and the cached display slices */
+  virtual double GetDerivedDataMemoryInMB() const ITK_OVERRIDE;
+
+  /** Release derived representations, i.e., the image pyramid and the
+   * cached display slices */
+  virtual void ReleaseDerivedData() ITK_OVERRIDE;
+
   /**
    * Pring debugging info
    * TODO: Delete this or make is worthwhile
@@ -652,6 +701,14 @@ public:
     */
   virtual const ImagePointer GetImageByTimePoint(unsigned int timepoint) const;
 
+  /**
+   * Assign the reader for the time points of the 4D image that have not been
+   * read from disk yet (see GuidedNativeImageIO::SetDeferTimePointLoading).
+   * Time points are read when they are selected or sampled, and in the
+   * background starting with the neighbours of the current time point.
+   */
+  void SetDeferredTimePointReader(DeferredTimePointReader *reader);
+
 
   /** Write timepoint image to file */
   void WriteCurrentTPImageToFile(const char *filename);
@@ -726,6 +783,32 @@ protected:
   /** The current time point (index into m_ImageTimePoints) */
   unsigned int m_TimePointIndex = 0;
 
+  /** Reader for the time points that have not been read from disk yet */
+  SmartPtr<DeferredTimePointReader> m_DeferredTimePointReader;
+
+  /** Make sure that a time point, or all of them, have been read from disk */
+  void RequireTimePoint(unsigned int tp) const;
+  void RequireAllTimePoints() const;
+
+
+  /** Slices of upcoming time points computed in the background */
+  SmartPtr<SlicePrefetcherType> m_SlicePrefetcher;
+
+  /** Modified time of the image data of a time point */
+  itk::ModifiedTimeType GetTimePointDataMTime(unsigned int tp) const;
+
+  /** Downsampled copies of the image for slicing when zoomed out */
+  SmartPtr<ImagePyramidType> m_ImagePyramid;
+
+  /** Whether the slicers ignore the pyramid for now */
+  bool m_FullResolutionSlicing;
+
+  /** Recently shown display slices of each view */
+  std::array<SmartPtr<DisplaySliceCacheType>, 3> m_DisplaySliceCaches;
+
+  /** Describe the state that the display slice of a view depends on */
+  bool GetDisplaySliceKey(unsigned int dim, DisplaySliceKey &key);
+
   /**
    * Is the image wrapper initialized? That is a prerequisite for all
    * operations.
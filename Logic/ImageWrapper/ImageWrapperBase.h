@@ -189,6 +189,30 @@ public:
   /** Set the current time index */
   virtual void SetTimePointIndex(unsigned int index) = 0;
 
+  /**
+   * Extract the slices of the next n_ahead time points (following the current
+   * one, wrapping around) in the background, so that only the intensity
+   * mapping is left to do when these time points are selected during 4D
+   * replay. Passing zero releases the slices
+   */
+  virtual void PrefetchTimePointSlices(unsigned int n_ahead) = 0;
+
+  /**
+   * If the time points of the image are still being read from disk (see
+   * GuidedNativeImageIO::SetDeferTimePointLoading), copy the ones read in the
+   * background into the image and mark them as modified. Fires the histogram
+   * change event, since the intensity range takes in the new time points.
+   */
+  virtual void UpdateDeferredTimePoints() = 0;
+
+  /**
+   * If the histogram of a large image was estimated from a sample (see
+   * ThreadedHistogramImageFilter::SetSamplingThreshold) and the exact
+   * histogram has since been computed in the background, place it in the
+   * histogram and fire the histogram change event.
+   */
+  virtual void UpdateRefinedHistogram() = 0;
+
   /**
    * Set the viewport rectangle onto which the three display slices
    * will be rendered
@@ -197,6 +221,32 @@ public:
       unsigned int index,
       const ImageBaseType *viewport_image) = 0;
 
+  /**
+   * Slice downsampled copies of the image, computed on demand, when the
+   * viewport is zoomed out so far that a screen pixel covers several voxels.
+   * Only available for 3D images with a single time point and intensities
+   * that can be averaged; otherwise the full-resolution image is sliced
+   */
+  virtual void SetUseImagePyramid(bool flag) = 0;
+  virtual bool GetUseImagePyramid() const = 0;
+
+  /**
+   * Slice the full-resolution image even if the image pyramid is in use, e.g.
+   * to export a slice. Unlike turning the pyramid off, this keeps the levels
+   * that have been computed.
+   */
+  virtual void SetFullResolutionSlicing(bool flag) = 0;
+  virtual bool GetFullResolutionSlicing() const = 0;
+
+  /**
+   * Keep the most recently shown display slices of each view, up to the given
+   * number of bytes per view, so that going back to a slice or a time point
+   * that was just shown does not slice the image and map the intensities
+   * again. Zero disables the cache. The slices count as derived data.
+   */
+  virtual void SetDisplaySliceCacheMemory(size_t bytes) = 0;
+  virtual size_t GetDisplaySliceCacheMemory() const = 0;
+
 
   /** Return some image info independently of pixel type */
   irisVirtualGetMacro(ImageBase, ImageBaseType *)
@@ -301,6 +351,26 @@ public:
   /** Get the number of components per voxel */
   virtual size_t GetNumberOfComponents() const = 0;
 
+  /**
+   * Get the memory used by the image data of this wrapper, i.e., all of its
+   * time points, in megabytes. Derived wrappers (components, magnitude, etc.)
+   * share the data of their parent and report zero.
+   */
+  virtual double GetImageMemoryInMB() const = 0;
+
+  /**
+   * Get the memory used by representations derived from the image data that
+   * can be regenerated on demand, such as images cast to the common format for
+   * whole-image and preview pipelines, in megabytes.
+   */
+  virtual double GetDerivedDataMemoryInMB() const = 0;
+
+  /**
+   * Release the derived representations counted by GetDerivedDataMemoryInMB().
+   * They are recomputed by the pipeline the next time they are requested.
+   */
+  virtual void ReleaseDerivedData() = 0;
+
   /**
    * Sample image intensity at a 4D position in the reference space. If the reference
    * space does not match the native space, the intensity will be interpolated based
@@ -43,6 +43,7 @@
 #include "LabelImageWrapper.h"
 #include "UndoDataManager.h"
 #include "Rebroadcaster.h"
+#include "itkImageRegionConstIterator.h"
 
 LabelImageWrapper::LabelImageWrapper()
 {
@@ -65,10 +66,15 @@ void LabelImageWrapper::UpdateWrappedImages(
   for(auto p : m_TimePointUndoManagers)
     delete p;
 
-  // Set up new undo managers
+  // Set up new undo managers, keeping at least four undo points and up to
+  // about 3 MB of undo data per time point
   m_TimePointUndoManagers.resize(this->GetNumberOfTimePoints());
   for(auto &p : m_TimePointUndoManagers)
-    p = new UndoManagerType(4, 200000);
+    p = new UndoManagerType(4, 3200000);
+
+  // Voxel counts will be computed when first requested
+  m_TimePointLabelCounts.clear();
+  m_TimePointLabelCounts.resize(this->GetNumberOfTimePoints());
 
   // Modified event on the image is rebroadcast as the WrapperImageChangeEvent
   Rebroadcaster::Rebroadcast(image_4d, itk::ModifiedEvent(), this, WrapperImageChangeEvent());
@@ -94,6 +100,9 @@ void LabelImageWrapper::StoreUndoPoint(const char *text, UndoManagerDelta *delta
 
   // Commit the deltas
   um->CommitStaging(text);
+
+  // Let the application check the memory held by the undo history
+  this->InvokeEvent(SegmentationUndoPointEvent());
 }
 
 void LabelImageWrapper::ClearUndoPoints()
@@ -121,35 +130,16 @@ void LabelImageWrapper::Undo()
   // Get the commit for the undo
   const UndoManagerType::Commit &commit = um->GetCommitForUndo();
 
-  // The label image that will undergo undo
-  typedef itk::ImageRegionIterator<ImageType> IteratorType;
+  // Keep track of the label voxel counts
+  LabelVoxelCountDelta count_delta;
 
   // Iterate over all the deltas in reverse order
   UndoManagerType::DList::const_reverse_iterator dit = commit.GetDeltas().rbegin();
   for(; dit != commit.GetDeltas().rend(); ++dit)
-    {
-    // Apply the changes in the current delta
-    UndoManagerType::Delta *delta = *dit;
-
-    // Iterator for the relevant region in the label image
-    IteratorType lit(m_Image, delta->GetRegion());
-
-    // Iterate over the rles in the delta
-    for(size_t i = 0; i < delta->GetNumberOfRLEs(); i++)
-      {
-      size_t n = delta->GetRLELength(i);
-      LabelType d = delta->GetRLEValue(i);
-      for(size_t j = 0; j < n; j++)
-        {
-        if(d != 0)
-          lit.Set(lit.Get() - d);
-        ++lit;
-        }
-      }
-    }
+    this->ApplyUndoDelta(*dit, false, count_delta);
 
   // Set modified flags
-  this->PixelsModified();
+  this->PixelsModified(count_delta);
 }
 
 bool LabelImageWrapper::IsRedoPossible()
@@ -165,35 +155,54 @@ void LabelImageWrapper::Redo()
   // Get the commit for the redo
   const UndoManagerType::Commit &commit = um->GetCommitForRedo();
 
-  // The label image that will undergo redo
-  typedef itk::ImageRegionIterator<ImageType> IteratorType;
+  // Keep track of the label voxel counts
+  LabelVoxelCountDelta count_delta;
 
-  // Iterate over all the deltas in reverse order
+  // Iterate over all the deltas in forward order
   UndoManagerType::DList::const_iterator dit = commit.GetDeltas().begin();
   for(; dit != commit.GetDeltas().end(); ++dit)
-    {
-    // Apply the changes in the current delta
-    UndoManagerType::Delta *delta = *dit;
+    this->ApplyUndoDelta(*dit, true, count_delta);
 
-    // Iterator for the relevant region in the label image
-    IteratorType lit(m_Image, delta->GetRegion());
+  // Set modified flags
+  this->PixelsModified(count_delta);
+}
 
-    // Iterate over the rles in the delta
-    for(size_t i = 0; i < delta->GetNumberOfRLEs(); i++)
+void
+LabelImageWrapper
+::ApplyUndoDelta(UndoManagerDelta *delta, bool redo, LabelVoxelCountDelta &count_delta)
+{
+  // Iterator for the relevant region in the label image
+  typedef itk::ImageRegionIterator<ImageType> IteratorType;
+  const UndoManagerDelta::RegionType &region = delta->GetRegion();
+  IteratorType lit(m_Image, region);
+
+  // The runs cover the region in iteration order. Runs of unchanged voxels
+  // are skipped by moving the iterator to the start of the next changed run,
+  // so the work is proportional to the number of changed voxels
+  itk::SizeValueType nx = region.GetSize(0), ny = region.GetSize(1);
+  itk::SizeValueType offset = 0;
+  for(UndoManagerDelta::RunIterator rit(delta); !rit.IsAtEnd(); ++rit)
+    {
+    size_t n = rit.GetLength();
+    LabelType d = redo ? rit.GetValue() : LabelType(0 - rit.GetValue());
+    if(d != 0)
       {
-      size_t n = delta->GetRLELength(i);
-      LabelType d = delta->GetRLEValue(i);
-      for(size_t j = 0; j < n; j++)
+      IndexType idx = region.GetIndex();
+      idx[0] += offset % nx;
+      idx[1] += (offset / nx) % ny;
+      idx[2] += offset / (nx * ny);
+      lit.SetIndex(idx);
+
+      for(size_t j = 0; j < n; j++, ++lit)
         {
-        if(d != 0)
-          lit.Set(lit.Get() + d);
-        ++lit;
+        LabelType lOld = lit.Get();
+        LabelType lNew = lOld + d;
+        lit.Set(lNew);
+        count_delta.RecordChange(lOld, lNew);
         }
       }
+    offset += n;
     }
-
-  // Set modified flags
-  this->PixelsModified();
 }
 
 const
@@ -204,6 +213,34 @@ LabelImageWrapper
   return m_TimePointUndoManagers[m_TimePointIndex];
 }
 
+double
+LabelImageWrapper
+::GetUndoMemoryInMB() const
+{
+  double mb = 0.0;
+  for(unsigned int i = 0; i < m_TimePointUndoManagers.size(); i++)
+    mb += m_TimePointUndoManagers[i]->GetTotalMemoryInMB();
+  return mb;
+}
+
+double
+LabelImageWrapper
+::PruneUndoHistory(double mbToFree)
+{
+  size_t target = (size_t) (mbToFree * 1024.0 * 1024.0), freed = 0;
+
+  // Other time points are pruned first, since the user is less likely to
+  // undo edits there than in the time point being edited
+  for(unsigned int i = 0; i < m_TimePointUndoManagers.size() && freed < target; i++)
+    if(i != m_TimePointIndex)
+      freed += m_TimePointUndoManagers[i]->PruneHistory(target - freed);
+
+  if(freed < target && m_TimePointIndex < m_TimePointUndoManagers.size())
+    freed += m_TimePointUndoManagers[m_TimePointIndex]->PruneHistory(target - freed);
+
+  return freed / (1024.0 * 1024.0);
+}
+
 LabelImageWrapper::UndoManagerDelta *
 LabelImageWrapper::CompressImage() const
 {
@@ -216,3 +253,143 @@ LabelImageWrapper::CompressImage() const
   new_cumulative->FinishEncoding();
   return new_cumulative;
 }
+
+
+bool
+LabelImageWrapper::IsLabelVoxelCountIndexCurrent() const
+{
+  const LabelVoxelCountIndex &index = m_TimePointLabelCounts[m_TimePointIndex];
+  return index.Valid
+      && index.ImageMTime == m_ImageTimePoints[m_TimePointIndex]->GetMTime();
+}
+
+void
+LabelImageWrapper::UpdateLabelVoxelCountIndex()
+{
+  if(this->IsLabelVoxelCountIndexCurrent())
+    return;
+
+  LabelVoxelCountIndex &index = m_TimePointLabelCounts[m_TimePointIndex];
+  index.Counts.clear();
+
+  // Walk over the runs in the RLE buffer rather than over individual voxels
+  const ImageType *img = m_ImageTimePoints[m_TimePointIndex];
+  typedef ImageType::BufferType BufferType;
+  itk::ImageRegionConstIterator<BufferType> itLine(
+        img->GetBuffer(), img->GetBuffer()->GetBufferedRegion());
+
+  // Cache the entry to avoid many calls to std::map
+  LabelType runLabel = 0;
+  unsigned long *cachedCount = &index.Counts[runLabel];
+  for(; !itLine.IsAtEnd(); ++itLine)
+    {
+    const ImageType::RLLine &line = itLine.Value();
+    for(size_t i = 0; i < line.size(); i++)
+      {
+      if(line[i].second != runLabel)
+        {
+        runLabel = line[i].second;
+        cachedCount = &index.Counts[runLabel];
+        }
+      *cachedCount += line[i].first;
+      }
+    }
+
+  // The clear label may not actually be present
+  if(index.Counts[0] == 0)
+    index.Counts.erase(0);
+
+  index.ImageMTime = img->GetMTime();
+  index.Valid = true;
+}
+
+unsigned long
+LabelImageWrapper::GetNumberOfVoxelsWithLabel(LabelType label)
+{
+  this->UpdateLabelVoxelCountIndex();
+  const LabelVoxelCountMap &counts = m_TimePointLabelCounts[m_TimePointIndex].Counts;
+  LabelVoxelCountMap::const_iterator it = counts.find(label);
+  return it == counts.end() ? 0 : it->second;
+}
+
+bool
+LabelImageWrapper::IsLabelPresent(LabelType label)
+{
+  return this->GetNumberOfVoxelsWithLabel(label) > 0;
+}
+
+const LabelImageWrapper::LabelVoxelCountMap &
+LabelImageWrapper::GetLabelVoxelCounts()
+{
+  this->UpdateLabelVoxelCountIndex();
+  return m_TimePointLabelCounts[m_TimePointIndex].Counts;
+}
+
+void
+LabelImageWrapper::PixelsModified(LabelVoxelCountDelta &delta)
+{
+  // Only an index that was current before the update can be patched
+  bool current = this->IsLabelVoxelCountIndexCurrent();
+
+  // Set the modified flags
+  this->PixelsModified();
+
+  if(current)
+    {
+    LabelVoxelCountIndex &index = m_TimePointLabelCounts[m_TimePointIndex];
+    const LabelVoxelCountDelta::ChangeMap &changes = delta.GetChanges();
+    for(LabelVoxelCountDelta::ChangeMap::const_iterator it = changes.begin();
+        it != changes.end(); ++it)
+      {
+      if(it->second == 0)
+        continue;
+
+      unsigned long &count = index.Counts[it->first];
+      count += it->second;
+      if(count == 0)
+        index.Counts.erase(it->first);
+      }
+
+    index.ImageMTime = m_ImageTimePoints[m_TimePointIndex]->GetMTime();
+    }
+}
+
+unsigned int
+LabelImageWrapper::ReplaceIntensity(PixelType iOld, PixelType iNew)
+{
+  bool current = this->IsLabelVoxelCountIndexCurrent();
+  unsigned int nReplaced = Superclass::ReplaceIntensity(iOld, iNew);
+
+  if(current)
+    {
+    LabelVoxelCountIndex &index = m_TimePointLabelCounts[m_TimePointIndex];
+    if(iOld != iNew && nReplaced > 0)
+      {
+      index.Counts[iNew] += nReplaced;
+      index.Counts.erase(iOld);
+      }
+    index.ImageMTime = m_ImageTimePoints[m_TimePointIndex]->GetMTime();
+    }
+
+  return nReplaced;
+}
+
+unsigned int
+LabelImageWrapper::SwapIntensities(PixelType iFirst, PixelType iSecond)
+{
+  bool current = this->IsLabelVoxelCountIndexCurrent();
+  unsigned int nReplaced = Superclass::SwapIntensities(iFirst, iSecond);
+
+  if(current && iFirst != iSecond)
+    {
+    LabelVoxelCountIndex &index = m_TimePointLabelCounts[m_TimePointIndex];
+    unsigned long nFirst = index.Counts[iFirst], nSecond = index.Counts[iSecond];
+    index.Counts[iFirst] = nSecond;
+    index.Counts[iSecond] = nFirst;
+    if(nSecond == 0) index.Counts.erase(iFirst);
+    if(nFirst == 0) index.Counts.erase(iSecond);
+    index.ImageMTime = m_ImageTimePoints[m_TimePointIndex]->GetMTime();
+    }
+
+  return nReplaced;
+}
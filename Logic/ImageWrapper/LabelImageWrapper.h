@@ -3,11 +3,74 @@
 
 #include "ImageWrapperTraits.h"
 #include "ScalarImageWrapper.h"
+#include <map>
 
 template <typename TPixel> class UndoDataManager;
 template <typename TPixel> class UndoDelta;
 class SegmentationUpdateIterator;
 
+/**
+ * \class LabelVoxelCountDelta
+ * \brief Accumulates the change in per-label voxel counts during an update
+ * of a segmentation image.
+ *
+ * Changes between the same pair of labels are usually reported in long
+ * sequences (e.g., when filling a region), so they are batched and only
+ * written to the map when the pair changes.
+ */
+class LabelVoxelCountDelta
+{
+public:
+  typedef std::map<LabelType, long> ChangeMap;
+
+  LabelVoxelCountDelta()
+    : m_PendingFrom(0), m_PendingTo(0), m_PendingCount(0) {}
+
+  /** Record that n voxels changed from label 'from' to label 'to' */
+  void RecordChange(LabelType from, LabelType to, unsigned long n = 1)
+  {
+    if(from == to || n == 0)
+      return;
+
+    if(m_PendingCount > 0 && (from != m_PendingFrom || to != m_PendingTo))
+      this->Flush();
+
+    m_PendingFrom = from;
+    m_PendingTo = to;
+    m_PendingCount += n;
+  }
+
+  /** Get the accumulated changes, keyed by label */
+  const ChangeMap &GetChanges()
+  {
+    this->Flush();
+    return m_Changes;
+  }
+
+  /** Discard all recorded changes */
+  void Clear()
+  {
+    m_Changes.clear();
+    m_PendingCount = 0;
+  }
+
+protected:
+
+  void Flush()
+  {
+    if(m_PendingCount > 0)
+      {
+      m_Changes[m_PendingFrom] -= m_PendingCount;
+      m_Changes[m_PendingTo] += m_PendingCount;
+      m_PendingCount = 0;
+      }
+  }
+
+  ChangeMap m_Changes;
+  LabelType m_PendingFrom, m_PendingTo;
+  unsigned long m_PendingCount;
+};
+
 class LabelImageWrapper : public ScalarImageWrapper<LabelImageWrapperTraits>
 {
 public:
@@ -31,6 +94,9 @@ public:
   typedef UndoDataManager<PixelType> UndoManagerType;
   typedef UndoDelta<PixelType>       UndoManagerDelta;
 
+  // Number of voxels with each label that is present in the image
+  typedef std::map<LabelType, unsigned long> LabelVoxelCountMap;
+
   // We are friends with the SegmentationUpdateIterator
   friend class SegmentationUpdateIterator;
 
@@ -77,12 +143,51 @@ public:
   /** Get the undo manager */
   const UndoManagerType *GetUndoManager() const;
 
+  /** Memory held by the undo managers of all time points, in megabytes */
+  double GetUndoMemoryInMB() const;
+
+  /**
+   * Discard the oldest undo points until at least the given amount of memory
+   * has been freed. The current time point is pruned last. Returns the
+   * amount of memory freed, in megabytes.
+   */
+  double PruneUndoHistory(double mbToFree);
+
   /** This is not used by the undo system itself, but uses the undo code to
    * store the contents of the image as an undo delta object, which can then
    * be stored in memory compactly. The caller is responsible for deleting the
    * array created in this call. */
   UndoManagerDelta *CompressImage() const;
 
+  /**
+   * Get the number of voxels with the given label in the current time point.
+   * The counts are computed from the RLE runs the first time they are needed
+   * and are then maintained incrementally by the segmentation update code.
+   */
+  unsigned long GetNumberOfVoxelsWithLabel(LabelType label);
+
+  /** Check whether any voxels in the current time point have the given label */
+  bool IsLabelPresent(LabelType label);
+
+  /** Get the voxel counts for all labels present in the current time point */
+  const LabelVoxelCountMap &GetLabelVoxelCounts();
+
+  /** Set the modified flags without any knowledge of what voxels changed. */
+  using Superclass::PixelsModified;
+
+  /**
+   * Set the modified flags after an update whose effect on the label voxel
+   * counts is known. This keeps the voxel count index current without having
+   * to rescan the image.
+   */
+  void PixelsModified(LabelVoxelCountDelta &delta);
+
+  /** Replace label, keeping the voxel count index current */
+  virtual unsigned int ReplaceIntensity(PixelType iOld, PixelType iNew) ITK_OVERRIDE;
+
+  /** Swap labels, keeping the voxel count index current */
+  virtual unsigned int SwapIntensities(PixelType iFirst, PixelType iSecond) ITK_OVERRIDE;
+
 protected:
 
   LabelImageWrapper();
@@ -93,6 +198,29 @@ protected:
   // undo steps with little cost in performance or memory. We currently associate each time
   // point with its own undo manager
   std::vector<UndoManagerType *> m_TimePointUndoManagers;
+
+  // Add (redo) or subtract (undo) a delta from the current time point. Only
+  // the voxels that the delta changes are visited
+  void ApplyUndoDelta(UndoManagerDelta *delta, bool redo, LabelVoxelCountDelta &count_delta);
+
+  // Voxel counts for a single time point. The counts are valid as long as
+  // the time point image has not been modified since they were computed.
+  struct LabelVoxelCountIndex
+  {
+    LabelVoxelCountMap Counts;
+    itk::ModifiedTimeType ImageMTime;
+    bool Valid;
+    LabelVoxelCountIndex() : ImageMTime(0), Valid(false) {}
+  };
+
+  // Voxel count index for each time point
+  std::vector<LabelVoxelCountIndex> m_TimePointLabelCounts;
+
+  // Check if the voxel count index for the current time point is current
+  bool IsLabelVoxelCountIndexCurrent() const;
+
+  // Recompute the voxel count index for the current time point if needed
+  void UpdateLabelVoxelCountIndex();
 };
 
 #endif // LABELIMAGEWRAPPER_H
@@ -24,6 +24,9 @@
 #include <itkRGBAPixel.h>
 #include <itkNumericTraitsRGBAPixel.h>
 
+#include <algorithm>
+#include <cstring>
+
 /**
  * \class LabelToRGBAFilter
  * \brief Simple filter that maps label image to RGB color image
@@ -92,33 +95,45 @@ protected:
       outputPtr->Allocate();
       }
 
-    // Get the clear label
-    const ColorLabel &clear = m_ColorTable->GetColorLabel(0);
-    const ColorLabel *cllast = &clear;
-
-    // Keep track of the last pixel - this reduces the amount of color label
-    // lookups, taking advantage of the fact that segmentations are homogeneous
-    InputPixelType last_pixel = 0;
+    // Display colors of all the label values
+    const uint32_t *colors = m_ColorTable->GetDisplayColorArray();
 
-    // Simple loop
+    // Segmentation slices consist of long runs of the same label, so rather
+    // than mapping each pixel, find where each run ends and fill the whole
+    // span with the color of its label
     const LabelType *xin = inputPtr->GetBufferPointer(), *xinend = xin + n;
-    OutputPixelType *xout = outputPtr->GetBufferPointer();
-    for(; xin < xinend; ++xin, ++xout)
+    uint32_t *xout = reinterpret_cast<uint32_t *>(outputPtr->GetBufferPointer());
+    while(xin < xinend)
       {
-      if(*xin != last_pixel)
-        {
-        last_pixel = *xin;
-        const ColorLabel &cl = m_ColorTable->GetColorLabel(last_pixel);
-        if(cl.IsVisible())
-          cllast = &cl;
-        else
-          cllast = &clear;
-        }
-
-      cllast->GetRGBAVector(xout->GetDataPointer());
+      const LabelType *xrun = FindRunEnd(xin, xinend);
+      xout = std::fill_n(xout, xrun - xin, colors[*xin]);
+      xin = xrun;
       }
     }
 
+  /** Find the end of the run of labels equal to the first one */
+  static const LabelType *FindRunEnd(const LabelType *p, const LabelType *end)
+    {
+    // Compare a word's worth of labels at a time
+    const size_t k = sizeof(uint64_t) / sizeof(LabelType);
+    LabelType run[k];
+    std::fill_n(run, k, *p);
+
+    uint64_t pattern, word;
+    memcpy(&pattern, run, sizeof(uint64_t));
+    for(++p; p + k <= end; p += k)
+      {
+      memcpy(&word, p, sizeof(uint64_t));
+      if(word != pattern)
+        break;
+      }
+
+    while(p < end && *p == run[0])
+      ++p;
+
+    return p;
+    }
+
 private:
   ColorLabelTable *m_ColorTable;
 };
@@ -9,6 +9,7 @@ ScalarImageHistogram::ScalarImageHistogram()
   m_MaxFrequency = 0;
   m_TotalSamples = 0;
   m_BinCount = 0;
+  m_Approximate = false;
 }
 
 ScalarImageHistogram::~ScalarImageHistogram()
@@ -39,6 +40,7 @@ ScalarImageHistogram
 
   m_MaxFrequency = 0;
   m_TotalSamples = 0;
+  m_Approximate = false;
 }
 
 
@@ -94,6 +96,23 @@ ScalarImageHistogram
     }
 }
 
+void
+ScalarImageHistogram
+::AddCompatibleHistogram(const Self *addee, double weight)
+{
+  assert(addee->m_Bins.size() == m_Bins.size());
+  assert(addee->m_FirstBinStart == m_FirstBinStart);
+  assert(addee->m_BinWidth == m_BinWidth);
+
+  for(unsigned int i = 0; i < m_Bins.size(); i++)
+    {
+    unsigned long n = (unsigned long) (0.5 + addee->m_Bins[i] * weight);
+    unsigned long k = (m_Bins[i] += n);
+    m_MaxFrequency = std::max(m_MaxFrequency, k);
+    m_TotalSamples+=n;
+    }
+}
+
 void ScalarImageHistogram::ApplyIntensityTransform(double scale, double shift)
 {
   m_FirstBinStart = scale * m_FirstBinStart + shift;
@@ -32,6 +32,13 @@ public:
    */
   void AddCompatibleHistogram(const Self *addee);
 
+  /**
+   * Add the contents of a compatible histogram with each frequency multiplied
+   * by a weight and rounded. This is used to extrapolate the histogram of a
+   * sample of the voxels in an image to the whole image.
+   */
+  void AddCompatibleHistogram(const Self *addee, double weight);
+
   /**
    * Apply an intensity transform to the histogram. This applies scaling and
    * shift to the bin boundaries.
@@ -55,6 +62,13 @@ public:
   irisGetMacro(TotalSamples, unsigned long)
   irisGetMacro(BinWidth, double)
 
+  /**
+   * Whether the frequencies are estimated from a sample of the voxels rather
+   * than counted over the whole image. Cleared by Initialize().
+   */
+  irisIsMacro(Approximate)
+  irisSetMacro(Approximate, bool)
+
 protected:
   ScalarImageHistogram();
   virtual ~ScalarImageHistogram();
@@ -64,6 +78,7 @@ protected:
   double m_FirstBinStart, m_BinWidth, m_Scale;
   unsigned long m_MaxFrequency, m_TotalSamples;
   int m_BinCount;
+  bool m_Approximate;
 
 };
 
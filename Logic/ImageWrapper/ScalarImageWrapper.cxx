@@ -45,6 +45,7 @@
 #include "vtkImageImport.h"
 #include "SNAPExportITKToVTK.h"
 
+#include <algorithm>
 #include <iostream>
 
 template<class TTraits, class TBase>
@@ -88,6 +89,25 @@ ScalarImageWrapper<TTraits,TBase>
   // Set the number of bins to default
   m_HistogramFilter->SetNumberOfBins(DEFAULT_HISTOGRAM_BINS);
 
+  // Large images get a quick estimate of the histogram first
+  m_HistogramFilter->SetSamplingThreshold(HISTOGRAM_SAMPLING_THRESHOLD);
+  m_HistogramFilter->SetSampleSize(HISTOGRAM_SAMPLE_SIZE);
+
+  // The histogram of each time point is kept, and counted again only when
+  // the pixels of that time point are modified
+  m_HistogramFilter->SetBlockMTimeFunction(
+        [this](const typename Image4DType::RegionType &region)
+    {
+    itk::ModifiedTimeType mtime = 0;
+    for(unsigned int k = 0; k < region.GetSize(3); k++)
+      {
+      unsigned int tp = region.GetIndex(3) + k;
+      if(tp < this->m_ImageTimePoints.size())
+        mtime = std::max(mtime, this->m_ImageTimePoints[tp]->GetMTime());
+      }
+    return mtime;
+    });
+
   // Update the common representation policy
   m_CommonRepresentationPolicy.UpdateInputImage(this->GetImage());
 }
@@ -392,6 +412,30 @@ ScalarImageWrapper<TTraits, TBase>
   return m_CommonRepresentationPolicy.GetOutput(channel);
 }
 
+template<class TTraits, class TBase>
+double
+ScalarImageWrapper<TTraits, TBase>
+::GetDerivedDataMemoryInMB() const
+{
+  return Superclass::GetDerivedDataMemoryInMB() + m_CommonRepresentationPolicy.GetMemoryInMB();
+}
+
+template<class TTraits, class TBase>
+void
+ScalarImageWrapper<TTraits, TBase>
+::ReleaseDerivedData()
+{
+  // The VTK exporter hands the whole-image buffer to VTK without copying it,
+  // so that channel has to stay in memory once the importer exists
+  for(int i = 0; i < ScalarImageWrapperBase::CHANNEL_COUNT; i++)
+    {
+    if(i != ScalarImageWrapperBase::WHOLE_IMAGE || !m_VTKImporter)
+      m_CommonRepresentationPolicy.ReleaseData(static_cast<ExportChannel>(i));
+    }
+
+  Superclass::ReleaseDerivedData();
+}
+
 template<class TTraits, class TBase>
 IntensityCurveInterface *
 ScalarImageWrapper<TTraits, TBase>
@@ -422,6 +466,15 @@ ScalarImageWrapper<TTraits,TBase>
   return m_HistogramFilter->GetHistogramOutput();
 }
 
+template<class TTraits, class TBase>
+void
+ScalarImageWrapper<TTraits,TBase>
+::UpdateRefinedHistogram()
+{
+  if(m_HistogramFilter->UpdateRefinedHistogram())
+    this->InvokeEvent(WrapperHistogramChangeEvent());
+}
+
 template<class TTraits, class TBase>
 void
 ScalarImageWrapper<TTraits, TBase>
@@ -194,6 +194,9 @@ public:
     */
   const ScalarImageHistogram *GetHistogram(size_t nBins = 0) ITK_OVERRIDE;
 
+  /** Place the exact histogram computed in the background in the histogram */
+  virtual void UpdateRefinedHistogram() ITK_OVERRIDE;
+
   /**
     Get the maximum possible value of the gradient magnitude. This will
     compute the gradient magnitude of the image (without Gaussian smoothing)
@@ -247,6 +250,12 @@ public:
   /** Get a version of this image that is usable in VTK pipelines */
   vtkImageImport *GetVTKImporter() ITK_OVERRIDE;
 
+  /** Memory used by the images cast to the common format */
+  virtual double GetDerivedDataMemoryInMB() const ITK_OVERRIDE;
+
+  /** Release the images cast to the common format */
+  virtual void ReleaseDerivedData() ITK_OVERRIDE;
+
   /** Extends parent method */
   virtual void SetNativeMapping(NativeIntensityMapping mapping) ITK_OVERRIDE;
 
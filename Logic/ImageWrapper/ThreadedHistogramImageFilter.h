@@ -6,6 +6,11 @@
 #include <itkNumericTraits.h>
 #include <ScalarImageHistogram.h>
 
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
 /**
  * This ITK-style filter computes the histogram of an ITK scalar image. It
  * uses threading for faster histogram computation. It also is meant to be
@@ -13,6 +18,20 @@
  * determining the range of the histogram. The histogram in this filter is
  * constructed from equal size bins between the input min and max, and the
  * number of bins is a power of two.
+ *
+ * For very large images, the filter can be asked to first estimate the
+ * histogram from a stratified sample of the voxels, so that it can be shown
+ * right away. The exact histogram is then computed on a background thread,
+ * and is swapped into the output by UpdateRefinedHistogram(). The range of
+ * the histogram is not estimated: it comes from the min/max inputs, which
+ * must hold the exact extremes of the image, because the display mapping
+ * indexes its lookup tables over the same range without bounds checking.
+ *
+ * The filter can also be given a function that returns the time stamp of the
+ * data in a block of the image (a slab along the last image dimension, e.g.,
+ * a time point of a 4D image). The histograms of the blocks whose data have
+ * not changed since the last update are then reused, so that editing one
+ * time point does not require the whole image to be counted again.
  */
 template <class TInputImage>
 class ThreadedHistogramImageFilter :
@@ -76,6 +95,33 @@ public:
    */
   void SetIntensityTransform(double scale, double shift);
 
+  /**
+   * Function returning the time stamp of the pixel data in a block of the
+   * input image. Blocks are the slabs of thickness one along the last image
+   * dimension. Without this function, the image is a single block, whose
+   * time stamp is that of the input image.
+   */
+  typedef std::function<itk::ModifiedTimeType (const RegionType &)> BlockMTimeFunction;
+  void SetBlockMTimeFunction(const BlockMTimeFunction &function);
+
+  /**
+   * Set the number of voxels above which the histogram of the modified blocks
+   * is estimated from a sample and refined in the background. Zero, which is
+   * the default, means that the histogram is always computed exactly.
+   */
+  void SetSamplingThreshold(size_t n_voxels);
+
+  /** Set the number of voxels sampled to estimate the histogram */
+  void SetSampleSize(size_t n_voxels);
+
+  /**
+   * If the output histogram is approximate and its exact counterpart has been
+   * computed in the background, place the exact histogram in the output, fire
+   * a modified event on the histogram and return true. This should be called
+   * periodically from the thread that updates the filter.
+   */
+  bool UpdateRefinedHistogram();
+
   /**
    * Get the histogram output
    */
@@ -84,7 +130,7 @@ public:
 protected:
 
   ThreadedHistogramImageFilter();
-  virtual ~ThreadedHistogramImageFilter() {}
+  virtual ~ThreadedHistogramImageFilter();
   void PrintSelf(std::ostream & os, itk::Indent indent) const ITK_OVERRIDE;
 
   /** Pass the input through unmodified. Do this by Grafting in the
@@ -114,8 +160,54 @@ private:
   // Intensity transform
   double m_TransformScale, m_TransformShift;
 
-  // Per-thread histograms
-  std::vector< HistogramPointer > m_ThreadHistogram;
+  // Histogram of a block of the input and the time stamp of its data. The
+  // histogram is null if it has not been computed exactly
+  struct Block
+  {
+    RegionType Region;
+    itk::ModifiedTimeType DataMTime;
+    HistogramPointer Histogram;
+  };
+
+  // Split the input into blocks and find their time stamps
+  void ComputeBlocks(std::vector<Block> &blocks);
+
+  // Compute the exact histogram of a region, using multiple threads. Returns
+  // a null pointer if the computation is aborted
+  static HistogramPointer ComputeRegionHistogram(
+      const TInputImage *image, const RegionType &region,
+      PixelType pxmin, PixelType pxmax, unsigned int nBins,
+      const std::atomic<bool> *abort);
+
+  // Estimate the histogram of a region from a stratified sample of its voxels
+  // and add it to the output with the appropriate weight
+  void AddSampledRegionHistogram(const RegionType &region, size_t n_samples,
+                                 PixelType pxmin, PixelType pxmax);
+
+  // Fill the output from the block histograms
+  void UpdateOutputFromBlocks();
+
+  // Stop the background computation, if one is running
+  void AbortRefinement();
+
+  // Parameter: number of voxels above which sampling is used, sample size
+  size_t m_SamplingThreshold, m_SampleSize;
+
+  // Time stamps of the blocks of the input
+  BlockMTimeFunction m_BlockMTimeFunction;
+
+  // Block histograms, and the range, number of bins and pixel buffer that
+  // they were computed with
+  std::vector<Block> m_Blocks;
+  PixelType m_BlockMin, m_BlockMax;
+  unsigned int m_BlockBins;
+  const void *m_BlockBuffer;
+
+  // Background computation of the blocks that were sampled. The thread holds
+  // on to the input and its buffer, and fills out m_RefinedHistograms
+  std::thread m_RefinementThread;
+  std::atomic<bool> m_RefinementAbort, m_RefinementDone;
+  std::vector<HistogramPointer> m_RefinedHistograms;
 
   // The output histogram
   HistogramPointer m_OutputHistogram;
@@ -4,6 +4,10 @@
 #include "ThreadedHistogramImageFilter.h"
 #include <itkProgressReporter.h>
 #include <itkImageRegionConstIterator.h>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <random>
 
 template <class TInputImage>
 ThreadedHistogramImageFilter<TInputImage>
@@ -19,6 +23,24 @@ ThreadedHistogramImageFilter<TInputImage>
   m_Bins = 0;
   m_TransformScale = 1.0;
   m_TransformShift = 0.0;
+
+  m_SamplingThreshold = 0;
+  m_SampleSize = 1 << 20;
+
+  m_BlockMin = itk::NumericTraits<PixelType>::ZeroValue();
+  m_BlockMax = itk::NumericTraits<PixelType>::ZeroValue();
+  m_BlockBins = 0;
+  m_BlockBuffer = nullptr;
+
+  m_RefinementAbort = false;
+  m_RefinementDone = false;
+}
+
+template <class TInputImage>
+ThreadedHistogramImageFilter<TInputImage>
+::~ThreadedHistogramImageFilter()
+{
+  this->AbortRefinement();
 }
 
 template <class TInputImage>
@@ -57,6 +79,41 @@ ThreadedHistogramImageFilter<TInputImage>
     }
 }
 
+template <class TInputImage>
+void
+ThreadedHistogramImageFilter<TInputImage>
+::SetBlockMTimeFunction(const BlockMTimeFunction &function)
+{
+  this->AbortRefinement();
+  m_BlockMTimeFunction = function;
+  m_Blocks.clear();
+  this->Modified();
+}
+
+template <class TInputImage>
+void
+ThreadedHistogramImageFilter<TInputImage>
+::SetSamplingThreshold(size_t n_voxels)
+{
+  if(m_SamplingThreshold != n_voxels)
+    {
+    m_SamplingThreshold = n_voxels;
+    this->Modified();
+    }
+}
+
+template <class TInputImage>
+void
+ThreadedHistogramImageFilter<TInputImage>
+::SetSampleSize(size_t n_voxels)
+{
+  if(m_SampleSize != n_voxels)
+    {
+    m_SampleSize = n_voxels;
+    this->Modified();
+    }
+}
+
 template <class TInputImage>
 void
 ThreadedHistogramImageFilter<TInputImage>
@@ -97,52 +154,267 @@ ThreadedHistogramImageFilter<TInputImage>
 template< class TInputImage >
 void
 ThreadedHistogramImageFilter<TInputImage>
-::GenerateData()
+::ComputeBlocks(std::vector<Block> &blocks)
 {
-  this->AllocateOutputs();
+  const TInputImage *input = this->GetInput();
+  RegionType region = input->GetBufferedRegion();
 
-  // Get the range of the histogram
-  PixelType pxmin = m_InputMin->Get();
-  PixelType pxmax = m_InputMax->Get();
+  blocks.clear();
+  if(!m_BlockMTimeFunction)
+    {
+    Block block;
+    block.Region = region;
+    block.DataMTime = input->GetMTime();
+    blocks.push_back(block);
+    return;
+    }
 
-  // Initialize the output
-  m_OutputHistogram->Initialize(pxmin, pxmax, m_Bins);
+  // One block for each index along the last dimension
+  const unsigned int d = InputImageDimension - 1;
+  for(itk::SizeValueType k = 0; k < region.GetSize(d); k++)
+    {
+    Block block;
+    block.Region = region;
+    block.Region.SetIndex(d, region.GetIndex(d) + k);
+    block.Region.SetSize(d, 1);
+    block.DataMTime = m_BlockMTimeFunction(block.Region);
+    blocks.push_back(block);
+    }
+}
+
+template< class TInputImage >
+typename ThreadedHistogramImageFilter<TInputImage>::HistogramPointer
+ThreadedHistogramImageFilter<TInputImage>
+::ComputeRegionHistogram(
+    const TInputImage *image, const RegionType &region,
+    PixelType pxmin, PixelType pxmax, unsigned int nBins,
+    const std::atomic<bool> *abort)
+{
+  HistogramPointer hist = HistogramType::New();
+  hist->Initialize(pxmin, pxmax, nBins);
 
-  // A mutex to control updating the output histogram
+  // A mutex to control updating the histogram
   std::mutex histo_mutex;
 
   // Parrallel block
   itk::MultiThreaderBase::Pointer mt = itk::MultiThreaderBase::New();
-  mt->ParallelizeImageRegion<Self::OutputImageDimension>(
-        this->GetOutput()->GetBufferedRegion(),
-        [this, pxmin, pxmax, &histo_mutex](const RegionType &region)
+  mt->ParallelizeImageRegion<Self::InputImageDimension>(
+        region,
+        [image, pxmin, pxmax, nBins, abort, &hist, &histo_mutex](const RegionType &subregion)
     {
     // Create a thread-local histogram
     HistogramType::Pointer local_hist = HistogramType::New();
-    local_hist->Initialize(pxmin, pxmax, m_Bins);
+    local_hist->Initialize(pxmin, pxmax, nBins);
 
-    // Compute the histogram
-    for(itk::ImageRegionConstIterator< TInputImage > it(this->GetInput(), region);
-        !it.IsAtEnd(); ++it)
+    // Compute the histogram, checking for the abort flag now and then
+    unsigned long n = 0;
+    for(itk::ImageRegionConstIterator< TInputImage > it(image, subregion);
+        !it.IsAtEnd(); ++it, ++n)
       {
+      if((n & 0xfffff) == 0 && abort && *abort)
+        return;
       local_hist->AddSample(it.Get());
       }
 
     // In a reentrant block, update the main histogram
     std::lock_guard<std::mutex> guard(histo_mutex);
-    m_OutputHistogram->AddCompatibleHistogram(local_hist);
+    hist->AddCompatibleHistogram(local_hist);
     }, nullptr);
 
+  return (abort && *abort) ? HistogramPointer() : hist;
+}
+
+template< class TInputImage >
+void
+ThreadedHistogramImageFilter<TInputImage>
+::AddSampledRegionHistogram(const RegionType &region, size_t n_samples,
+                            PixelType pxmin, PixelType pxmax)
+{
+  const TInputImage *input = this->GetInput();
+  size_t n_voxels = region.GetNumberOfPixels();
+  n_samples = std::min(std::max(n_samples, (size_t) 1), n_voxels);
+
+  // Blocks are contiguous in the buffer. Split the range of their offsets
+  // into equal strata and pick one voxel at random in each stratum. The
+  // generator is seeded the same way every time, so that a given image
+  // always yields the same estimate
+  itk::OffsetValueType start = input->ComputeOffset(region.GetIndex());
+  double stratum = n_voxels * 1.0 / n_samples;
+  std::minstd_rand rng(1);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+  HistogramPointer sample = HistogramType::New();
+  sample->Initialize(pxmin, pxmax, m_Bins);
+  for(size_t j = 0; j < n_samples; j++)
+    {
+    size_t offset = std::min((size_t) ((j + uniform(rng)) * stratum), n_voxels - 1);
+    sample->AddSample(input->GetPixel(input->ComputeIndex(start + offset)));
+    }
+
+  // Each sampled voxel stands for the voxels in its stratum
+  m_OutputHistogram->AddCompatibleHistogram(sample, stratum);
+}
+
+template< class TInputImage >
+void
+ThreadedHistogramImageFilter<TInputImage>
+::UpdateOutputFromBlocks()
+{
+  m_OutputHistogram->Initialize(m_BlockMin, m_BlockMax, m_BlockBins);
+  for(unsigned int i = 0; i < m_Blocks.size(); i++)
+    m_OutputHistogram->AddCompatibleHistogram(m_Blocks[i].Histogram);
+
   // Apply the transform to the histogram
   m_OutputHistogram->ApplyIntensityTransform(m_TransformScale, m_TransformShift);
 }
 
+template< class TInputImage >
+void
+ThreadedHistogramImageFilter<TInputImage>
+::AbortRefinement()
+{
+  if(m_RefinementThread.joinable())
+    {
+    m_RefinementAbort = true;
+    m_RefinementThread.join();
+    }
+
+  m_RefinementAbort = false;
+  m_RefinementDone = false;
+  m_RefinedHistograms.clear();
+}
+
+template< class TInputImage >
+bool
+ThreadedHistogramImageFilter<TInputImage>
+::UpdateRefinedHistogram()
+{
+  if(!m_RefinementThread.joinable() || !m_RefinementDone)
+    return false;
+
+  m_RefinementThread.join();
+  for(unsigned int i = 0; i < m_RefinedHistograms.size(); i++)
+    if(m_RefinedHistograms[i])
+      m_Blocks[i].Histogram = m_RefinedHistograms[i];
+
+  m_RefinedHistograms.clear();
+  m_RefinementDone = false;
+
+  this->UpdateOutputFromBlocks();
+  m_OutputHistogram->Modified();
+  return true;
+}
+
+template< class TInputImage >
+void
+ThreadedHistogramImageFilter<TInputImage>
+::GenerateData()
+{
+  this->AllocateOutputs();
+
+  // The histogram being refined in the background is out of date
+  this->AbortRefinement();
+
+  // Get the range of the histogram
+  const TInputImage *input = this->GetInput();
+  PixelType pxmin = m_InputMin->Get();
+  PixelType pxmax = m_InputMax->Get();
+  const void *buffer = const_cast<TInputImage *>(input)->GetPixelContainer();
+
+  // Block histograms are reused if they were computed with the same range,
+  // bins and pixel buffer, and the data in the block have not changed since
+  std::vector<Block> blocks;
+  this->ComputeBlocks(blocks);
+
+  bool reusable = pxmin == m_BlockMin && pxmax == m_BlockMax && m_Bins == m_BlockBins
+      && buffer == m_BlockBuffer && blocks.size() == m_Blocks.size();
+
+  size_t n_dirty = 0;
+  for(unsigned int i = 0; i < blocks.size(); i++)
+    {
+    if(reusable && m_Blocks[i].Histogram
+       && m_Blocks[i].Region == blocks[i].Region
+       && m_Blocks[i].DataMTime == blocks[i].DataMTime)
+      blocks[i].Histogram = m_Blocks[i].Histogram;
+    else
+      n_dirty += blocks[i].Region.GetNumberOfPixels();
+    }
+
+  m_Blocks = blocks;
+  m_BlockMin = pxmin;
+  m_BlockMax = pxmax;
+  m_BlockBins = m_Bins;
+  m_BlockBuffer = buffer;
+
+  // Count the modified blocks exactly, unless there are too many voxels
+  if(m_SamplingThreshold == 0 || n_dirty <= m_SamplingThreshold || n_dirty <= m_SampleSize)
+    {
+    for(unsigned int i = 0; i < m_Blocks.size(); i++)
+      if(!m_Blocks[i].Histogram)
+        m_Blocks[i].Histogram = ComputeRegionHistogram(
+              input, m_Blocks[i].Region, pxmin, pxmax, m_Bins, nullptr);
+
+    this->UpdateOutputFromBlocks();
+    return;
+    }
+
+  // Otherwise, add the unmodified blocks to an estimate of the modified ones,
+  // with the sample divided between blocks in proportion to their size
+  std::vector<unsigned int> dirty;
+  m_OutputHistogram->Initialize(pxmin, pxmax, m_Bins);
+  for(unsigned int i = 0; i < m_Blocks.size(); i++)
+    {
+    if(m_Blocks[i].Histogram)
+      {
+      m_OutputHistogram->AddCompatibleHistogram(m_Blocks[i].Histogram);
+      }
+    else
+      {
+      size_t n_voxels = m_Blocks[i].Region.GetNumberOfPixels();
+      size_t n_samples = (size_t) std::ceil(m_SampleSize * (n_voxels * 1.0 / n_dirty));
+      this->AddSampledRegionHistogram(m_Blocks[i].Region, n_samples, pxmin, pxmax);
+      dirty.push_back(i);
+      }
+    }
+
+  m_OutputHistogram->SetApproximate(true);
+  m_OutputHistogram->ApplyIntensityTransform(m_TransformScale, m_TransformShift);
+
+  // Count the modified blocks in the background. The thread keeps the input
+  // image and its buffer alive until it is done
+  std::vector<RegionType> regions;
+  for(unsigned int i = 0; i < dirty.size(); i++)
+    regions.push_back(m_Blocks[dirty[i]].Region);
+
+  m_RefinedHistograms.assign(m_Blocks.size(), HistogramPointer());
+  typename TInputImage::ConstPointer image = input;
+  itk::SmartPointer<const itk::Object> buffer_ref =
+      const_cast<TInputImage *>(input)->GetPixelContainer();
+  unsigned int nBins = m_Bins;
+
+  m_RefinementThread = std::thread(
+        [this, image, buffer_ref, dirty, regions, pxmin, pxmax, nBins]()
+    {
+    for(unsigned int i = 0; i < dirty.size(); i++)
+      {
+      HistogramPointer hist = ComputeRegionHistogram(
+            image, regions[i], pxmin, pxmax, nBins, &m_RefinementAbort);
+      if(!hist)
+        return;
+      m_RefinedHistograms[dirty[i]] = hist;
+      }
+    m_RefinementDone = true;
+    });
+}
+
 template< class TInputImage >
 void
 ThreadedHistogramImageFilter<TInputImage>
 ::PrintSelf(std::ostream &os, itk::Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
+  os << indent << "SamplingThreshold: " << m_SamplingThreshold << std::endl;
+  os << indent << "SampleSize: " << m_SampleSize << std::endl;
 }
 
 
@@ -216,6 +216,7 @@ VectorImageWrapper<TTraits,TBase>
   // Pass the display geometry to the component wrapper
   for(int k = 0; k < 3; k++)
     wrapper->SetDisplayViewportGeometry(k, this->GetDisplayViewportGeometry(k));
+  this->ShareImagePyramid(wrapper.GetPointer());
 
   SmartPtr<ScalarImageWrapperBase> ptrout = wrapper.GetPointer();
 
@@ -258,6 +259,7 @@ VectorImageWrapper<TTraits,TBase>
 
     // Initialize referencing the current wrapper
     cw->InitializeToWrapper(this, comp, referenceSpace, transform);
+    this->ShareImagePyramid(cw.GetPointer());
 
     // Assign a parent wrapper to the derived wrapper
     cw->SetParentWrapper(this);
@@ -295,6 +297,8 @@ VectorImageWrapper<TTraits,TBase>
 
   // Set the number of bins (TODO - how to do this smartly?)
   m_HistogramFilter->SetNumberOfBins(DEFAULT_HISTOGRAM_BINS);
+  m_HistogramFilter->SetSamplingThreshold(HISTOGRAM_SAMPLING_THRESHOLD);
+  m_HistogramFilter->SetSampleSize(HISTOGRAM_SAMPLE_SIZE);
 
   /*
 
@@ -370,6 +374,19 @@ VectorImageWrapper<TTraits,TBase>
   return m_HistogramFilter->GetHistogramOutput();
 }
 
+template<class TTraits, class TBase>
+void
+VectorImageWrapper<TTraits,TBase>
+::UpdateRefinedHistogram()
+{
+  if(m_HistogramFilter->UpdateRefinedHistogram())
+    this->InvokeEvent(WrapperHistogramChangeEvent());
+
+  // The scalar representations have histograms of their own
+  for(ScalarRepIterator it = m_ScalarReps.begin(); it != m_ScalarReps.end(); ++it)
+    it->second->UpdateRefinedHistogram();
+}
+
 
 template <class TTraits, class TBase>
 inline ScalarImageWrapperBase *
@@ -409,6 +426,30 @@ VectorImageWrapper<TTraits,TBase>
   return false;
 }
 
+template <class TTraits, class TBase>
+double
+VectorImageWrapper<TTraits,TBase>
+::GetDerivedDataMemoryInMB() const
+{
+  double mb = Superclass::GetDerivedDataMemoryInMB();
+  for(ScalarRepConstIterator it = m_ScalarReps.begin(); it != m_ScalarReps.end(); ++it)
+    if(it->second)
+      mb += it->second->GetDerivedDataMemoryInMB();
+  return mb;
+}
+
+template <class TTraits, class TBase>
+void
+VectorImageWrapper<TTraits,TBase>
+::ReleaseDerivedData()
+{
+  for(ScalarRepIterator it = m_ScalarReps.begin(); it != m_ScalarReps.end(); ++it)
+    if(it->second)
+      it->second->ReleaseDerivedData();
+
+  Superclass::ReleaseDerivedData();
+}
+
 template <class TTraits, class TBase>
 typename VectorImageWrapper<TTraits,TBase>::ComponentWrapperType *
 VectorImageWrapper<TTraits,TBase>
@@ -432,6 +473,84 @@ VectorImageWrapper<TTraits,TBase>
     }
 }
 
+template <class TTraits, class TBase>
+void
+VectorImageWrapper<TTraits,TBase>
+::SetUseImagePyramid(bool flag)
+{
+  Superclass::SetUseImagePyramid(flag);
+
+  // The owned scalar wrappers, which are sliced for RGB display, slice the
+  // levels of this wrapper's pyramid
+  for(ScalarRepIterator it = m_ScalarReps.begin(); it != m_ScalarReps.end(); ++it)
+    {
+    ScalarRepIndex idx = it->first;
+    if(idx.first == SCALAR_REP_COMPONENT)
+      {
+      this->ShareImagePyramid(
+            dynamic_cast<ComponentWrapperType *>(it->second.GetPointer()));
+      }
+    else if(idx.first == SCALAR_REP_MAGNITUDE)
+      {
+      ShareImagePyramidWithDerivedWrapper<MagnitudeFunctor>(it->second);
+      }
+    else if(idx.first == SCALAR_REP_MAX)
+      {
+      ShareImagePyramidWithDerivedWrapper<MaxFunctor>(it->second);
+      }
+    else if(idx.first == SCALAR_REP_AVERAGE)
+      {
+      ShareImagePyramidWithDerivedWrapper<MeanFunctor>(it->second);
+      }
+    }
+}
+
+template <class TTraits, class TBase>
+template <class TWrapper>
+void
+VectorImageWrapper<TTraits,TBase>
+::ShareImagePyramid(TWrapper *wrapper)
+{
+  typedef ImageAdaptorPyramid<typename TWrapper::ImageType> AdaptorPyramidType;
+
+  SmartPtr<AdaptorPyramidType> pyramid;
+  if(this->m_ImagePyramid)
+    {
+    pyramid = AdaptorPyramidType::New();
+    pyramid->SetSource(this->m_ImagePyramid);
+    }
+
+  wrapper->SetImagePyramid(pyramid);
+}
+
+template <class TTraits, class TBase>
+template <class TFunctor>
+void
+VectorImageWrapper<TTraits,TBase>
+::ShareImagePyramidWithDerivedWrapper(ScalarImageWrapperBase *w)
+{
+  typedef VectorDerivedQuantityImageWrapperTraits<TFunctor> WrapperTraits;
+  typedef typename WrapperTraits::WrapperType DerivedWrapper;
+
+  // Cast to the right type
+  DerivedWrapper *dw = dynamic_cast<DerivedWrapper *>(w);
+  this->ShareImagePyramid(dw);
+}
+
+template <class TTraits, class TBase>
+void
+VectorImageWrapper<TTraits,TBase>
+::SetFullResolutionSlicing(bool flag)
+{
+  Superclass::SetFullResolutionSlicing(flag);
+
+  // Propagate to owned scalar wrappers
+  for(ScalarRepIterator it = m_ScalarReps.begin(); it != m_ScalarReps.end(); ++it)
+    {
+    it->second->SetFullResolutionSlicing(flag);
+    }
+}
+
 template <class TTraits, class TBase>
 void
 VectorImageWrapper<TTraits,TBase>
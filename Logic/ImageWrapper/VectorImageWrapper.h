@@ -196,6 +196,10 @@ public:
 
   virtual void SetDisplayViewportGeometry(unsigned int index, ImageBaseType *viewport_image);
 
+  virtual void SetUseImagePyramid(bool flag) ITK_OVERRIDE;
+
+  virtual void SetFullResolutionSlicing(bool flag) ITK_OVERRIDE;
+
   virtual void SetDirectionMatrix(const vnl_matrix<double> &direction) ITK_OVERRIDE;
 
   virtual void CopyImageCoordinateTransform(const ImageWrapperBase *source) ITK_OVERRIDE;
@@ -214,6 +218,15 @@ public:
     */
   const ScalarImageHistogram *GetHistogram(size_t nBins = 0) ITK_OVERRIDE;
 
+  /** Place the exact histogram computed in the background in the histogram */
+  virtual void UpdateRefinedHistogram() ITK_OVERRIDE;
+
+  /** Memory used by the derived data of all the scalar representations */
+  virtual double GetDerivedDataMemoryInMB() const ITK_OVERRIDE;
+
+  /** Release the derived data of all the scalar representations */
+  virtual void ReleaseDerivedData() ITK_OVERRIDE;
+
 
   /**
     This method creates an ITK mini-pipeline that can be used to cast the internal
@@ -272,6 +285,17 @@ protected:
   void SetNativeMappingInDerivedWrapper(
       ScalarImageWrapperBase *w, NativeIntensityMapping &mapping);
 
+  /**
+   * Give a scalar representation a view into the levels of this wrapper's
+   * image pyramid, so that the components and derived quantities do not
+   * each downsample the whole multi-component image
+   */
+  template <class TWrapper>
+  void ShareImagePyramid(TWrapper *wrapper);
+
+  template <class TFunctor>
+  void ShareImagePyramidWithDerivedWrapper(ScalarImageWrapperBase *w);
+
   // Array of derived quantities
   typedef SmartPtr<ScalarImageWrapperBase> ScalarWrapperPointer;
   typedef std::pair<ScalarRepresentation, int> ScalarRepIndex;
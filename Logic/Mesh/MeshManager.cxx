@@ -52,6 +52,7 @@
 #include "SNAPImageData.h"
 #include "AllPurposeProgressAccumulator.h"
 #include "MeshOptions.h"
+#include "SNAPTrace.h"
 
 // ITK includes
 #include "itkRegionOfInterestImageFilter.h"
@@ -143,6 +144,8 @@ void
 MeshManager
 ::UpdateVTKMeshes(itk::Command *command, unsigned int timepoint)
 { 
+  SNAP_TRACE("mesh", "MeshManager::UpdateVTKMeshes");
+
   // The mesh is constructed differently depending on whether there is an
   // actively evolving level set or not SNAP mode or in IRIS mode
   if (m_Driver->IsSnakeModeLevelSetActive())
@@ -397,13 +397,9 @@ UpdateMetaData()
   m_MetaDataMap["Number of Time Points"] = std::to_string(m_MeshAssemblyMap.size());
 
   // Update Memory Usage
-  double memory = 0.0;
-	for (auto &kv : m_MeshAssemblyMap)
-    memory += kv.second->GetTotalMemoryInMB();
-
   // Use an oss to format string
   std::ostringstream oss;
-  oss << std::fixed << std::setprecision(2) << memory;
+  oss << std::fixed << std::setprecision(2) << GetTotalMemoryInMB();
   m_MetaDataMap["Memory Usage (MB)"] = oss.str();
 
   // Update Data Array Properties
@@ -416,6 +412,17 @@ UpdateMetaData()
     }
 }
 
+double
+MeshWrapperBase
+::GetTotalMemoryInMB() const
+{
+  double memory = 0.0;
+  for (auto &kv : m_MeshAssemblyMap)
+    memory += kv.second->GetTotalMemoryInMB();
+
+  return memory;
+}
+
 size_t
 MeshWrapperBase
 ::GetNumberOfMeshes(unsigned int timepoint)
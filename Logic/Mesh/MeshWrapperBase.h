@@ -231,6 +231,9 @@ public:
   /** Get the MeshAssembly associated with the time point */
   virtual MeshAssembly *GetMeshAssembly(unsigned int timepoint);
 
+  /** Get the memory used by the meshes of all time points, in megabytes */
+  double GetTotalMemoryInMB() const;
+
   /**
    *  Set the mesh and its id for a time point
    *  Implemente in subclasses
@@ -44,10 +44,19 @@
 #include "IRISVectorTypesToITKConversion.h"
 #include "VTKMeshPipeline.h"
 #include "MeshOptions.h"
+#include "SNAPTrace.h"
 #include "vtkUnsignedShortArray.h"
 
 // ITK includes
 #include "itkBinaryThresholdImageFilter.h"
+#include "itkMultiThreaderBase.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <thread>
 
 using namespace std;
 
@@ -147,6 +156,50 @@ MultiLabelMeshPipeline
   return true;
 }
 
+void
+MultiLabelMeshPipeline
+::ComputeLabelMesh(
+    LabelType label, const itk::ImageRegion<3> &region, vtkPolyData *mesh,
+    std::mutex *input_mutex, itk::Command *progress)
+{
+  SNAP_TRACE("mesh", "MultiLabelMeshPipeline::ComputeLabelMesh");
+
+  // Labels are meshed in parallel, one label per thread, so the filters here
+  // run on a single thread rather than competing for the processors
+
+  // Extract the bounding box. Updating a filter writes to the requested
+  // region of its input, so this is done one label at a time, and the
+  // extracted image is disconnected from the shared input
+  InputImagePointer roi_image;
+  {
+    std::lock_guard<std::mutex> lock(*input_mutex);
+    ROIFilterPointer roi = ROIFilter::New();
+    roi->SetNumberOfWorkUnits(1);
+    roi->SetInput(m_InputImage);
+    roi->SetRegionOfInterest(region);
+    roi->Update();
+    roi_image = roi->GetOutput();
+    roi_image->DisconnectPipeline();
+  }
+
+  // Map the label onto the range -1 to 1
+  ThresholdFilterPointer threshold = ThresholdFilter::New();
+  threshold->SetNumberOfWorkUnits(1);
+  threshold->SetInput(roi_image);
+  threshold->SetInsideValue(1.0f);
+  threshold->SetOutsideValue(-1.0f);
+  threshold->SetLowerThreshold(label);
+  threshold->SetUpperThreshold(label);
+  threshold->Update();
+
+  VTKMeshPipeline pipeline;
+  pipeline.SetNumberOfThreads(1);
+  pipeline.SetMeshOptions(m_MeshOptions);
+  pipeline.SetImage(threshold->GetOutput());
+  pipeline.GetProgressAccumulator()->AddObserver(itk::ProgressEvent(), progress);
+  pipeline.ComputeMesh(mesh);
+}
+
 #include "itkImageLinearConstIteratorWithIndex.h"
 #include "itk_zlib.h"
 
@@ -203,6 +256,8 @@ void MultiLabelMeshPipeline::UpdateMeshInfoHelper(
 
 void MultiLabelMeshPipeline::UpdateMeshes(itk::Command *progressCommand)
 {
+  SNAP_TRACE("mesh", "MultiLabelMeshPipeline::UpdateMeshes");
+
   // Create a temporary table of mesh info
   MeshInfoMap meshmap;
 
@@ -278,52 +333,136 @@ void MultiLabelMeshPipeline::UpdateMeshes(itk::Command *progressCommand)
       info.BoundingBox[0] = it->second.BoundingBox[0];
       info.BoundingBox[1] = it->second.BoundingBox[1];
       info.Mesh = NULL;
-
-      //auto src = m_VTKPipeline->GetProgressAccumulator();
-
-      // Capture progress from this mesh
-      progress->RegisterSource(m_VTKPipeline->GetProgressAccumulator(), info.Count);
       }
     }
 
-  // Now compute the meshes
+  // Collect the labels whose meshes must be recomputed, each with its padded
+  // bounding box, and schedule the largest ones first to keep all threads busy
+  struct MeshJob
+  {
+    LabelType Label;
+    InputImageType::RegionType Region;
+    MeshInfo *Info;
+  };
+
+  std::vector<MeshJob> jobs;
   for(MeshInfoMap::iterator it = m_MeshInfo.begin(); it != m_MeshInfo.end(); it++)
     {
     if(it->second.Mesh == NULL)
       {
-      // Create the mesh
       MeshInfo &mi = it->second;
       mi.Mesh = vtkSmartPointer<vtkPolyData>::New();
 
-      // TODO: make this more elegant
-      InputImageType::RegionType bbWiderRegion;
+      MeshJob job;
+      job.Label = it->first;
+      job.Info = &mi;
       for(int d = 0; d < 3; d++)
         {
         unsigned long len =
             (unsigned long) (1 + mi.BoundingBox[1][d] - mi.BoundingBox[0][d]);
-        bbWiderRegion.SetIndex(d, mi.BoundingBox[0][d]);
-        bbWiderRegion.SetSize(d, len);
+        job.Region.SetIndex(d, mi.BoundingBox[0][d]);
+        job.Region.SetSize(d, len);
         }
-      bbWiderRegion.PadByRadius(5);
-      bbWiderRegion.Crop(m_InputImage->GetLargestPossibleRegion());
+      job.Region.PadByRadius(5);
+      job.Region.Crop(m_InputImage->GetLargestPossibleRegion());
+      jobs.push_back(job);
+      }
+    }
 
-      // Pass the region to the ROI filter and propagate the filter
-      m_ROIFilter->SetInput(m_InputImage);
-      m_ROIFilter->SetRegionOfInterest(bbWiderRegion);
-      m_ROIFilter->Update();
+  std::stable_sort(jobs.begin(), jobs.end(), [](const MeshJob &a, const MeshJob &b)
+    { return a.Region.GetNumberOfPixels() > b.Region.GetNumberOfPixels(); });
+
+  // The accumulator is not thread-safe, so the workers only record the
+  // progress of their meshes, and this thread passes it on
+  size_t n_jobs = jobs.size();
+  std::vector<std::atomic<float> > job_progress(n_jobs);
+  std::vector<SmartPtr<itk::CStyleCommand> > job_commands(n_jobs);
+  std::vector<void *> job_sources(n_jobs);
+  for(size_t i = 0; i < n_jobs; i++)
+    {
+    job_progress[i] = 0.0f;
+    job_commands[i] = itk::CStyleCommand::New();
+    job_commands[i]->SetClientData(&job_progress[i]);
+    job_commands[i]->SetCallback(
+          [](itk::Object *caller, const itk::EventObject &, void *cd)
+      {
+      static_cast<std::atomic<float> *>(cd)->store(
+            std::min(0.99f, (float) static_cast<itk::ProcessObject *>(caller)->GetProgress()));
+      });
+    job_sources[i] = progress->RegisterGenericSource(1, jobs[i].Info->Count);
+    }
 
-      // Set the parameters for the thresholding filter
-      m_ThrehsoldFilter->SetLowerThreshold(it->first);
-      m_ThrehsoldFilter->SetUpperThreshold(it->first);
-      m_ThrehsoldFilter->UpdateLargestPossibleRegion();
+  std::mutex input_mutex, done_mutex;
+  std::condition_variable done_cv;
+  std::atomic<size_t> next_job(0);
+  size_t n_done = 0;
+  std::vector<char> failed(n_jobs, 0);
+  std::exception_ptr error;
 
-      // Graft the polydata to the last filter in the pipeline
-      m_VTKPipeline->SetImage(m_ThrehsoldFilter->GetOutput());
-      m_VTKPipeline->ComputeMesh(it->second.Mesh);
+  auto worker = [&]()
+    {
+    for(size_t i = next_job++; i < n_jobs; i = next_job++)
+      {
+      try
+        {
+        this->ComputeLabelMesh(jobs[i].Label, jobs[i].Region, jobs[i].Info->Mesh,
+                               &input_mutex, job_commands[i]);
+        }
+      catch(...)
+        {
+        // Keep the first error, to be rethrown once all workers are done
+        std::lock_guard<std::mutex> lock(done_mutex);
+        failed[i] = 1;
+        if(!error)
+          error = std::current_exception();
+        }
 
-      // Update progress
-      progress->StartNextRun(m_VTKPipeline->GetProgressAccumulator());
+      std::lock_guard<std::mutex> lock(done_mutex);
+      job_progress[i] = 1.0f;
+      n_done++;
+      done_cv.notify_one();
+      }
+    };
+
+  // Each worker runs its filters on a single thread (see ComputeLabelMesh),
+  // so the workers alone keep the processors busy
+  size_t n_threads = std::min(
+        n_jobs, (size_t) itk::MultiThreaderBase::GetGlobalDefaultNumberOfThreads());
+  std::vector<std::thread> threads;
+  for(size_t t = 0; t < n_threads; t++)
+    threads.push_back(std::thread(worker));
+
+  // Report progress until all meshes are done
+  std::vector<float> reported(n_jobs, -1.0f);
+  bool all_done = (n_jobs == 0);
+  while(true)
+    {
+    for(size_t i = 0; i < n_jobs; i++)
+      {
+      float p = job_progress[i];
+      if(p > reported[i])
+        {
+        AllPurposeProgressAccumulator::GenericProgressCallback(job_sources[i], p);
+        reported[i] = p;
+        }
       }
+
+    if(all_done)
+      break;
+
+    std::unique_lock<std::mutex> lock(done_mutex);
+    all_done = done_cv.wait_for(lock, std::chrono::milliseconds(100),
+                                [&]() { return n_done == n_jobs; });
+    }
+
+  for(size_t t = 0; t < threads.size(); t++)
+    threads[t].join();
+
+  for(size_t i = 0; i < n_jobs; i++)
+    {
+    progress->UnregsterGenericSource(job_sources[i]);
+    if(failed[i])
+      m_MeshInfo.erase(jobs[i].Label);
     }
 
   // Clean up the progress
@@ -331,6 +470,10 @@ void MultiLabelMeshPipeline::UpdateMeshes(itk::Command *progressCommand)
 
   // Set the modified flag, so we can use the pipeline's MTime
   this->Modified();
+
+  // Meshes that failed are recomputed on the next update
+  if(error)
+    std::rethrow_exception(error);
 }
 
 void 
@@ -44,6 +44,7 @@
 #include "ImageWrapperTraits.h"
 #include "RLERegionOfInterestImageFilter.h"
 #include "RLEImageScanlineIterator.h"
+#include <mutex>
 
 
 // Forward reference to itk classes
@@ -129,7 +130,10 @@ public:
    * the color label is not present in the image */
   bool ComputeMesh(LabelType label, vtkPolyData *outData);
 
-  /** Update the meshes */
+  /**
+   * Update the meshes. The meshes of labels that changed are computed in
+   * parallel, largest bounding box first, each by its own pipeline.
+   */
   void UpdateMeshes(itk::Command *progressCommand);
 
   /** Get the collection of computed meshes */
@@ -184,6 +188,12 @@ private:
   // The VTK pipeline
   VTKMeshPipeline *           m_VTKPipeline;
 
+  // Compute the mesh of one label within a region with pipeline objects of
+  // its own. The input image is only accessed while holding the mutex
+  void ComputeLabelMesh(
+      LabelType label, const itk::ImageRegion<3> &region, vtkPolyData *mesh,
+      std::mutex *input_mutex, itk::Command *progress);
+
   // Helper routine for the update command
   void UpdateMeshInfoHelper(
       MeshInfo *current_meshinfo,
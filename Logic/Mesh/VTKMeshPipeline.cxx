@@ -114,6 +114,14 @@ VTKMeshPipeline
   m_DecimateFilter->Delete();
 }
 
+void
+VTKMeshPipeline
+::SetNumberOfThreads(int n)
+{
+  // Of the filters in the pipeline, only the image smoothing is threaded
+  m_VTKGaussianFilter->SetNumberOfThreads(n);
+}
+
 void
 VTKMeshPipeline
 ::SetMeshOptions(MeshOptions *options)
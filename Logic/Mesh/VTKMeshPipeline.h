@@ -89,6 +89,9 @@ public:
   /** Set the mesh options for this filter */
   void SetMeshOptions(MeshOptions *options);
 
+  /** Set the number of threads used by the multi-threaded filters */
+  void SetNumberOfThreads(int n);
+
   /** Compute a mesh for a particular color label */
   void ComputeMesh(vtkPolyData *outData, std::mutex *mutex = nullptr);
 
@@ -1,8 +1,15 @@
 #include "EMGaussianMixtures.h"
+#include "itkMultiThreaderBase.h"
+#include <itkTimeProbe.h>
+#include <vnl/vnl_math.h>
 #include <iostream>
-#include <ctime>
+#include <algorithm>
+#include <limits>
+
+const int EMGaussianMixtures::BLOCK_SIZE;
+const int EMGaussianMixtures::CHUNK_SIZE;
 
-EMGaussianMixtures::EMGaussianMixtures(double **x, int dataSize, int dataDim, int numOfClass)
+EMGaussianMixtures::EMGaussianMixtures(const double *x, int dataSize, int dataDim, int numOfClass)
   :m_x(x), m_numOfData(dataSize), m_dimOfGaussian(dataDim), m_numOfGaussian(numOfClass), m_setPriorFlag(0), m_numOfIteration(0), m_fail(0)
 {
   m_latent = new double*[dataSize];
@@ -28,7 +35,10 @@ EMGaussianMixtures::EMGaussianMixtures(double **x, int dataSize, int dataDim, in
 
   m_maxIteration = 30;
   m_precision = 1.0e-7;
-  m_logLikelihood = std::numeric_limits<double>::infinity();
+  m_logLikelihood = -std::numeric_limits<double>::infinity();
+  m_LastIterationTime = 0.0;
+
+  m_weightedSum.resize(numOfClass * dataDim);
 }
 
 EMGaussianMixtures::~EMGaussianMixtures()
@@ -48,7 +58,7 @@ void EMGaussianMixtures::Reset(void)
 {
   m_numOfIteration = 0;
   m_fail = 0;
-  m_logLikelihood = std::numeric_limits<double>::infinity();
+  m_logLikelihood = -std::numeric_limits<double>::infinity();
   for (int i = 0; i < m_numOfData*m_numOfGaussian; i++)
     {
     m_probs[i] = 0;
@@ -102,24 +112,40 @@ int EMGaussianMixtures::GetMaxIteration(void)
   return m_maxIteration;
 }
 
+int EMGaussianMixtures::GetNumberOfBlocks() const
+{
+  return (m_numOfData + BLOCK_SIZE - 1) / BLOCK_SIZE;
+}
+
+double EMGaussianMixtures::GetLogLikelihoodChange(double logLikelihood) const
+{
+  // The log-likelihood is summed over the samples, so its rounding error
+  // and its change per iteration both grow with the number of samples.
+  // Before the first iteration the change is infinite
+  return (logLikelihood - m_logLikelihood) / std::max(m_numOfData, 1);
+}
+
 double ** EMGaussianMixtures::Update(void)
 {
-  double currentLogLikelihood = 0;
   m_numOfIteration = 0;
   m_fail = 0;
-  while ((fabs(m_logLikelihood - currentLogLikelihood) > m_precision) && (m_numOfIteration < m_maxIteration))
+  m_logLikelihood = -std::numeric_limits<double>::infinity();
+  bool converged = false;
+  while (!converged && (m_numOfIteration < m_maxIteration))
     {
-    if (m_logLikelihood < currentLogLikelihood)
+    ++m_numOfIteration;
+    EvaluatePDF();
+    double currentLogLikelihood = EvaluateLogLikelihood();
+    double change = GetLogLikelihoodChange(currentLogLikelihood);
+    if (change < -m_precision)
       {
       m_fail = 1;
-      std::cout << "!!!!!! Log Likelihood increase, EM fails" << std::endl;
+      std::cout << "!!!!!! Log Likelihood decrease, EM fails" << std::endl;
       std::cout << "old=" <<m_logLikelihood << std::endl << "new=" << currentLogLikelihood << std::endl;
       // break;
       }
-    ++m_numOfIteration;
+    converged = (fabs(change) <= m_precision);
     m_logLikelihood = currentLogLikelihood;
-    EvaluatePDF();
-    currentLogLikelihood = EvaluateLogLikelihood();
     UpdateLatent();
     UpdateMean();
     UpdateCovariance();
@@ -139,23 +165,18 @@ double ** EMGaussianMixtures::Update(void)
 
 double ** EMGaussianMixtures::UpdateOnce(void)
 {
-  long start = 0;
-  long end = 0;
-  start = clock();
+  itk::TimeProbe probe;
+  probe.Start();
   EvaluatePDF();
-  end = clock();
-  std::cout << "evaluate pdf spending " << (end-start)/1000 << std::endl;
-  start = clock();
   double currentLogLikelihood = EvaluateLogLikelihood();
-  end = clock();
-  std::cout << "evaluate likelihood spending " << (end-start)/1000 << std::endl;
-  if (m_logLikelihood < currentLogLikelihood)
+  double change = GetLogLikelihoodChange(currentLogLikelihood);
+  if (change < -m_precision)
     {
     m_fail = 1;
-    std::cout << "!!!!!! Log Likelihood increase, EM fails" << std::endl;
+    std::cout << "!!!!!! Log Likelihood decrease, EM fails" << std::endl;
     std::cout << "old=" <<m_logLikelihood << std::endl << "new=" << currentLogLikelihood << std::endl;
     }
-  if (fabs(m_logLikelihood - currentLogLikelihood) <= m_precision)
+  if (fabs(change) <= m_precision)
     {
     std::cout << "Log Likelihood converged" << std::endl;
     }
@@ -166,25 +187,15 @@ double ** EMGaussianMixtures::UpdateOnce(void)
   ++m_numOfIteration;
   m_logLikelihood = currentLogLikelihood;
   
-  start = clock();
   UpdateLatent();
-  end = clock();
-  std::cout << "latent spending " << (end-start)/1000 << std::endl;
-  start = clock();
   UpdateMean();
-  end = clock();
-  std::cout << "mean spending " << (end-start)/1000 << std::endl;
-  start = clock();
   UpdateCovariance();
-  end = clock();
-  std::cout << "covariance spending " << (end-start)/1000 << std::endl;
   if (m_setPriorFlag == 0)
     {
-    start = clock();
     UpdateWeight();
-    end = clock();
-    std::cout << "weight spending " << (end-start)/1000 << std::endl;
     }
+  probe.Stop();
+  m_LastIterationTime = probe.GetTotal() * 1000;
 
   std::cout << std::endl <<"=====================" << std::endl;
   std::cout << "After " << m_numOfIteration << " Iteration:" << std::endl;
@@ -194,15 +205,182 @@ double ** EMGaussianMixtures::UpdateOnce(void)
   return m_latent;
 }
 
+void EMGaussianMixtures::UpdateOnceFromDataSource(const DataSource *source)
+{
+  itk::TimeProbe probe;
+  probe.Start();
+
+  int nd = m_dimOfGaussian, ng = m_numOfGaussian;
+  assert(source->GetNumberOfComponents() == nd);
+
+  itk::SizeValueType nData = source->GetNumberOfSamples();
+  itk::SizeValueType nChunks = (nData + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+  vnl_vector<double> w(ng), log_w(ng);
+  bool *skip = new bool[ng];
+  for (int j = 0; j < ng; j++)
+    {
+    w[j] = m_gmm->GetWeight(j);
+    log_w[j] = log(w[j]);
+    skip[j] = m_gmm->GetGaussian(j)->isDeltaFunction();
+    }
+
+  // The second moments are taken about the current means, which are close
+  // to the new ones, to avoid cancellation when the covariances are formed.
+  // Empty clusters have infinite means, and zero is used instead
+  vnl_matrix<double> shift(ng, nd, 0.0);
+  for (int j = 0; j < ng; j++)
+    {
+    const VectorType &mean = m_gmm->GetMean(j);
+    for (int k = 0; k < nd; k++)
+      if (vnl_math::isfinite(mean[k]))
+        shift(j, k) = mean[k];
+    }
+
+  // The statistics of a chunk are, for each cluster, the sum of posteriors,
+  // the sums of the shifted samples weighted by the posteriors, and the upper
+  // triangle of the weighted sums of their products. The log-likelihood of
+  // the chunk comes last. The chunks are added in order, so that the result
+  // does not depend on the number of threads
+  int nTri = nd * (nd + 1) / 2;
+  int nStat = ng * (1 + nd + nTri) + 1;
+  std::vector<double> chunkStats(nChunks * nStat, 0.0);
+
+  itk::MultiThreaderBase::Pointer mt = itk::MultiThreaderBase::New();
+  mt->ParallelizeArray(
+        0, nChunks,
+        [&](itk::SizeValueType chunk)
+    {
+    double *s0 = &chunkStats[chunk * nStat];
+    double *s1 = s0 + ng;
+    double *s2 = s1 + ng * nd;
+    double &loglik = s2[ng * nTri];
+
+    // Samples, log-densities and posteriors of a block, and the samples less
+    // the shift of one cluster, all component by component
+    std::vector<double> x(nd * BLOCK_SIZE), d(nd * BLOCK_SIZE);
+    std::vector<double> log_pdf(ng * BLOCK_SIZE), post(ng * BLOCK_SIZE);
+    std::vector<double> scratch(2 * BLOCK_SIZE);
+
+    itk::SizeValueType chunkEnd = std::min((chunk + 1) * CHUNK_SIZE, nData);
+    for (itk::SizeValueType first = chunk * CHUNK_SIZE; first < chunkEnd; first += BLOCK_SIZE)
+      {
+      int n = (int) std::min((itk::SizeValueType) BLOCK_SIZE, chunkEnd - first);
+      source->GetSamples(first, n, &x[0]);
+
+      for (int j = 0; j < ng; j++)
+        m_gmm->GetGaussian(j)->EvaluateLogPDF(
+              &x[0], n, n, &log_pdf[j], ng, &scratch[0]);
+
+      for (int s = 0; s < n; s++)
+        {
+        double *lp = &log_pdf[s * ng];
+        loglik += LogMixtureDensity(ng, lp, w.data_block(), skip);
+        for (int j = 0; j < ng; j++)
+          post[j * n + s] = ComputePosterior(ng, lp, w.data_block(), log_w.data_block(), j);
+        }
+
+      for (int j = 0; j < ng; j++)
+        {
+        const double *p = &post[j * n];
+        for (int k = 0; k < nd; k++)
+          {
+          double c = shift(j, k);
+          for (int s = 0; s < n; s++)
+            d[k * n + s] = x[k * n + s] - c;
+          }
+
+        double t = 0;
+        for (int s = 0; s < n; s++)
+          t += p[s];
+        s0[j] += t;
+
+        for (int k = 0, q = 0; k < nd; k++)
+          {
+          const double *dk = &d[k * n];
+          t = 0;
+          for (int s = 0; s < n; s++)
+            t += p[s] * dk[s];
+          s1[j * nd + k] += t;
+
+          for (int l = k; l < nd; l++, q++)
+            {
+            const double *dl = &d[l * n];
+            t = 0;
+            for (int s = 0; s < n; s++)
+              t += p[s] * dk[s] * dl[s];
+            s2[j * nTri + q] += t;
+            }
+          }
+        }
+      }
+    }, nullptr);
+
+  delete[] skip;
+
+  std::vector<double> stats(nStat, 0.0);
+  for (itk::SizeValueType c = 0; c < nChunks; c++)
+    for (int i = 0; i < nStat; i++)
+      stats[i] += chunkStats[c * nStat + i];
+
+  const double *s0 = &stats[0];
+  const double *s1 = s0 + ng;
+  const double *s2 = s1 + ng * nd;
+
+  ++m_numOfIteration;
+  m_logLikelihood = stats[nStat - 1];
+
+  // The M step, as in UpdateMean, UpdateCovariance and UpdateWeight:
+  // clusters with no weight get an infinite mean and a zero covariance
+  for (int j = 0; j < ng; j++)
+    {
+    VectorType mean(nd);
+    MatrixType cov(nd, nd, 0.0);
+    if (s0[j] > 0)
+      {
+      VectorType dm(nd);
+      for (int k = 0; k < nd; k++)
+        {
+        dm[k] = s1[j * nd + k] / s0[j];
+        mean[k] = shift(j, k) + dm[k];
+        }
+
+      for (int k = 0, q = 0; k < nd; k++)
+        for (int l = k; l < nd; l++, q++)
+          cov(k, l) = cov(l, k) = s2[j * nTri + q] / s0[j] - dm[k] * dm[l];
+      }
+    else
+      {
+      mean.fill(-std::numeric_limits<double>::infinity());
+      }
+
+    m_gmm->SetGaussian(j, mean, cov);
+    m_gmm->SetWeight(j, s0[j] / nData);
+    }
+
+  probe.Stop();
+  m_LastIterationTime = probe.GetTotal() * 1000;
+}
+
 void EMGaussianMixtures::EvaluatePDF(void)
 {
-  for (int i = 0; i < m_numOfData; i++)
+  // Each block of samples is evaluated for each Gaussian in turn
+  itk::MultiThreaderBase::Pointer mt = itk::MultiThreaderBase::New();
+  mt->ParallelizeArray(
+        0, GetNumberOfBlocks(),
+        [this](itk::SizeValueType block)
     {
+    int first = block * BLOCK_SIZE;
+    int n = std::min(BLOCK_SIZE, m_numOfData - first);
+    std::vector<double> scratch(2 * n);
     for (int j = 0; j < m_numOfGaussian; j++)
       {
-      m_log_pdf[i][j] = m_gmm->EvaluateLogPDF(j, m_x[i]);
+      m_gmm->GetGaussian(j)->EvaluateLogPDF(
+            m_x + first, n, m_numOfData,
+            &m_log_pdf[first][j], m_numOfGaussian, &scratch[0]);
       }
-    }
+    }, nullptr);
+
   if (m_setPriorFlag == 0)
     {
     for (int j = 0; j < m_numOfGaussian; j++)
@@ -212,8 +390,6 @@ void EMGaussianMixtures::EvaluatePDF(void)
     }
 }
 
-#include <vnl/vnl_math.h>
-
 double EMGaussianMixtures::ComputePosterior(int nGauss, double *log_pdf, double *w, double *log_w, int j)
 {
   // Instead of directly computing the expression
@@ -266,72 +442,63 @@ double EMGaussianMixtures::ComputePosterior(int nGauss, double *log_pdf, double
 
 void EMGaussianMixtures::UpdateLatent(void)
 {
-  double sum = 0;
-  for (int i = 0; i < m_numOfGaussian; i++)
-    {
-    m_sum[i] = 0;
-    }
+  int nBlocks = GetNumberOfBlocks();
+  int nSum = m_numOfGaussian * (1 + m_dimOfGaussian);
 
   // Compute log of the weights and store in logw
   vnl_vector<double> logw(m_numOfGaussian);
   for(int i = 0; i < m_numOfGaussian; i++)
     logw(i) = log(m_weight[i]);
-  
+
+  // For each block, the sums of the latent variables of each class, followed
+  // by the sums of the data weighted by them, which are used by UpdateMean
+  std::vector<double> blockSums(nBlocks * nSum, 0.0);
+
   if (m_setPriorFlag == 0)
     {
-    for (int i = 0; i < m_numOfData; i++)
+    itk::MultiThreaderBase::Pointer mt = itk::MultiThreaderBase::New();
+    mt->ParallelizeArray(
+          0, nBlocks,
+          [&](itk::SizeValueType block)
       {
-      for (int j = 0; j < m_numOfGaussian; j++)
-        {
-        m_latent[i][j] = ComputePosterior(m_numOfGaussian, m_log_pdf[i], m_weight, logw.data_block(), j);
-        m_sum[j] += m_latent[i][j];
-        }
-
-
-      /*
-      sum = 0;
-      for (int j = 0; j < m_numOfGaussian; j++)
-        {
-        m_tmp1[j] = m_weight[j] * m_pdf[i][j];
-        sum += m_tmp1[j];
-        }
-      if(sum == 0)
+      int first = block * BLOCK_SIZE;
+      int last = std::min(first + BLOCK_SIZE, m_numOfData);
+      double *sum = &blockSums[block * nSum];
+      double *wsum = sum + m_numOfGaussian;
+      for (int i = first; i < last; i++)
         {
         for (int j = 0; j < m_numOfGaussian; j++)
           {
-          m_latent[i][j] = 1.0 / m_numOfGaussian;
-          m_sum[j] += m_latent[i][j];
+          m_latent[i][j] = ComputePosterior(m_numOfGaussian, m_log_pdf[i], m_weight, logw.data_block(), j);
+          sum[j] += m_latent[i][j];
           }
         }
-      else
+
+      for (int j = 0; j < m_numOfGaussian; j++)
         {
-        for (int j = 0; j < m_numOfGaussian; j++)
+        for (int k = 0; k < m_dimOfGaussian; k++)
           {
-          m_latent[i][j] = m_tmp1[j] / sum;
-          m_sum[j] += m_latent[i][j];
+          const double *xk = m_x + (size_t) k * m_numOfData;
+          double t = 0;
+          for (int i = first; i < last; i++)
+            t += m_latent[i][j] * xk[i];
+          wsum[j * m_dimOfGaussian + k] = t;
           }
         }
-        */
-      }
+      }, nullptr);
     }
-  else
+
+  // Add up the blocks in order
+  for (int j = 0; j < m_numOfGaussian; j++)
+    m_sum[j] = 0;
+  std::fill(m_weightedSum.begin(), m_weightedSum.end(), 0.0);
+  for (int b = 0; b < nBlocks; b++)
     {
-    /**= THIS IS NOT USED
-    for (int i = 0; i < m_numOfData; i++)
-      {
-      sum = 0;
-      for (int j = 0; j < m_numOfGaussian; j++)
-        {
-        m_tmp1[j] = m_prior[i][j] * m_pdf[i][j];
-        sum += m_tmp1[j];
-        }
-      for (int j = 0; j < m_numOfGaussian; j++)
-        {
-        m_latent[i][j] = m_tmp1[j] / sum;
-        m_sum[j] += m_latent[i][j];
-        }
-      }
-      */
+    const double *sum = &blockSums[b * nSum];
+    for (int j = 0; j < m_numOfGaussian; j++)
+      m_sum[j] += sum[j];
+    for (size_t q = 0; q < m_weightedSum.size(); q++)
+      m_weightedSum[q] += sum[m_numOfGaussian + q];
     }
 }
 
@@ -339,88 +506,97 @@ void EMGaussianMixtures::UpdateMean(void)
 {
   for (int i = 0; i < m_numOfGaussian; i++)
     {
-    for (int j = 0; j < m_dimOfGaussian; j++)
-      {
-      m_tmp2[j] = 0;
-      }
-    
-    for (int j = 0; j < m_numOfData; j++)
-      {
-      for (int k = 0; k < m_dimOfGaussian; k++)
-        {
-        m_tmp2[k] += m_latent[j][i] * m_x[j][k];
-        }
-      }
-
     // This can lead to a possible divide by zero situation. In case the sum
     // of latent variables for class i is zero, we set the mean of that class
     // to infinity
-    if(m_sum[i] > 0)
-      {
-      for (int j = 0; j < m_dimOfGaussian; j++)
-        {
-        m_tmp2[j] = m_tmp2[j] / m_sum[i];
-        }
-      }
-    else
+    for (int j = 0; j < m_dimOfGaussian; j++)
       {
-      for (int j = 0; j < m_dimOfGaussian; j++)
-        {
+      if(m_sum[i] > 0)
+        m_tmp2[j] = m_weightedSum[i * m_dimOfGaussian + j] / m_sum[i];
+      else
         m_tmp2[j] = - std::numeric_limits<double>::infinity();
-        }
       }
 
-
     m_gmm->SetMean(i, VectorType(m_tmp2, m_dimOfGaussian));
     }
 }
 
 void EMGaussianMixtures::UpdateCovariance(void)
 {
-  for (int i = 0; i < m_numOfGaussian; i++)
+  int nBlocks = GetNumberOfBlocks();
+  int dim = m_dimOfGaussian, nCov = dim * dim;
+
+  // Per-block sums of the weighted outer products, upper triangle only
+  std::vector<double> blockSums((size_t) nBlocks * m_numOfGaussian * nCov, 0.0);
+
+  itk::MultiThreaderBase::Pointer mt = itk::MultiThreaderBase::New();
+  mt->ParallelizeArray(
+        0, nBlocks,
+        [&](itk::SizeValueType block)
     {
-    const VectorType &current_mean = m_gmm->GetMean(i);
-    
-    for (int j = 0; j < m_dimOfGaussian; j++)
-      {
-      for (int k = 0; k < m_dimOfGaussian; k++)
-        {
-        m_tmp3[j*m_dimOfGaussian+k] = 0;
-        }
-      }
-    
-    for (int j = 0; j < m_numOfData; j++)
+    int first = block * BLOCK_SIZE;
+    int n = std::min(BLOCK_SIZE, m_numOfData - first);
+
+    // Mean-subtracted data of the block, component by component
+    std::vector<double> d((size_t) dim * n);
+    for (int i = 0; i < m_numOfGaussian; i++)
       {
-      for (int k = 0; k < m_dimOfGaussian; k++)
+      const VectorType &current_mean = m_gmm->GetMean(i);
+      for (int k = 0; k < dim; k++)
         {
-        m_tmp2[k] = m_x[j][k] - current_mean[k];
+        const double *xk = m_x + (size_t) k * m_numOfData + first;
+        for (int s = 0; s < n; s++)
+          d[k * n + s] = xk[s] - current_mean[k];
         }
-      for (int k = 0; k < m_dimOfGaussian; k++)
+
+      double *cov = &blockSums[((size_t) block * m_numOfGaussian + i) * nCov];
+      for (int k = 0; k < dim; k++)
         {
-        for (int l = 0; l < m_dimOfGaussian; l++)
+        for (int l = k; l < dim; l++)
           {
-          m_tmp3[k*m_dimOfGaussian+l] += m_tmp2[k] * m_tmp2[l] * m_latent[j][i];
+          const double *dk = &d[k * n], *dl = &d[l * n];
+          double t = 0;
+          for (int s = 0; s < n; s++)
+            t += dk[s] * dl[s] * m_latent[first + s][i];
+          cov[k * dim + l] = t;
           }
         }
       }
+    }, nullptr);
+
+  for (int i = 0; i < m_numOfGaussian; i++)
+    {
+    for (int j = 0; j < nCov; j++)
+      m_tmp3[j] = 0;
+
+    for (int b = 0; b < nBlocks; b++)
+      {
+      const double *cov = &blockSums[((size_t) b * m_numOfGaussian + i) * nCov];
+      for (int k = 0; k < dim; k++)
+        for (int l = k; l < dim; l++)
+          m_tmp3[k * dim + l] += cov[k * dim + l];
+      }
+
+    for (int k = 0; k < dim; k++)
+      for (int l = 0; l < k; l++)
+        m_tmp3[k * dim + l] = m_tmp3[l * dim + k];
 
     if(m_sum[i] > 0)
       {
-      for (int j = 0; j < m_dimOfGaussian*m_dimOfGaussian; j++)
+      for (int j = 0; j < nCov; j++)
         {
         m_tmp3[j] = m_tmp3[j] / m_sum[i];
         }
       }
     else
       {
-      for (int j = 0; j < m_dimOfGaussian*m_dimOfGaussian; j++)
+      for (int j = 0; j < nCov; j++)
         {
         m_tmp3[j] = 0.0;
         }
       }
 
-
-    m_gmm->SetCovariance(i, MatrixType(m_tmp3, m_dimOfGaussian, m_dimOfGaussian));
+    m_gmm->SetCovariance(i, MatrixType(m_tmp3, dim, dim));
     }
 }
 
@@ -432,37 +608,61 @@ void EMGaussianMixtures::UpdateWeight(void)
     }
 }
 
-double EMGaussianMixtures::EvaluateLogLikelihood(void)
+double EMGaussianMixtures::LogMixtureDensity(int nGauss, const double *log_pdf, const double *w, const bool *skip)
 {
-  double tmp1 = 0;
-  double tmp2 = 0;
-  if (m_setPriorFlag == 0)
+  // The log of Sum_j[ w[j] * exp(log_pdf[j]) ], computed relative to the
+  // largest term so that the exponentials do not underflow
+  double a_max = -std::numeric_limits<double>::infinity();
+  for (int j = 0; j < nGauss; j++)
     {
-    for (int i = 0; i < m_numOfData; i++)
-      {
-      tmp1 = 0;
-      for (int j = 0; j < m_numOfGaussian; j++)
-        {
-        if(!m_gmm->GetGaussian(j)->isDeltaFunction())
-          tmp1 += m_weight[j] * exp(m_log_pdf[i][j]);
-        }
-      tmp2 += log(tmp1);
-      }
+    if (w[j] > 0 && !skip[j])
+      a_max = std::max(a_max, log(w[j]) + log_pdf[j]);
     }
-  else
+
+  if (a_max == -std::numeric_limits<double>::infinity())
+    return a_max;
+
+  double sum = 0;
+  for (int j = 0; j < nGauss; j++)
     {
-    for (int i = 0; i < m_numOfData; i++)
+    if (w[j] > 0 && !skip[j])
+      sum += exp(log(w[j]) + log_pdf[j] - a_max);
+    }
+  return a_max + log(sum);
+}
+
+double EMGaussianMixtures::EvaluateLogLikelihood(void)
+{
+  // Delta functions do not contribute to the density
+  bool *skip = new bool[m_numOfGaussian];
+  for (int j = 0; j < m_numOfGaussian; j++)
+    skip[j] = m_gmm->GetGaussian(j)->isDeltaFunction();
+
+  // Sum over the samples of each block, then over the blocks in order
+  int nBlocks = GetNumberOfBlocks();
+  std::vector<double> blockSums(nBlocks, 0.0);
+  itk::MultiThreaderBase::Pointer mt = itk::MultiThreaderBase::New();
+  mt->ParallelizeArray(
+        0, nBlocks,
+        [&](itk::SizeValueType block)
+    {
+    int first = block * BLOCK_SIZE;
+    int last = std::min(first + BLOCK_SIZE, m_numOfData);
+    double t = 0;
+    for (int i = first; i < last; i++)
       {
-      tmp1 = 0;
-      for (int j = 0; j < m_numOfGaussian; j++)
-        {
-        if(!m_gmm->GetGaussian(j)->isDeltaFunction())
-          tmp1 += m_prior[i][j] * exp(m_log_pdf[i][j]);
-        }
-      tmp2 += log(tmp1);
+      const double *w = m_setPriorFlag ? m_prior[i] : m_weight;
+      t += LogMixtureDensity(m_numOfGaussian, m_log_pdf[i], w, skip);
       }
-    }
-  return tmp1;
+    blockSums[block] = t;
+    }, nullptr);
+
+  delete[] skip;
+
+  double logLikelihood = 0;
+  for (int b = 0; b < nBlocks; b++)
+    logLikelihood += blockSums[b];
+  return logLikelihood;
 }
 
 void EMGaussianMixtures::PrintParameters(void)
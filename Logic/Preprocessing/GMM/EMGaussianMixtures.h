@@ -3,18 +3,42 @@
 
 #include "GaussianMixtureModel.h"
 #include "SNAPCommon.h"
+#include <itkIntTypes.h>
+#include <vector>
 
 class EMGaussianMixtures
 {
 public:
-  EMGaussianMixtures(double **x, int dataSize, int dataDim, int numOfClass);
+  // The data is stored component by component: component k of sample i is
+  // x[k * dataSize + i]. It is not copied, and must outlive this object
+  EMGaussianMixtures(const double *x, int dataSize, int dataDim, int numOfClass);
   ~EMGaussianMixtures();
 
   typedef Gaussian::MatrixType MatrixType;
   typedef Gaussian::VectorType VectorType;
 
+  /**
+   * Samples that are read when they are needed instead of being kept in
+   * memory, such as the voxels of a large image. GetSamples may be called
+   * from several threads at once.
+   */
+  class DataSource
+  {
+  public:
+    virtual ~DataSource() {}
+
+    virtual itk::SizeValueType GetNumberOfSamples() const = 0;
+    virtual int GetNumberOfComponents() const = 0;
+
+    // Copy n samples starting with sample first, component by component:
+    // component k of sample s goes to x[k * n + s]
+    virtual void GetSamples(itk::SizeValueType first, int n, double *x) const = 0;
+  };
+
   void Reset(void);
   void SetMaxIteration(int maxIteration);
+
+  /** Tolerance on the change of the mean log-likelihood per sample */
   void SetPrecision(double precision);
   void SetParameters(int index,
                      const VectorType &mean,
@@ -31,12 +55,46 @@ public:
 
   double ** Update(void);
   double ** UpdateOnce(void);
+
+  /**
+   * Perform one iteration over all the samples of a data source instead of
+   * the samples in memory. The samples are read in chunks, and only the sums
+   * of the posteriors and of their products with the samples are kept, so
+   * memory use does not depend on the number of samples. The latent
+   * variables are not updated, and the prior is not used. Up to rounding,
+   * the result is the same as UpdateOnce() with the samples in memory.
+   */
+  void UpdateOnceFromDataSource(const DataSource *source);
   double EvaluateLogLikelihood(void);
   void PrintParameters(void);
 
+  /** Log-likelihood of the data before the last iteration */
+  double GetLogLikelihood() const { return m_logLikelihood; }
+
+  /** Wall-clock time of the last iteration, in milliseconds */
+  double GetLastIterationTime() const { return m_LastIterationTime; }
+
   static double ComputePosterior(int nGauss, double *log_pdf, double *w, double *log_w, int j);
 
+  // Log of the mixture density of a sample, leaving out the Gaussians for
+  // which skip[j] is set
+  static double LogMixtureDensity(int nGauss, const double *log_pdf, const double *w, const bool *skip);
+
 private:
+  // The E and M steps process the data in blocks of this many samples, in
+  // parallel. Sums are accumulated per block and added in block order, so
+  // that the results do not depend on the number of threads
+  static const int BLOCK_SIZE = 4096;
+
+  // The samples of a data source are read in chunks of this many samples,
+  // each processed by one thread, one block at a time
+  static const int CHUNK_SIZE = 65536;
+  int GetNumberOfBlocks() const;
+
+  // Change of the mean log-likelihood per sample since the last iteration,
+  // which the precision is compared to whatever the number of samples
+  double GetLogLikelihoodChange(double logLikelihood) const;
+
   void EvaluatePDF(void);
   void UpdateLatent(void);
   void UpdateMean(void);
@@ -46,7 +104,7 @@ private:
   double **m_latent;
   double **m_log_pdf;
   double **m_prior;
-  double **m_x;
+  const double *m_x;
   double *m_probs;
   double *m_probs2;
   double *m_tmp1;
@@ -63,6 +121,10 @@ private:
   int m_setPriorFlag;
   int m_fail;
   double m_precision;
+  double m_LastIterationTime;
+
+  // Sums of the data weighted by the latent variables, from UpdateLatent
+  std::vector<double> m_weightedSum;
 
   SmartPtr<GaussianMixtureModel> m_gmm;
 };
@@ -95,6 +95,46 @@ double Gaussian::EvaluateLogPDF(VectorType &x, VectorType &xscratch)
   return 0.5 * logz;
 }
 
+void Gaussian::EvaluateLogPDF(const double *x, int n, int stride,
+                              double *log_pdf, int out_stride, double *scratch) const
+{
+  // The same arithmetic as above, with the loop over samples innermost
+  double *logz = scratch, *z = scratch + n;
+  for(int s = 0; s < n; s++)
+    logz[s] = 0.0;
+
+  for(int i = 0; i < m_dimension; i++)
+    {
+    for(int s = 0; s < n; s++)
+      z[s] = 0.0;
+
+    for(int j = 0; j < m_dimension; j++)
+      {
+      const double *xj = x + j * stride;
+      double vt = m_Vt(i,j), mj = m_mean_vector[j];
+      for(int s = 0; s < n; s++)
+        z[s] += vt * (xj[s] - mj);
+      }
+
+    if(m_Lambda[i] == 0)
+      {
+      // p(x) = 0 where z[i] != 0. Later terms leave -inf unchanged
+      for(int s = 0; s < n; s++)
+        if(z[s] != 0)
+          logz[s] = -std::numeric_limits<double>::infinity();
+      }
+    else
+      {
+      double nf = m_DiagNormFac[i], lambda = m_Lambda[i];
+      for(int s = 0; s < n; s++)
+        logz[s] -= nf + (z[s] * z[s] / lambda);
+      }
+    }
+
+  for(int s = 0; s < n; s++)
+    log_pdf[s * out_stride] = 0.5 * logz[s];
+}
+
 double Gaussian::EvaluatePDF(double *x)
 {
   // We got to exponentiate somewhere, so might as well do it here
@@ -26,6 +26,14 @@ public:
   // Evaluate log PDF with user-provided scratch buffer
   double EvaluateLogPDF(VectorType &x, VectorType &xscratch);
 
+  // Evaluate log PDF of n samples stored component by component, so that
+  // component d of sample i is x[d * stride + i]. The result for sample i is
+  // written to log_pdf[i * out_stride]. The scratch buffer holds 2n values.
+  // This gives the same values as the single-sample version, and may be
+  // called from several threads with different scratch buffers.
+  void EvaluateLogPDF(const double *x, int n, int stride,
+                      double *log_pdf, int out_stride, double *scratch) const;
+
   void PrintParameters();
 
   // Tests whether the Gaussian is a delta function (i.e., has zero total variance)
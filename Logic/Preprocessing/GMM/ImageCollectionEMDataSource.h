@@ -0,0 +1,55 @@
+#ifndef IMAGE_COLLECTION_EM_DATA_SOURCE_H
+#define IMAGE_COLLECTION_EM_DATA_SOURCE_H
+
+#include "EMGaussianMixtures.h"
+#include "ImageCollectionToImageFilter.h"
+
+/**
+ * The voxels of a collection of scalar and vector images, as samples for
+ * EMGaussianMixtures::UpdateOnceFromDataSource. The samples are the voxels
+ * of the buffered region in buffer order, and their components are those of
+ * the images in the order in which the images were added. The voxels are
+ * read directly from the image buffers.
+ */
+template <class TImage, class TVectorImage>
+class ImageCollectionEMDataSource : public EMGaussianMixtures::DataSource
+{
+public:
+  typedef ImageCollectionConstRegionIteratorWithIndex<TImage, TVectorImage> CollectionIterator;
+  typedef typename TImage::RegionType RegionType;
+
+  /** The region must be the buffered region of all the images */
+  ImageCollectionEMDataSource(const RegionType &region)
+    : m_Iterator(region), m_NumberOfSamples(region.GetNumberOfPixels()) {}
+
+  /** Add an image that must be dynamically castable to either TImage or TVectorImage */
+  void AddImage(itk::DataObject *image)
+  {
+    m_Iterator.AddImage(image);
+    m_NumberOfComponents = m_Iterator.GetTotalComponents();
+  }
+
+  virtual itk::SizeValueType GetNumberOfSamples() const ITK_OVERRIDE
+  {
+    return m_NumberOfSamples;
+  }
+
+  virtual int GetNumberOfComponents() const ITK_OVERRIDE
+  {
+    return m_NumberOfComponents;
+  }
+
+  virtual void GetSamples(itk::SizeValueType first, int n, double *x) const ITK_OVERRIDE
+  {
+    for(int k = 0; k < m_NumberOfComponents; k++)
+      for(int s = 0; s < n; s++)
+        x[k * n + s] = m_Iterator.ValueAtOffset(k, first + s);
+  }
+
+protected:
+  CollectionIterator m_Iterator;
+  itk::SizeValueType m_NumberOfSamples;
+  int m_NumberOfComponents = 0;
+};
+
+#endif // IMAGE_COLLECTION_EM_DATA_SOURCE_H
@@ -2,8 +2,9 @@
 #include "math.h"
 #include "time.h"
 #include "stdlib.h"
+#include <algorithm>
 
-KMeansPlusPlus::KMeansPlusPlus(double **x, int dataSize, int dataDim, int numOfClusters)
+KMeansPlusPlus::KMeansPlusPlus(const double *x, int dataSize, int dataDim, int numOfClusters)
   :m_dataSize(dataSize), m_dataDim(dataDim), m_numOfClusters(numOfClusters)
 {
   m_x = x;
@@ -24,16 +25,23 @@ KMeansPlusPlus::~KMeansPlusPlus()
   delete m_distance;
 }
 
-double KMeansPlusPlus::Distance(const double *x, const double *y)
+double KMeansPlusPlus::Distance(int i, const double *y)
 {
   double tmp = 0;
-  for (int i = 0; i < m_dataDim; i++)
+  for (int k = 0; k < m_dataDim; k++)
   {
-    tmp += (x[i] - y[i]) * (x[i] - y[i]);
+    double d = m_x[k * m_dataSize + i] - y[k];
+    tmp += d * d;
   }
   return sqrt(tmp);
 }
 
+void KMeansPlusPlus::GetSample(int i, double *y)
+{
+  for (int k = 0; k < m_dataDim; k++)
+    y[k] = m_x[k * m_dataSize + i];
+}
+
 void KMeansPlusPlus::Initialize(void)
 {
   // for (int i = 0; i < numOfClusters; i++)
@@ -43,12 +51,15 @@ void KMeansPlusPlus::Initialize(void)
 
   srand(time(0));
 
-  m_centers[0] = (int)(((double) rand() / (double) RAND_MAX) * m_dataSize);
+  Gaussian::VectorType center(m_dataDim);
+
+  m_centers[0] = std::min((int)(((double) rand() / (double) RAND_MAX) * m_dataSize), m_dataSize - 1);
+  GetSample(m_centers[0], center.data_block());
   double distSum = 0;
   for (int i = 0; i < m_dataSize; i++)
     {
     m_xCenter[i] = m_centers[0];
-    m_distance[i] = Distance(m_x[i], m_x[m_centers[0]]);
+    m_distance[i] = Distance(i, center.data_block());
     distSum += m_distance[i];
     }
   m_xCounter[0] = m_dataSize;
@@ -70,12 +81,13 @@ void KMeansPlusPlus::Initialize(void)
         }
       }
 
-    m_centers[i] = idx;
+    m_centers[i] = std::min(idx, m_dataSize - 1);
+    GetSample(m_centers[i], center.data_block());
 
     distSum = 0;
     for (int j = 0; j < m_dataSize; j++)
       {
-      if (m_distance[j] > Distance(m_x[j], m_x[m_centers[i]]))
+      if (m_distance[j] > Distance(j, center.data_block()))
         {
         ++m_xCounter[i];
         for (int k = 0; k < i; k++)
@@ -86,7 +98,7 @@ void KMeansPlusPlus::Initialize(void)
             break;
             }
           }
-        m_distance[j] = Distance(m_x[j], m_x[m_centers[i]]);
+        m_distance[j] = Distance(j, center.data_block());
         m_xCenter[j] = m_centers[i];
         }
       distSum += m_distance[j];
@@ -108,7 +120,7 @@ void KMeansPlusPlus::Initialize(void)
         tmpMean = m_gmm->GetMean(j);
         for (int k = 0; k < m_dataDim; k++)
           {
-          tmpMean[k] = tmpMean[k] + m_x[i][k];
+          tmpMean[k] = tmpMean[k] + m_x[k * m_dataSize + i];
           }
         m_gmm->SetMean(j, tmpMean);
         break;
@@ -146,7 +158,7 @@ void KMeansPlusPlus::Initialize(void)
       {
       if (m_xCenter[i] == m_centers[j])
         {
-        double dist = Distance(m_x[i], m_gmm->GetMean(j).data_block());
+        double dist = Distance(i, m_gmm->GetMean(j).data_block());
         if (radius[j] < dist)
           {
           radius[j] = dist;
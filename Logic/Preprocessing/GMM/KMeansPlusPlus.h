@@ -7,14 +7,18 @@
 class KMeansPlusPlus
 {
 public:
-  KMeansPlusPlus(double **x, int dataSize, int dataDim, int numOfClusters);
+  // The data is stored component by component, as in EMGaussianMixtures
+  KMeansPlusPlus(const double *x, int dataSize, int dataDim, int numOfClusters);
   ~KMeansPlusPlus();
 
-  double Distance(const double *x, const double *y);
+  // Distance between sample i and the point y
+  double Distance(int i, const double *y);
   void Initialize(void);
   GaussianMixtureModel * GetGaussianMixtureModel(void);
 private:
-  double **m_x;
+  void GetSample(int i, double *y);
+
+  const double *m_x;
   int *m_xCenter;
   int *m_centers;
   int *m_xCounter;
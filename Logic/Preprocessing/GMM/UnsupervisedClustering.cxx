@@ -5,6 +5,7 @@
 #include "SNAPImageData.h"
 #include "ImageWrapper.h"
 #include "ImageWrapperTraits.h"
+#include "ImageCollectionEMDataSource.h"
 
 #include <algorithm>
 
@@ -12,8 +13,9 @@ UnsupervisedClustering::UnsupervisedClustering()
 {
   m_ClusteringEM = NULL;
   m_NumberOfClusters = 3;
-  m_DataArray = NULL;
   m_NumberOfSamples = 0;
+  m_UseAllVoxels = false;
+  m_LastIterationTime = 0.0;
 }
 
 UnsupervisedClustering::~UnsupervisedClustering()
@@ -23,17 +25,6 @@ UnsupervisedClustering::~UnsupervisedClustering()
     delete m_ClusteringEM;
     delete m_ClusteringInitializer;
     }
-
-  if(m_DataArray)
-    {
-    // Delete the main data buffer
-    delete m_DataArray[0];
-
-    // Delete the pointers into the buffer
-    delete m_DataArray;
-    }
-
-
 }
 
 
@@ -59,15 +50,6 @@ void UnsupervisedClustering::SetMixtureModel(GaussianMixtureModel *model)
 
 void UnsupervisedClustering::SampleDataSource()
 {
-  if(m_DataArray)
-    {
-    // Delete the main data buffer
-    delete m_DataArray[0];
-
-    // Delete the pointers into the buffer
-    delete m_DataArray;
-    }
-
   // Figure out the number of data components
   unsigned int nComp = 0;
   for(LayerIterator lit = m_DataSource->GetLayers(
@@ -82,10 +64,7 @@ void UnsupervisedClustering::SampleDataSource()
   int nsam = (m_NumberOfSamples == 0) ? nvox : m_NumberOfSamples;
 
   // Create data structure for the EM code
-  m_DataArray = new double *[nsam];
-  double *buffer = new double[nsam * nComp];
-  for(int i = 0; i < nsam; i++, buffer+=nComp)
-    m_DataArray[i] = buffer;
+  m_DataArray.assign((size_t) nsam * nComp, 0.0);
 
   // Create a random walk through the speed image, which should be initialized
   // at this point. We iterate over the speed image because we can easily access
@@ -119,8 +98,12 @@ void UnsupervisedClustering::SampleDataSource()
         !lit.IsAtEnd(); ++lit)
       {
       ImageWrapperBase *iw = lit.GetLayer();
-      vnl_vector<double> svec(m_DataArray[pVoxel] + iOffset, iw->GetNumberOfComponents());
+      vnl_vector<double> svec(iw->GetNumberOfComponents());
       iw->SampleIntensityAtReferenceIndex(idx, iw->GetTimePointIndex(), false, svec);
+
+      // Transpose into the component by component layout
+      for(unsigned int k = 0; k < svec.size(); k++)
+        m_DataArray[(size_t)(iOffset + k) * nsam + pVoxel] = svec[k];
       iOffset += iw->GetNumberOfComponents();
       }
 
@@ -167,7 +150,7 @@ void UnsupervisedClustering::InitializeEM()
   assert(m_DataSource);
 
   // Make sure samples exist
-  if(m_SamplesDirty || m_DataArray == NULL)
+  if(m_SamplesDirty || m_DataArray.empty())
     this->SampleDataSource();
 
   if(m_ClusteringEM)
@@ -178,12 +161,12 @@ void UnsupervisedClustering::InitializeEM()
 
   // Allocate the EM algorithm
   m_ClusteringEM = new EMGaussianMixtures(
-        m_DataArray, m_NumberOfVoxels,
+        &m_DataArray[0], m_NumberOfVoxels,
         m_NumberOfComponents, m_NumberOfClusters);
 
   // Allocate the K means ++
   m_ClusteringInitializer = new KMeansPlusPlus(
-        m_DataArray, m_NumberOfVoxels,
+        &m_DataArray[0], m_NumberOfVoxels,
         m_NumberOfComponents, m_NumberOfClusters);
 
   m_ClusteringInitializer->Initialize();
@@ -195,6 +178,7 @@ void UnsupervisedClustering::InitializeEM()
 
   // Get the GMM
   m_MixtureModel = m_ClusteringEM->GetGaussianMixtureModel();
+  m_LastIterationTime = 0.0;
 
   // Sort the clusters based on center samples
   SortClustersByRelevance();
@@ -203,7 +187,7 @@ void UnsupervisedClustering::InitializeEM()
 void UnsupervisedClustering::SortClustersByRelevance()
 {
   int ng = m_MixtureModel->GetNumberOfGaussians();
-  vnl_vector<double> log_pdf(ng), log_w(ng), w(ng);
+  vnl_vector<double> log_pdf(ng), log_w(ng), w(ng), x(m_NumberOfComponents);
 
   // the array to sort
   typedef std::pair<double, int> RelevancePair;
@@ -220,9 +204,12 @@ void UnsupervisedClustering::SortClustersByRelevance()
   for(unsigned int i = 0; i < m_CenterSamples.size(); i++)
     {
     int s = m_CenterSamples[i];
+    for(int d = 0; d < m_NumberOfComponents; d++)
+      x[d] = m_DataArray[(size_t) d * m_NumberOfVoxels + s];
+
     for(int k = 0; k < ng; k++)
       {
-      log_pdf[k] = m_MixtureModel->EvaluateLogPDF(k, m_DataArray[s]);
+      log_pdf[k] = m_MixtureModel->EvaluateLogPDF(k, x.data_block());
       }
 
     for(int k = 0; k < ng; k++)
@@ -254,8 +241,33 @@ void UnsupervisedClustering::SortClustersByRelevance()
 
 void UnsupervisedClustering::Iterate()
 {
-  m_ClusteringEM->UpdateOnce();
+  if(m_UseAllVoxels)
+    {
+    // The voxels of the layers are read directly from their buffers
+    typedef ImageCollectionEMDataSource<
+        AnatomicScalarImageWrapper::ImageType,
+        AnatomicImageWrapper::ImageType> LayerDataSource;
+
+    LayerDataSource source(
+          m_DataSource->GetMain()->GetImageBase()->GetBufferedRegion());
+    for(LayerIterator it = m_DataSource->GetLayers(MAIN_ROLE | OVERLAY_ROLE);
+        !it.IsAtEnd(); ++it)
+      {
+      source.AddImage(it.GetLayer()->GetImageBase());
+      }
+
+    m_ClusteringEM->UpdateOnceFromDataSource(&source);
+    }
+  else
+    {
+    m_ClusteringEM->UpdateOnce();
+    }
+  m_LastIterationTime = m_ClusteringEM->GetLastIterationTime();
   m_MixtureModel->PrintParameters();
 }
 
+double UnsupervisedClustering::GetLastIterationTime() const
+{
+  return m_LastIterationTime;
+}
 
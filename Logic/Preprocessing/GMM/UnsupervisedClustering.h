@@ -4,6 +4,7 @@
 #include <itkObject.h>
 #include <itkObjectFactory.h>
 #include <SNAPCommon.h>
+#include <vector>
 
 class KMeansPlusPlus;
 class EMGaussianMixtures;
@@ -30,10 +31,22 @@ public:
 
   void SetNumberOfSamples(int nSamples);
 
+  /**
+   * Whether iterations run over all the voxels of the data source, instead
+   * of over the random sample. The voxels are read in chunks directly from
+   * the layers, so memory use does not grow with the size of the image. The
+   * sample is still used to initialize the clusters.
+   */
+  irisGetMacro(UseAllVoxels, bool)
+  irisSetMacro(UseAllVoxels, bool)
+
   void InitializeClusters();
 
   void Iterate();
 
+  /** Wall-clock time of the last iteration in ms, or 0 if there was none */
+  double GetLastIterationTime() const;
+
 
 protected:
 
@@ -54,8 +67,14 @@ protected:
 
   bool m_SamplesDirty;
 
-  // TODO: probably double is larger than we need
-  double **m_DataArray;
+  bool m_UseAllVoxels;
+
+  double m_LastIterationTime;
+
+  // The samples, component by component: component k of sample i is
+  // m_DataArray[k * m_NumberOfVoxels + i]. This layout is used directly by
+  // the EM and k-means code. TODO: probably double is larger than we need
+  std::vector<double> m_DataArray;
 
   // A set of samples located near the center of the image, used to sort
   // initial clusters in terms of relevance to the user
@@ -176,6 +176,30 @@ public:
     return *(dataPtr);
   }
 
+  /** Offset of a voxel in the buffers of the images */
+  OffsetValueType ComputeOffset(const IndexType &index) const
+  {
+    return m_DummyImage->ComputeOffset(index);
+  }
+
+  /** Get a component of the voxel with the given buffer offset */
+  InternalPixelType ValueAtOffset(unsigned int comp, OffsetValueType offset) const
+  {
+    return *(m_Start[comp] + offset * m_OffsetScaling[comp]);
+  }
+
+  /**
+   * Get a component in the neighborhood of the voxel with the given buffer
+   * offset (no bounds check). This does not depend on the position of the
+   * iterator, so it can be called from several threads at once.
+   */
+  InternalPixelType NeighborValueAtOffset(
+      unsigned int comp, unsigned int nbr_idx, OffsetValueType offset) const
+  {
+    offset += m_NeighborhoodOffsetTable[nbr_idx];
+    return *(m_Start[comp] + offset * m_OffsetScaling[comp]);
+  }
+
 protected:
 
   // Collection of scalar images
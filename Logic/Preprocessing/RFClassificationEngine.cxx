@@ -5,6 +5,9 @@
 #include "ImageWrapper.h"
 #include "ImageCollectionToImageFilter.h"
 #include "RLEImageRegionIterator.h"
+#include "itkMultiThreaderBase.h"
+
+#include <algorithm>
 
 // Includes from the random forest library
 #include "Library/classification.h"
@@ -69,20 +72,59 @@ void RFClassificationEngine<TPixel,TLabel,VDim>:: TrainClassifier()
   // TODO: this is defaulting to the first image - is this correct?
   LabelImageWrapper *wrpSeg = m_DataSource->GetFirstSegmentationLayer();
   const LabelImageWrapper::ImageType *imgSeg = wrpSeg->GetImage();
-  typedef itk::ImageRegionConstIteratorWithIndex<LabelImageWrapper::ImageType> LabelIter;
+  typedef LabelImageWrapper::ImageType::BufferType LabelBufferType;
+  typedef LabelImageWrapper::ImageType::RLLine RLLine;
 
   // Shrink the buffered region by radius because we can't handle BCs
   itk::ImageRegion<3> reg = imgSeg->GetBufferedRegion();
   reg.ShrinkByRadius(m_PatchRadius);
 
-  // We need to iterate throught the label image once to determine the
-  // number of samples to allocate.
+  // The examples are read from the runs of the label image, which are
+  // clipped to the region. Each labeled run records the position of its
+  // first voxel in the sample
+  struct SampleRun
+  {
+    itk::Index<3> Start;
+    itk::SizeValueType Length;
+    LabelType Label;
+    unsigned long FirstSample;
+  };
+
+  std::vector<SampleRun> runs;
   unsigned long nSamples = 0;
-  for(LabelIter lit(imgSeg, reg); !lit.IsAtEnd(); ++lit)
-    if(lit.Value())
-      nSamples++;
+  long xLineStart = imgSeg->GetBufferedRegion().GetIndex(0);
+  long xFirst = reg.GetIndex(0), xLast = reg.GetUpperIndex()[0];
+  if(reg.GetNumberOfPixels() > 0)
+    {
+    typedef itk::ImageRegionConstIterator<LabelBufferType> LineIterator;
+    for(LineIterator itLine(imgSeg->GetBuffer(),
+                            LabelImageWrapper::ImageType::truncateRegion(reg));
+        !itLine.IsAtEnd(); ++itLine)
+      {
+      const RLLine &line = itLine.Value();
+      long x = xLineStart;
+      for(size_t i = 0; i < line.size() && x <= xLast; x += line[i].first, i++)
+        {
+        long x0 = std::max(x, xFirst);
+        long x1 = std::min(x + (long) line[i].first - 1, xLast);
+        if(line[i].second && x0 <= x1)
+          {
+          SampleRun run;
+          run.Start[0] = x0;
+          run.Start[1] = itLine.GetIndex()[0];
+          run.Start[2] = itLine.GetIndex()[1];
+          run.Length = x1 - x0 + 1;
+          run.Label = line[i].second;
+          run.FirstSample = nSamples;
+          runs.push_back(run);
+          nSamples += run.Length;
+          }
+        }
+      }
+    }
 
-  // Create an iterator for going over all the anatomical image data
+  // Create an iterator for going over all the anatomical image data. It is
+  // only used to look up the patch features of the labeled voxels
   CollectionIter cit(reg);
   cit.SetRadius(m_PatchRadius);
 
@@ -105,30 +147,36 @@ void RFClassificationEngine<TPixel,TLabel,VDim>:: TrainClassifier()
   // Create a new sample
   m_Sample = new SampleType(nSamples, nColumns);
 
-  // Now fill out the samples
-  int iSample = 0;
-  for(LabelIter lit(imgSeg, reg); !lit.IsAtEnd(); ++lit, ++cit)
+  // Now fill out the samples, with the runs divided between the threads.
+  // Runs fill disjoint rows of the sample, so no locking is needed
+  itk::MultiThreaderBase::Pointer mt = itk::MultiThreaderBase::New();
+  if(runs.size())
     {
-    LabelType label = lit.Value();
-    if(label)
+    mt->ParallelizeArray(
+          0, runs.size(),
+          [&](itk::SizeValueType iRun)
       {
-      // Fill in the data
-      std::vector<GreyType> &column = m_Sample->data[iSample];
-      int k = 0;
-      for(int i = 0; i < nComp; i++)
-        for(int j = 0; j < nPatch; j++)
-          column[k++] = cit.NeighborValue(i,j);
-
-      // Add the coordinate features if used
-      if(m_UseCoordinateFeatures)
-        for(int d = 0; d < 3; d++)
-          column[k++] = lit.GetIndex()[d];
-
-      // Fill in the label
-      m_Sample->label[iSample] = label;
-
-      ++iSample;
-      }
+      const SampleRun &run = runs[iRun];
+      itk::Index<3> idx = run.Start;
+      itk::OffsetValueType offset = cit.ComputeOffset(idx);
+      for(itk::SizeValueType p = 0; p < run.Length; p++, offset++, idx[0]++)
+        {
+        // Fill in the data
+        std::vector<GreyType> &column = m_Sample->data[run.FirstSample + p];
+        int k = 0;
+        for(int i = 0; i < nComp; i++)
+          for(int j = 0; j < nPatch; j++)
+            column[k++] = cit.NeighborValueAtOffset(i, j, offset);
+
+        // Add the coordinate features if used
+        if(m_UseCoordinateFeatures)
+          for(int d = 0; d < 3; d++)
+            column[k++] = idx[d];
+
+        // Fill in the label
+        m_Sample->label[run.FirstSample + p] = run.Label;
+        }
+      }, nullptr);
     }
 
   // Check that the sample has at least two distinct labels
@@ -5,6 +5,7 @@
 #include <vector>
 #include <itkImageBase.h>
 #include <itkImage.h>
+#include <itkMultiThreaderBase.h>
 
 /** Run-Length Encoded image.
 * It saves memory for label images at the expense of processing times.
@@ -211,6 +212,10 @@ public:
             CleanUp(); //put the image into a clean state
     }
 
+    /** Bytes of memory held by the buffered run-length lines, including
+    * line headers. */
+    SizeValueType GetMemoryFootprint() const;
+
     /** Pixel contaner support */
     typedef typename BufferType::PixelContainer PixelContainer;
 
@@ -250,6 +255,9 @@ protected:
     /** Merges adjacent segments with duplicate values in a single line. */
     void CleanUpLine(RLLine & line) const;
 
+    /** Thread pool front end shared by all RLE images, for the line loops. */
+    static itk::MultiThreaderBase *GetLineThreader();
+
 private:
     bool m_OnTheFlyCleanup; //should same-valued segments be merged on the fly
 
@@ -3,6 +3,8 @@
 
 #include "RLEImage.h"
 #include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkMultiThreaderBase.h"
 
 template< typename TPixel, unsigned int VImageDimension, typename CounterType >
 inline typename RLEImage<TPixel, VImageDimension, CounterType>::BufferType::IndexType
@@ -49,13 +51,8 @@ void RLEImage<TPixel, VImageDimension, CounterType>::Allocate(bool initialize)
     this->ComputeOffsetTable();
     //SizeValueType num = static_cast<SizeValueType>(this->GetOffsetTable()[VImageDimension]);
     myBuffer->Allocate(false);
-    //if (initialize) //there is assumption that the image is fully formed after a call to allocate
-    {
-        RLSegment segment(CounterType(this->GetBufferedRegion().GetSize(0)), TPixel());
-        RLLine line(1);
-        line[0] = segment;
-        myBuffer->FillBuffer(line);
-    }
+    //there is assumption that the image is fully formed after a call to allocate
+    FillBuffer(TPixel());
 }
 
 template< typename TPixel, unsigned int VImageDimension, typename CounterType >
@@ -65,15 +62,37 @@ void RLEImage<TPixel, VImageDimension, CounterType>
     RLSegment segment(CounterType(this->GetBufferedRegion().GetSize(0)), value);
     RLLine line(1);
     line[0] = segment;
-    myBuffer->FillBuffer(line);
+
+    //lines are independent, so each thread fills a block of them
+    typedef typename BufferType::RegionType BufferRegionType;
+    if (myBuffer->GetBufferedRegion().GetNumberOfPixels() == 0)
+        return;
+    GetLineThreader()->ParallelizeImageRegion<VImageDimension - 1>(
+        myBuffer->GetBufferedRegion(),
+        [this, &line](const BufferRegionType & region)
+    {
+        for (itk::ImageRegionIterator<BufferType> it(myBuffer, region); !it.IsAtEnd(); ++it)
+            it.Value() = line;
+    }, nullptr);
+}
+
+template< typename TPixel, unsigned int VImageDimension, typename CounterType >
+itk::MultiThreaderBase * RLEImage<TPixel, VImageDimension, CounterType>::GetLineThreader()
+{
+    //created once per calling thread rather than on every fill; the
+    //platform threader keeps per-call state, so it is not shared by threads
+    static thread_local itk::MultiThreaderBase::Pointer threader = itk::MultiThreaderBase::New();
+    return threader;
 }
 
 template< typename TPixel, unsigned int VImageDimension, typename CounterType >
 void RLEImage<TPixel, VImageDimension, CounterType>::CleanUpLine(RLLine & line) const
 {
-    CounterType x = 0;
+    if (line.empty())
+        return;
+    SizeValueType x = 0;
     RLLine out;
-    out.reserve(this->GetLargestPossibleRegion().GetSize(0));
+    out.reserve(line.size());
     do
     {
         out.push_back(line[x]);
@@ -86,13 +105,31 @@ void RLEImage<TPixel, VImageDimension, CounterType>::CleanUpLine(RLLine & line)
 template< typename TPixel, unsigned int VImageDimension, typename CounterType >
 void RLEImage<TPixel, VImageDimension, CounterType>::CleanUp() const
 {
-    assert(!myBuffer.empty());
-    if (this->GetLargestPossibleRegion().GetSize(0) == 0)
+    assert(myBuffer);
+    if (this->GetLargestPossibleRegion().GetSize(0) == 0
+        || myBuffer->GetBufferedRegion().GetNumberOfPixels() == 0)
         return;
-#pragma omp parallel for
-    for (CounterType z = 0; z < myBuffer.size(); z++)
-        for (CounterType y = 0; y < myBuffer[0].size(); y++)
-            CleanUpLine(myBuffer[z][y]);
+
+    //lines are independent, so each thread cleans up a block of them
+    typedef typename BufferType::RegionType BufferRegionType;
+    GetLineThreader()->ParallelizeImageRegion<VImageDimension - 1>(
+        myBuffer->GetBufferedRegion(),
+        [this](const BufferRegionType & region)
+    {
+        for (itk::ImageRegionIterator<BufferType> it(myBuffer, region); !it.IsAtEnd(); ++it)
+            CleanUpLine(it.Value());
+    }, nullptr);
+}
+
+template< typename TPixel, unsigned int VImageDimension, typename CounterType >
+typename RLEImage<TPixel, VImageDimension, CounterType>::SizeValueType
+RLEImage<TPixel, VImageDimension, CounterType>::GetMemoryFootprint() const
+{
+    SizeValueType bytes = 0;
+    itk::ImageRegionConstIterator<BufferType> it(myBuffer, myBuffer->GetBufferedRegion());
+    for (; !it.IsAtEnd(); ++it)
+        bytes += sizeof(RLLine) + it.Value().capacity() * sizeof(RLSegment);
+    return bytes;
 }
 
 template< typename TPixel, unsigned int VImageDimension, typename CounterType >
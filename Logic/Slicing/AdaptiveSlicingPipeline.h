@@ -48,6 +48,7 @@
 #include "itkDataObjectDecorator.h"
 #include "IRISSlicer.h"
 #include "NonOrthogonalSlicer.h"
+#include "ImagePyramid.h"
 #include "SNAPCommon.h"
 
 class ImageCoordinateTransform;
@@ -103,6 +104,9 @@ public:
   typedef IRISSlicer<TInputImage,TOutputImage,TPreviewImage> OrthogonalSlicerType;
   typedef NonOrthogonalSlicer<TInputImage,TOutputImage>   NonOrthogonalSlicerType;
 
+  /** Downsampled versions of the input for zoomed out orthogonal slicing */
+  typedef ImagePyramid<TInputImage>                          ImagePyramidType;
+
   /** Reference space for non-orthogonal slicing */
   typedef typename itk::ImageBase<InputImageDimension> NonOrthogonalSliceReferenceSpace;
 
@@ -151,6 +155,26 @@ public:
   void SetUseNearestNeighbor(bool flag);
   bool GetUseNearestNeighbor() const;
 
+  /**
+   * Supply a slice that was computed elsewhere (e.g., by a background thread
+   * for an upcoming time point) to be used as the output of the next update
+   * instead of slicing the input. The slice is discarded if the slicing
+   * parameters change before that update.
+   */
+  void SetPrecomputedSlice(OutputImageType *slice);
+
+  /**
+   * Supply a resolution pyramid of the input. When set, the orthogonal
+   * slicer extracts the slice from the coarsest level whose voxels are not
+   * larger than the pixels of the viewport, as given by the oblique
+   * reference image. The slice is then smaller than the full-resolution
+   * slice and has a correspondingly larger spacing. Its origin gives the
+   * position of its corner within the full-resolution slice, which is
+   * where the texture for the slice has to be placed.
+   */
+  itkSetObjectMacro(ImagePyramid, ImagePyramidType)
+
+
 protected:
 
   AdaptiveSlicingPipeline();
@@ -175,7 +199,15 @@ protected:
 
   IndexType m_SliceIndex;
 
+  itk::SmartPointer<ImagePyramidType> m_ImagePyramid;
+
+  OutputImagePointer m_PrecomputedSlice;
+  itk::ModifiedTimeType m_PrecomputedSliceMTime;
+
   void MapInputsToSlicers();  
+
+  // Select the pyramid level to use as the input of the orthogonal slicer
+  const InputImageType *GetOrthogonalSlicerInput();
 };
 
 
@@ -56,6 +56,8 @@ AdaptiveSlicingPipeline<TInputImage, TOutputImage, TPreviewImage>
 
   // Initially use the ortho
   m_UseOrthogonalSlicing = true;
+
+  m_PrecomputedSliceMTime = 0;
 }
 
 template<typename TInputImage, typename TOutputImage, typename TPreviewImage>
@@ -74,7 +76,6 @@ AdaptiveSlicingPipeline<TInputImage, TOutputImage, TPreviewImage>
 {
   if(m_UseOrthogonalSlicing)
     {
-    m_OrthogonalSlicer->SetInput(this->GetInput());
     m_OrthogonalSlicer->SetPreviewInput(
           const_cast<PreviewImageType *>(this->GetPreviewImage()));
 
@@ -101,6 +102,9 @@ AdaptiveSlicingPipeline<TInputImage, TOutputImage, TPreviewImage>
     // Set the slice index
     m_OrthogonalSlicer->SetSliceIndex(
           m_SliceIndex[m_OrthogonalSlicer->GetSliceDirectionImageAxis()]);
+
+    // The input depends on the slice direction when a pyramid is used
+    m_OrthogonalSlicer->SetInput(this->GetOrthogonalSlicerInput());
     }
   else
     {
@@ -110,6 +114,42 @@ AdaptiveSlicingPipeline<TInputImage, TOutputImage, TPreviewImage>
     }
 }
 
+template<typename TInputImage, typename TOutputImage, typename TPreviewImage>
+const typename AdaptiveSlicingPipeline<TInputImage, TOutputImage, TPreviewImage>::InputImageType *
+AdaptiveSlicingPipeline<TInputImage, TOutputImage, TPreviewImage>
+::GetOrthogonalSlicerInput()
+{
+  // Previews are computed at full resolution, and the viewport is unknown
+  // until the reference image has been given a size
+  const NonOrthogonalSliceReferenceSpace *viewport = this->GetObliqueReferenceImage();
+  if(!m_ImagePyramid || this->GetPreviewImage() || !viewport
+     || viewport->GetLargestPossibleRegion().GetNumberOfPixels() == 0)
+    return this->GetInput();
+
+  // The size of a viewport pixel along the image axes that are shown
+  // horizontally and vertically
+  typename InputImageType::SpacingType max_spacing;
+  max_spacing.Fill(0.0);
+  max_spacing[m_OrthogonalSlicer->GetPixelDirectionImageAxis()] = viewport->GetSpacing()[0];
+  max_spacing[m_OrthogonalSlicer->GetLineDirectionImageAxis()] = viewport->GetSpacing()[1];
+
+  const InputImageType *level = m_ImagePyramid->GetLevelForSpacing(
+        m_OrthogonalSlicer->GetSliceDirectionImageAxis(), max_spacing);
+
+  return level ? level : this->GetInput();
+}
+
+template<typename TInputImage, typename TOutputImage, typename TPreviewImage>
+void
+AdaptiveSlicingPipeline<TInputImage, TOutputImage, TPreviewImage>
+::SetPrecomputedSlice(OutputImageType *slice)
+{
+  // Remember the state of the slicer, so that the slice is not used if
+  // the slice index or the transforms change in the meantime
+  m_PrecomputedSlice = slice;
+  m_PrecomputedSliceMTime = this->GetMTime();
+}
+
 template<typename TInputImage, typename TOutputImage, typename TPreviewImage>
 void
 AdaptiveSlicingPipeline<TInputImage, TOutputImage, TPreviewImage>
@@ -127,6 +167,30 @@ AdaptiveSlicingPipeline<TInputImage, TOutputImage, TPreviewImage>
     m_OrthogonalSlicer->UpdateOutputInformation();
     m_OrthogonalSlicer->GetOutput()->SetRequestedRegionToLargestPossibleRegion();
     output->CopyInformation(m_OrthogonalSlicer->GetOutput());
+
+    // A pyramid level leaves out the voxels at the high end of each axis that
+    // do not fill a whole block, so it covers less than the full slice. The
+    // origin of the output (the corner of the slice, in slice coordinates) is
+    // moved to where the level starts along axes that are traversed backwards
+    const InputImageType *level = m_OrthogonalSlicer->GetInput();
+    if(level != this->GetInput())
+      {
+      unsigned int axes[] = { m_OrthogonalSlicer->GetPixelDirectionImageAxis(),
+                              m_OrthogonalSlicer->GetLineDirectionImageAxis() };
+      bool forward[] = { m_OrthogonalSlicer->GetPixelTraverseForward(),
+                         m_OrthogonalSlicer->GetLineTraverseForward() };
+
+      typename OutputImageType::PointType origin;
+      for(unsigned int k = 0; k < 2; k++)
+        {
+        double full_extent = this->GetInput()->GetLargestPossibleRegion().GetSize()[axes[k]]
+            * this->GetInput()->GetSpacing()[axes[k]];
+        double level_extent = level->GetLargestPossibleRegion().GetSize()[axes[k]]
+            * level->GetSpacing()[axes[k]];
+        origin[k] = forward[k] ? 0.0 : full_extent - level_extent;
+        }
+      output->SetOrigin(origin);
+      }
     }
   else
     {
@@ -174,11 +238,24 @@ AdaptiveSlicingPipeline<TInputImage, TOutputImage, TPreviewImage>
   // Get the outer filter's output
   OutputImageType *output = this->GetOutput();
 
+  // Use the precomputed slice if it is still current. It is only used once
+  OutputImagePointer precomputed = m_PrecomputedSlice;
+  m_PrecomputedSlice = NULL;
+  if(precomputed && m_PrecomputedSliceMTime == this->GetMTime() && !this->GetPreviewImage())
+    {
+    output->Graft(precomputed);
+    return;
+    }
+
   // Use appropriate sub-pipeline
   if(m_UseOrthogonalSlicing)
     {
+    // Grafting copies the slicer's origin, which does not account for the
+    // pyramid level (see GenerateOutputInformation)
+    typename OutputImageType::PointType origin = output->GetOrigin();
     m_OrthogonalSlicer->Update();
     output->Graft(m_OrthogonalSlicer->GetOutput());
+    output->SetOrigin(origin);
     }
   else
     {
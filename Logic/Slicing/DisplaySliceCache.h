@@ -0,0 +1,164 @@
+#ifndef DISPLAYSLICECACHE_H
+#define DISPLAYSLICECACHE_H
+
+#include "itkImageSource.h"
+#include "itkObjectFactory.h"
+
+#include <functional>
+#include <list>
+
+/**
+ * This filter sits at the end of the display pipeline of an image wrapper
+ * for one of the three views. It keeps copies of the most recently shown
+ * display slices, so that when the user scrolls back to a slice, or toggles
+ * back to a time point, the slice does not have to be extracted and mapped
+ * to RGBA again.
+ *
+ * The slice that is cached is produced by an upstream display pipeline that
+ * is not connected as an input of this filter, so that on a cache hit the
+ * upstream pipeline is not executed at all. Instead, the owner supplies a
+ * function that describes the state that the upstream slice depends on. The
+ * filter re-executes whenever that state changes, and when the state can not
+ * be described (e.g., during oblique slicing or while a preview is shown), it
+ * simply passes the upstream slice through.
+ *
+ * Entries are discarded, least recently used first, when together they take
+ * up more than the maximum amount of memory, and as soon as the mapping or
+ * the geometry they were computed with, or the image data of their time
+ * point, are modified.
+ */
+template <class TSlice>
+class DisplaySliceCache : public itk::ImageSource<TSlice>
+{
+public:
+  /** Standard class typedefs. */
+  typedef DisplaySliceCache                                              Self;
+  typedef itk::ImageSource<TSlice>                                 Superclass;
+  typedef itk::SmartPointer<Self>                                     Pointer;
+  typedef itk::SmartPointer<const Self>                          ConstPointer;
+
+  typedef TSlice                                                    SliceType;
+  typedef itk::SmartPointer<SliceType>                           SlicePointer;
+  typedef typename SliceType::SizeType                              SizeType;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self)
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(DisplaySliceCache, ImageSource)
+
+  /** Everything that the contents of a display slice depend on */
+  struct SliceKey
+  {
+    // Position of the slice along the slice axis, and the time point
+    long SliceIndex;
+    unsigned int TimePoint;
+
+    // Time stamps of the image data of the time point, of the intensity
+    // and color mapping, and of the image to display transform
+    itk::ModifiedTimeType Data, Mapping, Transform;
+
+    // Size of the upstream slice, which changes with the pyramid level
+    SizeType Size;
+
+    bool operator == (const SliceKey &other) const
+    {
+      return SliceIndex == other.SliceIndex && TimePoint == other.TimePoint
+          && Data == other.Data && Mapping == other.Mapping
+          && Transform == other.Transform && Size == other.Size;
+    }
+
+    bool operator != (const SliceKey &other) const
+      { return !(*this == other); }
+  };
+
+  /**
+   * Function that fills out the key for the current state of the upstream
+   * pipeline, except for the size. It should return false if the slice can
+   * not be cached in the current state.
+   */
+  typedef std::function<bool (SliceKey &)> KeyFunction;
+
+  /** Set the output of the display pipeline whose slices are cached */
+  void SetUpstreamSlice(SliceType *slice);
+
+  /** Set the function that describes the state of the upstream pipeline */
+  void SetKeyFunction(const KeyFunction &function);
+
+  /**
+   * Set the memory that the cached slices may take up, in bytes. With zero,
+   * slices are passed through. Slices larger than this are never cached.
+   */
+  void SetMaximumMemory(size_t bytes);
+  itkGetConstMacro(MaximumMemory, size_t)
+
+  /** Get the memory held by the cached slices, in bytes */
+  size_t GetMemoryFootprint() const
+    { return m_MemoryFootprint; }
+
+  /** Get the number of cached slices */
+  size_t GetNumberOfSlices() const
+    { return m_Entries.size(); }
+
+  /** Discard the cached slices */
+  void ReleaseSlices();
+
+  /**
+   * Bring the upstream pipeline's information up to date, and mark this
+   * filter as modified if the slice that it should produce has changed
+   */
+  virtual void UpdateOutputInformation() ITK_OVERRIDE;
+
+protected:
+
+  DisplaySliceCache();
+  ~DisplaySliceCache() {}
+
+  virtual void GenerateOutputInformation() ITK_OVERRIDE;
+
+  virtual void GenerateData() ITK_OVERRIDE;
+
+  // Compute the key for the current state of the upstream pipeline
+  bool ComputeKey(SliceKey &key);
+
+  // Remove the entries that can no longer be used, given the current key
+  void PruneEntries(const SliceKey &key);
+
+  // Remove the least recently used entries until the memory limit is met
+  void TrimEntries(size_t max_bytes);
+
+  // Memory taken up by a copy of a slice of the given size
+  size_t GetSliceMemory(const SizeType &size) const;
+
+  struct Entry
+  {
+    SliceKey Key;
+    SlicePointer Slice;
+    size_t Bytes;
+  };
+
+  // Most recently used entries come first
+  typedef std::list<Entry> EntryList;
+  typedef typename EntryList::iterator EntryIterator;
+
+  // Remove an entry, keeping track of the memory footprint
+  EntryIterator EraseEntry(EntryIterator it);
+
+  SlicePointer m_UpstreamSlice;
+  KeyFunction m_KeyFunction;
+  size_t m_MaximumMemory;
+  size_t m_MemoryFootprint;
+  EntryList m_Entries;
+
+  // The key of the slice currently in the output. When the slice could not
+  // be cached, the time stamp of the upstream slice is kept instead
+  SliceKey m_OutputKey;
+  bool m_OutputCached;
+  itk::ModifiedTimeType m_OutputUpstreamMTime;
+};
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "DisplaySliceCache.txx"
+#endif
+
+#endif // DISPLAYSLICECACHE_H
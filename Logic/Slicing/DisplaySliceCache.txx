@@ -0,0 +1,230 @@
+#ifndef DISPLAYSLICECACHE_TXX
+#define DISPLAYSLICECACHE_TXX
+
+#include "DisplaySliceCache.h"
+
+#include <algorithm>
+
+template <class TSlice>
+DisplaySliceCache<TSlice>
+::DisplaySliceCache()
+{
+  m_MaximumMemory = 0;
+  m_MemoryFootprint = 0;
+  m_OutputKey = SliceKey();
+  m_OutputCached = false;
+  m_OutputUpstreamMTime = 0;
+}
+
+template <class TSlice>
+void
+DisplaySliceCache<TSlice>
+::SetUpstreamSlice(SliceType *slice)
+{
+  if(m_UpstreamSlice != slice)
+    {
+    m_UpstreamSlice = slice;
+    this->ReleaseSlices();
+    this->Modified();
+    }
+}
+
+template <class TSlice>
+void
+DisplaySliceCache<TSlice>
+::SetKeyFunction(const KeyFunction &function)
+{
+  m_KeyFunction = function;
+  this->ReleaseSlices();
+  this->Modified();
+}
+
+template <class TSlice>
+void
+DisplaySliceCache<TSlice>
+::SetMaximumMemory(size_t bytes)
+{
+  if(m_MaximumMemory != bytes)
+    {
+    m_MaximumMemory = bytes;
+    this->TrimEntries(bytes);
+    this->Modified();
+    }
+}
+
+template <class TSlice>
+void
+DisplaySliceCache<TSlice>
+::ReleaseSlices()
+{
+  m_Entries.clear();
+  m_MemoryFootprint = 0;
+}
+
+template <class TSlice>
+typename DisplaySliceCache<TSlice>::EntryIterator
+DisplaySliceCache<TSlice>
+::EraseEntry(EntryIterator it)
+{
+  m_MemoryFootprint -= it->Bytes;
+  return m_Entries.erase(it);
+}
+
+template <class TSlice>
+void
+DisplaySliceCache<TSlice>
+::TrimEntries(size_t max_bytes)
+{
+  while(m_Entries.size() && m_MemoryFootprint > max_bytes)
+    this->EraseEntry(--m_Entries.end());
+}
+
+template <class TSlice>
+bool
+DisplaySliceCache<TSlice>
+::ComputeKey(SliceKey &key)
+{
+  if(m_MaximumMemory == 0 || !m_KeyFunction || !m_KeyFunction(key))
+    return false;
+
+  // Slices that would not fit are passed through
+  key.Size = m_UpstreamSlice->GetLargestPossibleRegion().GetSize();
+  return this->GetSliceMemory(key.Size) <= m_MaximumMemory;
+}
+
+template <class TSlice>
+size_t
+DisplaySliceCache<TSlice>
+::GetSliceMemory(const SizeType &size) const
+{
+  typedef typename SliceType::PixelContainer PixelContainer;
+  size_t n = 1;
+  for(unsigned int d = 0; d < SizeType::Dimension; d++)
+    n *= size[d];
+  return n * sizeof(typename PixelContainer::Element);
+}
+
+template <class TSlice>
+void
+DisplaySliceCache<TSlice>
+::PruneEntries(const SliceKey &key)
+{
+  // Time stamps only increase, so an entry computed with a different mapping
+  // or transform, or from older data of the same time point, is never used
+  EntryIterator it = m_Entries.begin();
+  while(it != m_Entries.end())
+    {
+    const SliceKey &ek = it->Key;
+    if(ek.Mapping != key.Mapping || ek.Transform != key.Transform
+       || (ek.TimePoint == key.TimePoint && ek.Data != key.Data))
+      it = this->EraseEntry(it);
+    else
+      ++it;
+    }
+}
+
+template <class TSlice>
+void
+DisplaySliceCache<TSlice>
+::UpdateOutputInformation()
+{
+  if(m_UpstreamSlice)
+    {
+    // This runs the upstream pipeline's GenerateOutputInformation, which
+    // e.g. selects the pyramid level that the slicer will use
+    m_UpstreamSlice->UpdateOutputInformation();
+
+    // Re-execute if the slice that should be shown is not the one in the
+    // output. When the slice can not be cached, follow the upstream slice
+    SliceKey key;
+    bool cached = this->ComputeKey(key);
+    itk::ModifiedTimeType upstream_mtime =
+        std::max(m_UpstreamSlice->GetPipelineMTime(), m_UpstreamSlice->GetMTime());
+
+    if(cached != m_OutputCached
+       || (cached && key != m_OutputKey)
+       || (!cached && upstream_mtime != m_OutputUpstreamMTime))
+      this->Modified();
+    }
+
+  Superclass::UpdateOutputInformation();
+}
+
+template <class TSlice>
+void
+DisplaySliceCache<TSlice>
+::GenerateOutputInformation()
+{
+  if(m_UpstreamSlice)
+    this->GetOutput()->CopyInformation(m_UpstreamSlice);
+}
+
+template <class TSlice>
+void
+DisplaySliceCache<TSlice>
+::GenerateData()
+{
+  if(!m_UpstreamSlice)
+    return;
+
+  // Look for the slice among the cached ones
+  SliceKey key;
+  bool cached = this->ComputeKey(key);
+  if(cached)
+    {
+    this->PruneEntries(key);
+    for(EntryIterator it = m_Entries.begin(); it != m_Entries.end(); ++it)
+      {
+      if(it->Key == key)
+        {
+        m_Entries.splice(m_Entries.begin(), m_Entries, it);
+        this->GraftOutput(m_Entries.front().Slice);
+        m_OutputKey = key;
+        m_OutputCached = true;
+        return;
+        }
+      }
+    }
+
+  // Run the display pipeline
+  m_UpstreamSlice->SetRequestedRegionToLargestPossibleRegion();
+  m_UpstreamSlice->Update();
+  m_OutputUpstreamMTime =
+      std::max(m_UpstreamSlice->GetPipelineMTime(), m_UpstreamSlice->GetMTime());
+
+  // Updating the pipeline may have advanced some of the time stamps, e.g.,
+  // those of the intensity range, so the key is taken again
+  m_OutputCached = cached && this->ComputeKey(key);
+  if(!m_OutputCached)
+    {
+    this->GraftOutput(m_UpstreamSlice);
+    return;
+    }
+
+  // Keep a copy of the slice, since the upstream buffer is overwritten
+  // when the next slice is computed
+  SlicePointer copy = SliceType::New();
+  copy->CopyInformation(m_UpstreamSlice);
+  copy->SetRegions(m_UpstreamSlice->GetBufferedRegion());
+  copy->Allocate();
+  std::copy(m_UpstreamSlice->GetBufferPointer(),
+            m_UpstreamSlice->GetBufferPointer() + m_UpstreamSlice->GetPixelContainer()->Size(),
+            copy->GetBufferPointer());
+
+  // Make room for the slice, least recently used slices first
+  size_t bytes = this->GetSliceMemory(key.Size);
+  this->PruneEntries(key);
+  this->TrimEntries(m_MaximumMemory - bytes);
+
+  Entry entry;
+  entry.Key = key;
+  entry.Slice = copy;
+  entry.Bytes = bytes;
+  m_Entries.push_front(entry);
+  m_MemoryFootprint += bytes;
+
+  this->GraftOutput(copy);
+  m_OutputKey = key;
+}
+
+#endif // DISPLAYSLICECACHE_TXX
@@ -38,6 +38,7 @@
 #include "itkImage.h"
 #include "itkVectorImage.h"
 #include "itkVectorImageToImageAdaptor.h"
+#include "SNAPTrace.h"
 
 template <class TImage>
 class IRISSlicerComponentHelper
@@ -329,6 +330,8 @@ void
 IRISSlicer<TInputImage, TOutputImage, TPreviewImage>
 ::GenerateData()
 {
+  SNAP_TRACE("slicing", this->GetNameOfClass());
+
   // Here's the input and output
   const InputImageType *inputPtr = this->GetInput();
 
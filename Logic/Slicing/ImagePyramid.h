@@ -0,0 +1,168 @@
+#ifndef IMAGEPYRAMID_H
+#define IMAGEPYRAMID_H
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkFixedArray.h"
+
+#include <map>
+#include <utility>
+
+/**
+ * A lazily computed resolution pyramid used to slice very large images that
+ * are shown zoomed out. For a given slice direction, level k of the pyramid
+ * is the image downsampled by a factor of 2^k along the two in-plane axes.
+ * The image is not downsampled along the slice axis, so that the slice index
+ * is the same at every level.
+ *
+ * Levels are computed the first time they are requested, from the finest
+ * level that has already been computed, and are discarded when the image
+ * is modified. Images whose slices are small enough to be sliced quickly at
+ * full resolution are never downsampled, so that the extra memory is only
+ * spent where it pays off. The pyramid does not know how to downsample its image type:
+ * this is done by a function supplied by the owner. If that function
+ * returns NULL, the image is always sliced at full resolution.
+ */
+template <class TImage>
+class ImagePyramid : public itk::Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef ImagePyramid                                                   Self;
+  typedef itk::Object                                              Superclass;
+  typedef itk::SmartPointer<Self>                                     Pointer;
+  typedef itk::SmartPointer<const Self>                          ConstPointer;
+
+  typedef TImage                                                    ImageType;
+  typedef itk::SmartPointer<ImageType>                           ImagePointer;
+  typedef typename ImageType::SpacingType                         SpacingType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int, TImage::ImageDimension);
+
+  /** Integer downsampling factors along each axis */
+  typedef itk::FixedArray<unsigned int, ImageDimension>       ShrinkFactors;
+
+  /** Function that downsamples an image by averaging over blocks of voxels */
+  typedef ImagePointer (*DownsampleFunction)(ImageType *, const ShrinkFactors &);
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self)
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImagePyramid, itk::Object)
+
+  /** Set the full-resolution image. Passing NULL disables the pyramid */
+  void SetImage(ImageType *image);
+
+  /** Set the function used to compute the levels */
+  void SetDownsampleFunction(DownsampleFunction function);
+
+  /**
+   * Slices with at most this many pixels at full resolution are always taken
+   * from the image itself. The default is 1024 x 1024.
+   */
+  itkSetMacro(MinimumSlicePixels, size_t)
+  itkGetMacro(MinimumSlicePixels, size_t)
+
+  /**
+   * Get the coarsest level for slicing along slice_axis whose voxels are
+   * not larger than max_spacing along the in-plane axes, computing it if
+   * needed. Returns NULL if the image itself should be sliced.
+   */
+  ImageType *GetLevelForSpacing(unsigned int slice_axis, const SpacingType &max_spacing);
+
+  /**
+   * Get a level of the pyramid for slicing along slice_axis, computing it
+   * if needed. Level zero is the image itself. Returns NULL if the level
+   * can not be computed for this image type.
+   */
+  ImageType *GetLevel(unsigned int slice_axis, unsigned int level);
+
+  /** Get the memory held by the computed levels, in bytes */
+  virtual size_t GetMemoryFootprint() const;
+
+  /** Discard the computed levels */
+  void ReleaseLevels();
+
+protected:
+
+  ImagePyramid();
+  ~ImagePyramid() {}
+
+  /** Whether levels other than the image itself can be computed */
+  virtual bool CanComputeLevels() const;
+
+  /**
+   * Compute a level that is not in the pyramid yet. By default, the finest
+   * level below it that is already computed is downsampled.
+   */
+  virtual ImagePointer ComputeLevel(unsigned int slice_axis, unsigned int level);
+
+  // Levels are indexed by slice axis and level
+  typedef std::pair<unsigned int, unsigned int> KeyType;
+  typedef std::map<KeyType, ImagePointer> LevelMap;
+
+  ImagePointer m_Image;
+  DownsampleFunction m_DownsampleFunction;
+  LevelMap m_Levels;
+
+  // Modified time of the image when the levels were computed
+  itk::ModifiedTimeType m_LevelsMTime;
+
+  // Set when the downsample function can not handle the image
+  bool m_Unsupported;
+
+  // Smallest slice for which the levels are used
+  size_t m_MinimumSlicePixels;
+};
+
+/**
+ * The pyramid of an image adaptor, whose levels are adaptors of the levels
+ * of the adapted image's pyramid, with the same pixel accessor. The
+ * adaptors of one image (e.g. the components and derived quantities of a
+ * multi-component image) thus share one set of downsampled images, each
+ * computed by the source pyramid the first time any adaptor requests it.
+ */
+template <class TAdaptor>
+class ImageAdaptorPyramid : public ImagePyramid<TAdaptor>
+{
+public:
+  /** Standard class typedefs. */
+  typedef ImageAdaptorPyramid                                            Self;
+  typedef ImagePyramid<TAdaptor>                                   Superclass;
+  typedef itk::SmartPointer<Self>                                     Pointer;
+  typedef itk::SmartPointer<const Self>                          ConstPointer;
+
+  typedef typename Superclass::ImagePointer                      ImagePointer;
+  typedef typename TAdaptor::InternalImageType              InternalImageType;
+  typedef ImagePyramid<InternalImageType>                   SourcePyramidType;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self)
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageAdaptorPyramid, ImagePyramid)
+
+  /** Set the pyramid of the adapted image */
+  void SetSource(SourcePyramidType *source);
+
+  /** The levels only reference the pixel data of the source pyramid */
+  virtual size_t GetMemoryFootprint() const ITK_OVERRIDE { return 0; }
+
+protected:
+
+  ImageAdaptorPyramid() {}
+  ~ImageAdaptorPyramid() {}
+
+  virtual bool CanComputeLevels() const ITK_OVERRIDE;
+
+  virtual ImagePointer ComputeLevel(unsigned int slice_axis, unsigned int level) ITK_OVERRIDE;
+
+  itk::SmartPointer<SourcePyramidType> m_Source;
+};
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "ImagePyramid.txx"
+#endif
+
+#endif // IMAGEPYRAMID_H
@@ -0,0 +1,206 @@
+#ifndef IMAGEPYRAMID_TXX
+#define IMAGEPYRAMID_TXX
+
+#include "ImagePyramid.h"
+
+template <class TImage>
+ImagePyramid<TImage>
+::ImagePyramid()
+{
+  m_DownsampleFunction = NULL;
+  m_LevelsMTime = 0;
+  m_Unsupported = false;
+  m_MinimumSlicePixels = 1024 * 1024;
+}
+
+template <class TImage>
+void
+ImagePyramid<TImage>
+::SetImage(ImageType *image)
+{
+  if(m_Image != image)
+    {
+    m_Image = image;
+    m_Levels.clear();
+    m_Unsupported = false;
+    this->Modified();
+    }
+}
+
+template <class TImage>
+void
+ImagePyramid<TImage>
+::SetDownsampleFunction(DownsampleFunction function)
+{
+  if(m_DownsampleFunction != function)
+    {
+    m_DownsampleFunction = function;
+    m_Levels.clear();
+    m_Unsupported = false;
+    this->Modified();
+    }
+}
+
+template <class TImage>
+typename ImagePyramid<TImage>::ImageType *
+ImagePyramid<TImage>
+::GetLevelForSpacing(unsigned int slice_axis, const SpacingType &max_spacing)
+{
+  if(!m_Image || !this->CanComputeLevels() || m_Unsupported)
+    return NULL;
+
+  const SpacingType &spacing = m_Image->GetSpacing();
+  typename ImageType::SizeType size = m_Image->GetLargestPossibleRegion().GetSize();
+
+  // Small slices are extracted quickly enough from the image itself
+  size_t slice_pixels = 1;
+  for(unsigned int d = 0; d < ImageDimension; d++)
+    if(d != slice_axis)
+      slice_pixels *= size[d];
+  if(slice_pixels <= m_MinimumSlicePixels)
+    return NULL;
+
+  // Go up one level at a time while the voxels of the next level are still
+  // no larger than the screen pixels and the level is at least one voxel
+  // across in the slice plane
+  unsigned int level = 0;
+  for(bool coarser = true; coarser; )
+    {
+    unsigned int factor = 2u << level;
+    for(unsigned int d = 0; d < ImageDimension; d++)
+      {
+      if(d != slice_axis && (spacing[d] * factor > max_spacing[d] || size[d] < factor))
+        coarser = false;
+      }
+    if(coarser)
+      level++;
+    }
+
+  return level > 0 ? this->GetLevel(slice_axis, level) : NULL;
+}
+
+template <class TImage>
+typename ImagePyramid<TImage>::ImageType *
+ImagePyramid<TImage>
+::GetLevel(unsigned int slice_axis, unsigned int level)
+{
+  if(level == 0)
+    return m_Image;
+
+  if(!m_Image || !this->CanComputeLevels() || m_Unsupported)
+    return NULL;
+
+  // Levels computed before the image was last modified are out of date
+  if(m_LevelsMTime != m_Image->GetMTime())
+    {
+    m_Levels.clear();
+    m_LevelsMTime = m_Image->GetMTime();
+    }
+
+  typename LevelMap::iterator it = m_Levels.find(KeyType(slice_axis, level));
+  if(it != m_Levels.end())
+    return it->second;
+
+  ImagePointer result = this->ComputeLevel(slice_axis, level);
+  if(!result)
+    {
+    m_Unsupported = true;
+    return NULL;
+    }
+
+  m_Levels[KeyType(slice_axis, level)] = result;
+  return result;
+}
+
+template <class TImage>
+bool
+ImagePyramid<TImage>
+::CanComputeLevels() const
+{
+  return m_DownsampleFunction != NULL;
+}
+
+template <class TImage>
+typename ImagePyramid<TImage>::ImagePointer
+ImagePyramid<TImage>
+::ComputeLevel(unsigned int slice_axis, unsigned int level)
+{
+  // Downsample the finest level below this one that is already computed
+  unsigned int src_level = level - 1;
+  while(src_level > 0 && m_Levels.find(KeyType(slice_axis, src_level)) == m_Levels.end())
+    src_level--;
+
+  ImageType *source = src_level > 0 ? m_Levels[KeyType(slice_axis, src_level)] : m_Image;
+
+  ShrinkFactors factors;
+  for(unsigned int d = 0; d < ImageDimension; d++)
+    factors[d] = (d == slice_axis) ? 1u : 1u << (level - src_level);
+
+  return m_DownsampleFunction(source, factors);
+}
+
+template <class TImage>
+size_t
+ImagePyramid<TImage>
+::GetMemoryFootprint() const
+{
+  typedef typename ImageType::PixelContainer PixelContainer;
+
+  size_t bytes = 0;
+  for(typename LevelMap::const_iterator it = m_Levels.begin(); it != m_Levels.end(); ++it)
+    {
+    const PixelContainer *pc = it->second->GetPixelContainer();
+    if(pc)
+      bytes += pc->Size() * sizeof(typename PixelContainer::Element);
+    }
+  return bytes;
+}
+
+template <class TImage>
+void
+ImagePyramid<TImage>
+::ReleaseLevels()
+{
+  m_Levels.clear();
+}
+
+template <class TAdaptor>
+void
+ImageAdaptorPyramid<TAdaptor>
+::SetSource(SourcePyramidType *source)
+{
+  if(m_Source != source)
+    {
+    m_Source = source;
+    this->ReleaseLevels();
+    this->m_Unsupported = false;
+    this->Modified();
+    }
+}
+
+template <class TAdaptor>
+bool
+ImageAdaptorPyramid<TAdaptor>
+::CanComputeLevels() const
+{
+  return m_Source.GetPointer() != NULL;
+}
+
+template <class TAdaptor>
+typename ImageAdaptorPyramid<TAdaptor>::ImagePointer
+ImageAdaptorPyramid<TAdaptor>
+::ComputeLevel(unsigned int slice_axis, unsigned int level)
+{
+  // The source pyramid computes the level if no other adaptor has yet
+  InternalImageType *source = m_Source->GetLevel(slice_axis, level);
+  if(!source)
+    return NULL;
+
+  ImagePointer result = TAdaptor::New();
+  result->CopyInformation(source);
+  result->SetImage(source);
+  result->SetPixelAccessor(this->m_Image->GetPixelAccessor());
+  return result;
+}
+
+#endif // IMAGEPYRAMID_TXX
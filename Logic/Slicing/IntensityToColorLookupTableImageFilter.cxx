@@ -4,6 +4,7 @@
 #include "LookupTableTraits.h"
 #include "IntensityCurveInterface.h"
 #include "ColorMap.h"
+#include "SNAPTrace.h"
 #include "itkImage.h"
 
 
@@ -114,6 +115,8 @@ void
 AbstractLookupTableImageFilter<TInputImage, TOutputLUT, TComponent>
 ::DynamicThreadedGenerateData(const OutputImageRegionType &region)
 {
+  SNAP_TRACE("lut", "IntensityToColorLookupTableImageFilter");
+
   // Get the image max and min
   InputComponentType imin = m_ImageMinInput->Get(), imax = m_ImageMaxInput->Get();
 
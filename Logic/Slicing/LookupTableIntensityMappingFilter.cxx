@@ -2,6 +2,9 @@
 #include "RLEImageRegionIterator.h"
 #include <itkRGBAPixel.h>
 #include "LookupTableTraits.h"
+#include "LookupTableMappingKernels.h"
+#include "SNAPTrace.h"
+#include <itkImageScanlineConstIterator.h>
 
 template<class TInputImage, class TOutputImage>
 LookupTableIntensityMappingFilter<TInputImage, TOutputImage>
@@ -38,19 +41,80 @@ LookupTableIntensityMappingFilter<TInputImage, TOutputImage>
   this->SetNthInput(3, m_InputMax);
 }
 
+/**
+ * Maps a scanline of input pixels through the LUT. This generic version is
+ * used for the pixel types that have no dedicated kernel.
+ */
+template <class TInputPixel, class TOutputPixel>
+struct LookupTableScanlineMapper
+{
+  static void Map(const TInputPixel *in, TOutputPixel *out, size_t n,
+                  const TOutputPixel *lutp, int itkNotUsed(lut_first), int itkNotUsed(lut_last),
+                  float lutScale, TInputPixel lutShift, bool zero_is_outside)
+  {
+    for(size_t i = 0; i < n; i++)
+      {
+      if(in[i] == 0 && zero_is_outside)
+        {
+        out[i].Fill(0);
+        }
+      else
+        {
+        int lut_offset = LookupTableTraits<TInputPixel>::ComputeLUTOffset(
+              lutScale, lutShift, in[i]);
+        out[i] = *(lutp + lut_offset);
+        }
+      }
+  }
+};
+
+// RGBA pixels are handed to the kernels as 32-bit words
+typedef itk::RGBAPixel<unsigned char> RGBAPixelType;
+
+template <>
+struct LookupTableScanlineMapper<short, RGBAPixelType>
+{
+  static void Map(const short *in, RGBAPixelType *out, size_t n,
+                  const RGBAPixelType *lutp, int, int,
+                  float, short, bool zero_is_outside)
+  {
+    LookupTableMappingKernels::MapScanline(
+          in, reinterpret_cast<uint32_t *>(out), n,
+          reinterpret_cast<const uint32_t *>(lutp), zero_is_outside);
+  }
+};
+
+template <>
+struct LookupTableScanlineMapper<float, RGBAPixelType>
+{
+  static void Map(const float *in, RGBAPixelType *out, size_t n,
+                  const RGBAPixelType *lutp, int lut_first, int lut_last,
+                  float lutScale, float lutShift, bool zero_is_outside)
+  {
+    // The offsets are clamped to the LUT, which only matters for intensities
+    // outside of the image range, e.g., in slices of a modified image
+    LookupTableMappingKernels::MapScanline(
+          in, reinterpret_cast<uint32_t *>(out), n,
+          reinterpret_cast<const uint32_t *>(lutp), lutShift, lutScale,
+          lut_first, lut_last, zero_is_outside);
+  }
+};
+
 template<class TInputImage, class TOutputImage>
 void
 LookupTableIntensityMappingFilter<TInputImage, TOutputImage>
 ::DynamicThreadedGenerateData(const OutputImageRegionType &region)
 {
+  SNAP_TRACE("color mapping", "LookupTableIntensityMappingFilter");
+
   // Get the input, output and the LUT
   const InputImageType *input = this->GetInput();
   OutputImageType *output = this->GetOutput(0);
 
   // Get the pointer to the zero value in the LUT
-  OutputPixelType *lutp =
-      m_LookupTable->GetBufferPointer()
-      - m_LookupTable->GetLargestPossibleRegion().GetIndex()[0];
+  int lut_first = m_LookupTable->GetLargestPossibleRegion().GetIndex()[0];
+  int lut_last = lut_first + m_LookupTable->GetLargestPossibleRegion().GetSize()[0] - 1;
+  const OutputPixelType *lutp = m_LookupTable->GetBufferPointer() - lut_first;
 
   // Range of the input image
   InputPixelType input_min = m_InputMin->Get();
@@ -64,38 +128,26 @@ LookupTableIntensityMappingFilter<TInputImage, TOutputImage>
   LookupTableTraits<InputPixelType>::ComputeLinearMappingToLUT(
         input_min, input_max, lutScale, lutShift);
 
-  // Define the iterators
-  itk::ImageRegionConstIterator<TInputImage> inputIt(input, region);
-  itk::ImageRegionIterator<TOutputImage> outputIt(output, region);
-
-  // Perform the intensity mapping using the LUT (no bounds checking!)
-  while( !inputIt.IsAtEnd() )
-    {
-    // Get the input intensity
-    InputPixelType xin = inputIt.Get();
-    OutputPixelType xout;
-
-    // TODO: we need to handle out of bounds voxels in non-orthogonal slicing
-    // better than this, i.e., via a special value reserved for such voxels.
-    // Right now, defaulting to zero is a DISASTER!
-    if(xin == 0 && (input_min > 0 || input_max < 0))
-      {
-      // Special case: intensity is actually outside of the min/max range
-      xout.Fill(0);
-      }
-    else
-      {
-      // Find the corresponding LUT offset
-      int lut_offset = LookupTableTraits<InputPixelType>::ComputeLUTOffset(
-            lutScale, lutShift, xin);
-
-      xout = *(lutp + lut_offset);
-      }
+  // TODO: we need to handle out of bounds voxels in non-orthogonal slicing
+  // better than this, i.e., via a special value reserved for such voxels.
+  // Right now, defaulting to zero is a DISASTER!
+  bool zero_is_outside = (input_min > 0 || input_max < 0);
 
-    outputIt.Set(xout);
+  // Map the region one scanline at a time, working on the buffers directly
+  typedef LookupTableScanlineMapper<InputPixelType, OutputPixelType> Mapper;
+  const InputPixelType *in_buffer = input->GetBufferPointer();
+  OutputPixelType *out_buffer = output->GetBufferPointer();
+  size_t line_length = region.GetSize(0);
 
-    ++inputIt;
-    ++outputIt;
+  itk::ImageScanlineConstIterator<TInputImage> itLine(input, region);
+  while(!itLine.IsAtEnd())
+    {
+    const typename TInputImage::IndexType &idx = itLine.GetIndex();
+    Mapper::Map(in_buffer + input->ComputeOffset(idx),
+                out_buffer + output->ComputeOffset(idx),
+                line_length, lutp, lut_first, lut_last,
+                lutScale, lutShift, zero_is_outside);
+    itLine.NextLine();
     }
 }
 
@@ -0,0 +1,197 @@
+#include "LookupTableMappingKernels.h"
+
+#ifdef SIMD_X86
+#include <immintrin.h>
+#endif
+
+/* ===============================================================
+    Portable kernels
+   =============================================================== */
+
+static void MapShortScalar(const short *in, uint32_t *out, size_t n,
+                           const uint32_t *lut, bool zero_is_outside)
+{
+  if(zero_is_outside)
+    {
+    for(size_t i = 0; i < n; i++)
+      out[i] = in[i] ? lut[in[i]] : 0u;
+    }
+  else
+    {
+    for(size_t i = 0; i < n; i++)
+      out[i] = lut[in[i]];
+    }
+}
+
+// Offset into the LUT of a real intensity. NaNs go to the first entry
+static inline int RealToLUTOffset(float x, float shift, float scale, int first, int last)
+{
+  float t = (x - shift) * scale;
+  return t > first ? (t < last ? static_cast<int>(t) : last) : first;
+}
+
+static void MapFloatScalar(const float *in, uint32_t *out, size_t n,
+                           const uint32_t *lut, float shift, float scale,
+                           int first, int last, bool zero_is_outside)
+{
+  for(size_t i = 0; i < n; i++)
+    {
+    float x = in[i];
+    out[i] = (zero_is_outside && x == 0.0f)
+        ? 0u : lut[RealToLUTOffset(x, shift, scale, first, last)];
+    }
+}
+
+/* ===============================================================
+    x86 kernels
+   =============================================================== */
+
+#ifdef SIMD_X86
+
+SIMD_TARGET_SSE2
+static void MapFloatSSE2(const float *in, uint32_t *out, size_t n,
+                         const uint32_t *lut, float shift, float scale,
+                         int first, int last, bool zero_is_outside)
+{
+  const __m128 v_shift = _mm_set1_ps(shift), v_scale = _mm_set1_ps(scale);
+  const __m128 v_first = _mm_set1_ps((float) first), v_last = _mm_set1_ps((float) last);
+  const __m128 v_zero = _mm_setzero_ps();
+
+  size_t i = 0;
+  for(; i + 4 <= n; i += 4)
+    {
+    // Scale, clamp and convert four intensities at a time. The first operand
+    // of max is the scaled value, so that NaNs are replaced by the minimum
+    __m128 x = _mm_loadu_ps(in + i);
+    __m128 t = _mm_mul_ps(_mm_sub_ps(x, v_shift), v_scale);
+    t = _mm_min_ps(_mm_max_ps(t, v_first), v_last);
+
+    int offset[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(offset), _mm_cvttps_epi32(t));
+
+    int outside = zero_is_outside ? _mm_movemask_ps(_mm_cmpeq_ps(x, v_zero)) : 0;
+    for(int k = 0; k < 4; k++)
+      out[i + k] = (outside & (1 << k)) ? 0u : lut[offset[k]];
+    }
+
+  MapFloatScalar(in + i, out + i, n - i, lut, shift, scale, first, last, zero_is_outside);
+}
+
+SIMD_TARGET_AVX2
+static void MapShortAVX2(const short *in, uint32_t *out, size_t n,
+                         const uint32_t *lut, bool zero_is_outside)
+{
+  const int *base = reinterpret_cast<const int *>(lut);
+  const __m256i v_zero = _mm256_setzero_si256();
+  const __m256i v_ones = _mm256_set1_epi32(-1);
+
+  size_t i = 0;
+  for(; i + 8 <= n; i += 8)
+    {
+    // Widen eight intensities to 32 bit offsets and gather their colors.
+    // When zero is outside of the image range, it is also outside of the
+    // table, so the zero lanes are masked out of the gather and left black
+    __m256i idx = _mm256_cvtepi16_epi32(
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i)));
+    __m256i rgba;
+    if(zero_is_outside)
+      {
+      __m256i inside = _mm256_xor_si256(_mm256_cmpeq_epi32(idx, v_zero), v_ones);
+      rgba = _mm256_mask_i32gather_epi32(v_zero, base, idx, inside, 4);
+      }
+    else
+      {
+      rgba = _mm256_i32gather_epi32(base, idx, 4);
+      }
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), rgba);
+    }
+
+  MapShortScalar(in + i, out + i, n - i, lut, zero_is_outside);
+}
+
+SIMD_TARGET_AVX2
+static void MapFloatAVX2(const float *in, uint32_t *out, size_t n,
+                         const uint32_t *lut, float shift, float scale,
+                         int first, int last, bool zero_is_outside)
+{
+  const int *base = reinterpret_cast<const int *>(lut);
+  const __m256 v_shift = _mm256_set1_ps(shift), v_scale = _mm256_set1_ps(scale);
+  const __m256 v_first = _mm256_set1_ps((float) first), v_last = _mm256_set1_ps((float) last);
+  const __m256 v_zero = _mm256_setzero_ps();
+
+  size_t i = 0;
+  for(; i + 8 <= n; i += 8)
+    {
+    // Same arithmetic as the scalar code: subtract, multiply, clamp, truncate
+    __m256 x = _mm256_loadu_ps(in + i);
+    __m256 t = _mm256_mul_ps(_mm256_sub_ps(x, v_shift), v_scale);
+    t = _mm256_min_ps(_mm256_max_ps(t, v_first), v_last);
+    __m256i rgba = _mm256_i32gather_epi32(base, _mm256_cvttps_epi32(t), 4);
+    if(zero_is_outside)
+      {
+      __m256i outside = _mm256_castps_si256(_mm256_cmp_ps(x, v_zero, _CMP_EQ_OQ));
+      rgba = _mm256_andnot_si256(outside, rgba);
+      }
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), rgba);
+    }
+
+  MapFloatScalar(in + i, out + i, n - i, lut, shift, scale, first, last, zero_is_outside);
+}
+
+#endif // SIMD_X86
+
+/* ===============================================================
+    Dispatch
+   =============================================================== */
+
+void
+LookupTableMappingKernels::MapScanline(
+    const short *in, uint32_t *out, size_t n,
+    const uint32_t *lut, bool zero_is_outside, InstructionSet isa)
+{
+#ifdef SIMD_X86
+  if(isa == SIMDInstructionSet::AVX2)
+    return MapShortAVX2(in, out, n, lut, zero_is_outside);
+#endif
+  MapShortScalar(in, out, n, lut, zero_is_outside);
+}
+
+void
+LookupTableMappingKernels::MapScanline(
+    const float *in, uint32_t *out, size_t n,
+    const uint32_t *lut, float shift, float scale, int lut_first, int lut_last,
+    bool zero_is_outside, InstructionSet isa)
+{
+#ifdef SIMD_X86
+  if(isa == SIMDInstructionSet::AVX2)
+    return MapFloatAVX2(in, out, n, lut, shift, scale, lut_first, lut_last, zero_is_outside);
+  if(isa == SIMDInstructionSet::SSE2)
+    return MapFloatSSE2(in, out, n, lut, shift, scale, lut_first, lut_last, zero_is_outside);
+#endif
+  MapFloatScalar(in, out, n, lut, shift, scale, lut_first, lut_last, zero_is_outside);
+}
+
+void
+LookupTableMappingKernels::MapScanline(
+    const short *in0, const short *in1, const short *in2, uint32_t *out, size_t n,
+    const unsigned char *lut, bool zero_is_outside)
+{
+  // The table has one byte per entry, which can not be gathered without
+  // reading past its ends, so this kernel is left to the compiler
+  unsigned char *o = reinterpret_cast<unsigned char *>(out);
+  for(size_t i = 0; i < n; i++, o += 4)
+    {
+    short x0 = in0[i], x1 = in1[i], x2 = in2[i];
+    if(zero_is_outside && x0 == 0 && x1 == 0 && x2 == 0)
+      {
+      o[0] = o[1] = o[2] = o[3] = 0;
+      }
+    else
+      {
+      o[0] = lut[x0];
+      o[1] = lut[x1];
+      o[2] = lut[x2];
+      o[3] = 255;
+      }
+    }
+}
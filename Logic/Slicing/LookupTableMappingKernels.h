@@ -0,0 +1,60 @@
+#ifndef LOOKUPTABLEMAPPINGKERNELS_H
+#define LOOKUPTABLEMAPPINGKERNELS_H
+
+#include "SIMDInstructionSet.h"
+#include <cstddef>
+#include <stdint.h>
+
+/**
+ * Kernels used by the lookup table intensity mapping filters to map one
+ * contiguous scanline of intensities to RGBA display pixels. RGBA pixels
+ * are passed as 32-bit words, i.e., the four unsigned char components of
+ * itk::RGBAPixel<unsigned char> in memory order.
+ *
+ * On x86 processors that support AVX2, the lookups are done eight pixels
+ * at a time using gather instructions. Float intensities are scaled,
+ * clamped and converted to table offsets with SSE2 when AVX2 is absent.
+ * Otherwise, or when requested, plain loops are used. All instruction sets
+ * produce identical results.
+ */
+class LookupTableMappingKernels
+{
+public:
+
+  typedef SIMDInstructionSet::InstructionSet InstructionSet;
+
+  /**
+   * Map integral intensities through a table of RGBA pixels. The table
+   * pointer is that of the entry for intensity zero. When zero_is_outside is
+   * set, intensity zero lies outside of the image range, and marks pixels
+   * outside of the image, which are mapped to transparent black. The table
+   * is then never read at offset zero, which may lie outside of it.
+   */
+  static void MapScanline(
+      const short *in, uint32_t *out, size_t n,
+      const uint32_t *lut, bool zero_is_outside,
+      InstructionSet isa = SIMDInstructionSet::GetBestInstructionSet());
+
+  /**
+   * Map real intensities through a table of RGBA pixels. The table offset of
+   * an intensity x is (x - shift) * scale, truncated and clamped to the range
+   * [lut_first, lut_last]. The table pointer is that of offset zero.
+   */
+  static void MapScanline(
+      const float *in, uint32_t *out, size_t n,
+      const uint32_t *lut, float shift, float scale, int lut_first, int lut_last,
+      bool zero_is_outside,
+      InstructionSet isa = SIMDInstructionSet::GetBestInstructionSet());
+
+  /**
+   * Map three integral channels through a common table of color components,
+   * producing opaque RGB pixels. The table pointer is that of the entry for
+   * intensity zero. Pixels where all channels are zero are mapped to
+   * transparent black when zero_is_outside is set.
+   */
+  static void MapScanline(
+      const short *in0, const short *in1, const short *in2, uint32_t *out, size_t n,
+      const unsigned char *lut, bool zero_is_outside);
+};
+
+#endif // LOOKUPTABLEMAPPINGKERNELS_H
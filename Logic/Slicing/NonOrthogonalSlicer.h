@@ -49,6 +49,8 @@
 #include "itkVectorImage.h"
 #include "itkImageAdaptor.h"
 
+#include <vector>
+
 using itk::DataObjectDecorator;
 using itk::ProcessObject;
 
@@ -75,6 +77,13 @@ public:
 
   inline void ProcessVoxel(double *cix, bool use_nn, OutputComponentType **out_ptr);
 
+  /**
+   * Process n voxels along a line, starting at cix and advancing by step.
+   * This gives the same output as calling ProcessVoxel at each position.
+   */
+  inline void ProcessLine(const double *cix, const double *step, int n, bool use_nn,
+                          OutputComponentType **out_ptr);
+
   inline void SkipVoxels(int n, OutputComponentType **out_ptr);
 
 protected:
@@ -88,6 +97,10 @@ protected:
 
   // Temporary buffer
   double *m_Buffer;
+
+  // Temporary buffers for the samples along a line and their status
+  std::vector<typename Interpolator::OutputComponentType> m_LineBuffer;
+  std::vector<typename Interpolator::InOut> m_LineStatus;
 };
 
 
@@ -108,6 +121,8 @@ public:
   ~DefaultNonOrthogonalSlicerWorkerTraits();
 
   inline void ProcessVoxel(double *cix, bool use_nn, OutputComponentType **out_ptr);
+  inline void ProcessLine(const double *cix, const double *step, int n, bool use_nn,
+                          OutputComponentType **out_ptr);
   inline void SkipVoxels(int n, OutputComponentType **out_ptr);
 
 protected:
@@ -124,6 +139,10 @@ protected:
 
   // Temporary buffer
   double m_BufferValue;
+
+  // Temporary buffers for the samples along a line and their status
+  std::vector<typename Interpolator::OutputComponentType> m_LineBuffer;
+  std::vector<typename Interpolator::InOut> m_LineStatus;
 };
 
 
@@ -146,6 +165,8 @@ public:
   ~DefaultNonOrthogonalSlicerWorkerTraits();
 
   inline void ProcessVoxel(double *cix, bool use_nn, OutputComponentType **out_ptr);
+  inline void ProcessLine(const double *cix, const double *step, int n, bool use_nn,
+                          OutputComponentType **out_ptr);
   inline void SkipVoxels(int n, OutputComponentType **out_ptr);
 
 protected:
@@ -188,10 +209,17 @@ public:
 
   inline void ProcessVoxel(double *cix, bool use_nn, OutputComponentType **out_ptr);
 
+  inline void ProcessLine(const double *cix, const double *step, int n, bool use_nn,
+                          OutputComponentType **out_ptr);
+
   inline void SkipVoxels(int n, OutputComponentType **out_ptr);
 
 protected:
   typename InputImageType::Pointer m_Image;
+
+  // The image of run-length lines that holds the pixel data
+  typedef typename InputImageType::BufferType BufferType;
+  BufferType *m_Buffer;
 };
 
 
@@ -46,6 +46,7 @@
 #include "NonOrthogonalSlicer.h"
 #include "FastLinearInterpolator.h"
 #include "ImageRegionConstIteratorWithIndexOverride.h"
+#include "SNAPTrace.h"
 
 template <typename TInputImage, typename TOutputImage, typename TWorkerTraits>
 NonOrthogonalSlicer<TInputImage, TOutputImage, TWorkerTraits>
@@ -110,6 +111,8 @@ void
 NonOrthogonalSlicer<TInputImage, TOutputImage, TWorkerTraits>
 ::DynamicThreadedGenerateData(const OutputImageRegionType &outputRegionForThread)
 {
+  SNAP_TRACE("slicing", this->GetNameOfClass());
+
   // The input 4D image volume
   InputImageType *input = const_cast<InputImageType *>(this->GetInput());
 
@@ -241,14 +244,8 @@ NonOrthogonalSlicer<TInputImage, TOutputImage, TWorkerTraits>
         }
 
       // Process the voxels that cross the image cube
-      for(int i = kStart; i <= kEnd; i++)
-        {
-        worker.ProcessVoxel(cixSample.GetDataPointer(), use_nn, &outPixelPtr);
-
-        // Update the sample location
-        for(int d = 0; d < InputImageDimension; d++)
-          cixSample[d] += cixStep[d];
-        }
+      worker.ProcessLine(cixSample.GetDataPointer(), cixStep.GetDataPointer(),
+                         1 + kEnd - kStart, use_nn, &outPixelPtr);
 
       // Process the rest
       if(kEnd < line_len - 1)
@@ -303,6 +300,47 @@ DefaultNonOrthogonalSlicerWorkerTraits<TInputImage, TOutputImage>
     }
 }
 
+template <class TInputImage, class TOutputImage>
+void
+DefaultNonOrthogonalSlicerWorkerTraits<TInputImage, TOutputImage>
+::ProcessLine(const double *cix, const double *step, int n, bool use_nn,
+              OutputComponentType **out_ptr)
+{
+  if(use_nn)
+    {
+    double p[TInputImage::ImageDimension];
+    for(unsigned int d = 0; d < TInputImage::ImageDimension; d++)
+      p[d] = cix[d];
+
+    for(int i = 0; i < n; i++)
+      {
+      this->ProcessVoxel(p, true, out_ptr);
+      for(unsigned int d = 0; d < TInputImage::ImageDimension; d++)
+        p[d] += step[d];
+      }
+    return;
+    }
+
+  // Interpolate the whole line at once, then copy the samples to the output
+  m_LineBuffer.resize(n * m_NumComponents);
+  m_LineStatus.resize(n);
+  m_Interpolator.InterpolateLine(cix, step, n, &m_LineBuffer[0], &m_LineStatus[0]);
+
+  const typename Interpolator::OutputComponentType *sample = &m_LineBuffer[0];
+  for(int i = 0; i < n; i++, sample += m_NumComponents)
+    {
+    if(m_LineStatus[i] == Interpolator::INSIDE || m_LineStatus[i] == Interpolator::BORDER)
+      {
+      for(int k = 0; k < m_NumComponents; k++)
+        *(*out_ptr)++ = static_cast<OutputComponentType>(sample[k]);
+      }
+    else
+      {
+      SkipVoxels(1, out_ptr);
+      }
+    }
+}
+
 template <class TInputImage, class TOutputImage>
 void
 DefaultNonOrthogonalSlicerWorkerTraits<TInputImage, TOutputImage>
@@ -363,6 +401,43 @@ DefaultNonOrthogonalSlicerWorkerTraits<
     *(*out_ptr)++ = 0;
 }
 
+template <typename TPixelType, unsigned int Dimension, typename TOutputImage>
+void
+DefaultNonOrthogonalSlicerWorkerTraits<
+  itk::VectorImageToImageAdaptor<TPixelType, Dimension>,
+  TOutputImage>
+::ProcessLine(const double *cix, const double *step, int n, bool use_nn,
+              OutputComponentType **out_ptr)
+{
+  if(use_nn)
+    {
+    double p[Dimension];
+    for(unsigned int d = 0; d < Dimension; d++)
+      p[d] = cix[d];
+
+    for(int i = 0; i < n; i++)
+      {
+      this->ProcessVoxel(p, true, out_ptr);
+      for(unsigned int d = 0; d < Dimension; d++)
+        p[d] += step[d];
+      }
+    return;
+    }
+
+  // A single component is sampled, and voxels on the border are left at zero
+  m_LineBuffer.resize(n);
+  m_LineStatus.resize(n);
+  m_Interpolator.InterpolateLine(cix, step, n, &m_LineBuffer[0], &m_LineStatus[0]);
+
+  for(int i = 0; i < n; i++)
+    {
+    if(m_LineStatus[i] == Interpolator::INSIDE)
+      *(*out_ptr)++ = static_cast<OutputComponentType>(m_LineBuffer[i]);
+    else
+      *(*out_ptr)++ = 0;
+    }
+}
+
 template <typename TPixelType, unsigned int Dimension, typename TOutputImage>
 void
 DefaultNonOrthogonalSlicerWorkerTraits<
@@ -431,6 +506,27 @@ DefaultNonOrthogonalSlicerWorkerTraits<
     }
 }
 
+template <typename TPixelType, unsigned int Dimension, typename TAccessor, typename TOutputImage>
+void
+DefaultNonOrthogonalSlicerWorkerTraits<
+  itk::ImageAdaptor<itk::VectorImage<TPixelType, Dimension>, TAccessor>,
+  TOutputImage>
+::ProcessLine(const double *cix, const double *step, int n, bool use_nn,
+              OutputComponentType **out_ptr)
+{
+  // The accessor is applied to one interpolated vector at a time
+  double p[Dimension];
+  for(unsigned int d = 0; d < Dimension; d++)
+    p[d] = cix[d];
+
+  for(int i = 0; i < n; i++)
+    {
+    this->ProcessVoxel(p, use_nn, out_ptr);
+    for(unsigned int d = 0; d < Dimension; d++)
+      p[d] += step[d];
+    }
+}
+
 template <typename TPixelType, unsigned int Dimension, typename TAccessor, typename TOutputImage>
 void
 DefaultNonOrthogonalSlicerWorkerTraits<
@@ -451,6 +547,7 @@ DefaultNonOrthogonalSlicerWorkerTraits<RLEImage<TPixel, Dimension, TCounter>, TO
 ::DefaultNonOrthogonalSlicerWorkerTraits(InputImageType *image)
   : m_Image(image)
 {
+  m_Buffer = image->GetBuffer().GetPointer();
 }
 
 template <typename TPixel, unsigned int Dimension, typename TCounter, typename TOutputImage>
@@ -480,6 +577,72 @@ DefaultNonOrthogonalSlicerWorkerTraits<RLEImage<TPixel, Dimension, TCounter>, TO
     }
 }
 
+template <typename TPixel, unsigned int Dimension, typename TCounter, typename TOutputImage>
+void
+DefaultNonOrthogonalSlicerWorkerTraits<RLEImage<TPixel, Dimension, TCounter>, TOutputImage>
+::ProcessLine(const double *cix, const double *step, int n, bool itkNotUsed(use_nn),
+              OutputComponentType **out_ptr)
+{
+  typedef typename InputImageType::RLLine RLLine;
+  typedef typename InputImageType::IndexValueType IndexValueType;
+
+  const typename InputImageType::RegionType &region = m_Image->GetBufferedRegion();
+  IndexValueType x_first = region.GetIndex(0);
+
+  // Consecutive samples usually fall into the same run-length line, and often
+  // into the same run, so the line and the run of the last sample are kept,
+  // and the run of the next sample is searched for starting from there
+  const RLLine *line = NULL;
+  typename BufferType::IndexType line_index;
+  size_t run = 0;
+  IndexValueType run_start = 0, run_end = 0;
+
+  double p[Dimension];
+  for(unsigned int d = 0; d < Dimension; d++)
+    p[d] = cix[d];
+
+  for(int i = 0; i < n; i++)
+    {
+    // Round the same way as ProcessVoxel
+    itk::Index<Dimension> idx;
+    for(unsigned int d = 0; d < Dimension; d++)
+      {
+      idx[d] = (int)(p[d] + 0.5);
+      p[d] += step[d];
+      }
+
+    if(!region.IsInside(idx))
+      {
+      *(*out_ptr)++ = 0;
+      continue;
+      }
+
+    typename BufferType::IndexType bi = InputImageType::truncateIndex(idx);
+    if(!line || bi != line_index)
+      {
+      line = &m_Buffer->GetPixel(bi);
+      line_index = bi;
+      run = 0;
+      run_start = 0;
+      run_end = (*line)[0].first;
+      }
+
+    IndexValueType x = idx[0] - x_first;
+    while(x >= run_end)
+      {
+      run_start = run_end;
+      run_end += (*line)[++run].first;
+      }
+    while(x < run_start)
+      {
+      run_end = run_start;
+      run_start -= (*line)[--run].first;
+      }
+
+    *(*out_ptr)++ = (*line)[run].second;
+    }
+}
+
 template <typename TPixel, unsigned int Dimension, typename TCounter, typename TOutputImage>
 void
 DefaultNonOrthogonalSlicerWorkerTraits<RLEImage<TPixel, Dimension, TCounter>, TOutputImage>
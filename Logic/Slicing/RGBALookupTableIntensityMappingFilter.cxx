@@ -1,5 +1,8 @@
 #include "RGBALookupTableIntensityMappingFilter.h"
 #include "RLEImageRegionIterator.h"
+#include "LookupTableMappingKernels.h"
+#include "SNAPTrace.h"
+#include <itkImageScanlineConstIterator.h>
 
 template<class TInputImage>
 RGBALookupTableIntensityMappingFilter<TInputImage>
@@ -18,11 +21,52 @@ RGBALookupTableIntensityMappingFilter<TInputImage>
   this->SetNthInput(3, lut);
 }
 
+/**
+ * Maps a scanline of three input channels through the LUT. This generic
+ * version is used for the pixel types that have no dedicated kernel.
+ */
+template <class TInputPixel, class TComponent, class TOutputPixel>
+struct RGBALookupTableScanlineMapper
+{
+  static void Map(const TInputPixel *in0, const TInputPixel *in1, const TInputPixel *in2,
+                  TOutputPixel *out, size_t n, const TComponent *lutp, bool zero_is_outside)
+  {
+    for(size_t i = 0; i < n; i++)
+      {
+      if(in0[i] == 0 && in1[i] == 0 && in2[i] == 0 && zero_is_outside)
+        {
+        out[i].Fill(0);
+        }
+      else
+        {
+        out[i][0] = *(lutp + in0[i]);
+        out[i][1] = *(lutp + in1[i]);
+        out[i][2] = *(lutp + in2[i]);
+        out[i][3] = 255; // alpha = 1
+        }
+      }
+  }
+};
+
+template <>
+struct RGBALookupTableScanlineMapper<short, unsigned char, itk::RGBAPixel<unsigned char> >
+{
+  static void Map(const short *in0, const short *in1, const short *in2,
+                  itk::RGBAPixel<unsigned char> *out, size_t n,
+                  const unsigned char *lutp, bool zero_is_outside)
+  {
+    LookupTableMappingKernels::MapScanline(
+          in0, in1, in2, reinterpret_cast<uint32_t *>(out), n, lutp, zero_is_outside);
+  }
+};
+
 template<class TInputImage>
 void
 RGBALookupTableIntensityMappingFilter<TInputImage>
 ::DynamicThreadedGenerateData(const OutputImageRegionType &region)
 {
+  SNAP_TRACE("color mapping", "RGBALookupTableIntensityMappingFilter");
+
   // Get all the inputs
   std::vector<const InputImageType *> inputs(3);
   for(int d = 0; d < 3; d++)
@@ -36,43 +80,29 @@ RGBALookupTableIntensityMappingFilter<TInputImage>
   int lut_max = lut_min + m_LookupTable->GetLargestPossibleRegion().GetSize()[0] - 1;
 
   // Get the pointer to the zero value in the LUT
-  OutputComponentType *lutp = m_LookupTable->GetBufferPointer() - lut_min;
+  const OutputComponentType *lutp = m_LookupTable->GetBufferPointer() - lut_min;
 
-  // Define the iterators
-  typedef itk::ImageRegionConstIterator<InputImageType> InputIteratorType;
-  InputIteratorType it0(inputs[0], region);
-  InputIteratorType it1(inputs[1], region);
-  InputIteratorType it2(inputs[2], region);
+  // TODO: we need to handle out of bounds voxels in non-orthogonal slicing
+  // better than this, i.e., via a special value reserved for such voxels.
+  // Right now, defaulting to zero is a DISASTER!
+  bool zero_is_outside = (lut_min > 0 || lut_max < 0);
 
-  itk::ImageRegionIterator<OutputImageType> outputIt(output, region);
+  // Perform the intensity mapping using the LUT (no bounds checking!) one
+  // scanline at a time, working on the buffers directly
+  typedef RGBALookupTableScanlineMapper<
+      InputPixelType, OutputComponentType, OutputPixelType> Mapper;
+  size_t line_length = region.GetSize(0);
 
-  // Perform the intensity mapping using the LUT (no bounds checking!)
-  while( !outputIt.IsAtEnd() )
+  itk::ImageScanlineConstIterator<InputImageType> itLine(inputs[0], region);
+  while(!itLine.IsAtEnd())
     {
-    OutputPixelType xout;
-
-    InputPixelType xin0 = it0.Get();
-    InputPixelType xin1 = it1.Get();
-    InputPixelType xin2 = it2.Get();
-
-    // TODO: we need to handle out of bounds voxels in non-orthogonal slicing
-    // better than this, i.e., via a special value reserved for such voxels.
-    // Right now, defaulting to zero is a DISASTER!
-    if(xin0 == 0 && xin1 == 0 && xin2 == 0 && (lut_min > 0 || lut_max < 0))
-      {
-      xout.Fill(0);
-      }
-    else
-      {
-      xout[0] = *(lutp + xin0);
-      xout[1] = *(lutp + xin1);
-      xout[2] = *(lutp + xin2);
-      xout[3] = 255; // alpha = 1
-      }
-
-    outputIt.Set(xout);
-    ++it0; ++it1; ++it2;
-    ++outputIt;
+    const typename InputImageType::IndexType &idx = itLine.GetIndex();
+    Mapper::Map(inputs[0]->GetBufferPointer() + inputs[0]->ComputeOffset(idx),
+                inputs[1]->GetBufferPointer() + inputs[1]->ComputeOffset(idx),
+                inputs[2]->GetBufferPointer() + inputs[2]->ComputeOffset(idx),
+                output->GetBufferPointer() + output->ComputeOffset(idx),
+                line_length, lutp, zero_is_outside);
+    itLine.NextLine();
     }
 }
 
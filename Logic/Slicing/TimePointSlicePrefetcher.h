@@ -0,0 +1,131 @@
+#ifndef TIMEPOINTSLICEPREFETCHER_H
+#define TIMEPOINTSLICEPREFETCHER_H
+
+#include "AdaptiveSlicingPipeline.h"
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * This class computes the slices of upcoming time points of a 4D image on a
+ * background thread, so that during 4D replay the slicers of an ImageWrapper
+ * can be handed a finished slice when the time point changes, rather than
+ * having to slice the volume while the frame is being drawn.
+ *
+ * For every requested time point and slice direction, the prefetcher sets up
+ * a private copy of the slicing pipeline with the same parameters as the
+ * wrapper's slicer. Each result is tagged with the state of the slicer and of
+ * the time point image that it was computed from, and is only handed out if
+ * that state is unchanged.
+ */
+template <typename TInputImage, typename TOutputImage, typename TPreviewImage>
+class TimePointSlicePrefetcher : public itk::Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef TimePointSlicePrefetcher                                       Self;
+  typedef itk::Object                                              Superclass;
+  typedef itk::SmartPointer<Self>                                     Pointer;
+  typedef itk::SmartPointer<const Self>                          ConstPointer;
+
+  typedef TInputImage                                          InputImageType;
+  typedef TOutputImage                                        OutputImageType;
+  typedef typename OutputImageType::Pointer                OutputImagePointer;
+
+  typedef AdaptiveSlicingPipeline<TInputImage, TOutputImage, TPreviewImage> SlicerType;
+  typedef typename SlicerType::NonOrthogonalSliceReferenceSpace ReferenceSpaceType;
+  typedef typename SlicerType::OrthogonalTransformType OrthogonalTransformType;
+  typedef typename SlicerType::ObliqueTransformType ObliqueTransformType;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self)
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(TimePointSlicePrefetcher, itk::Object)
+
+  /** Everything that the contents of a slice depend on, besides the time point */
+  struct SliceState
+  {
+    itk::ModifiedTimeType Slicer, Transform, Reference, Data;
+
+    bool operator == (const SliceState &other) const
+    {
+      return Slicer == other.Slicer && Transform == other.Transform
+          && Reference == other.Reference && Data == other.Data;
+    }
+  };
+
+  /**
+   * Get the state of a slicer, given the modified time of the image data
+   * that is sliced. Returns false if the slicer's output can not be computed
+   * ahead of time, i.e., when it is showing a preview.
+   */
+  static bool GetSliceState(SlicerType *slicer, itk::ModifiedTimeType data_mtime,
+                            SliceState &state);
+
+  /**
+   * Check if the slice for the time point and direction has been requested
+   * for the given state already
+   */
+  bool HasRequest(unsigned int tp, unsigned int dir, const SliceState &state);
+
+  /**
+   * Request the slice for the time point and direction. The image should be
+   * a view of the time point that is not shared with any other pipeline,
+   * and the slicer is the one whose parameters the slice should match.
+   */
+  void Request(unsigned int tp, unsigned int dir, const SliceState &state,
+               SlicerType *slicer, InputImageType *image);
+
+  /**
+   * Get the slice for the time point and direction if it has been computed
+   * for the given state. Returns NULL otherwise. The slice is removed from
+   * the prefetcher.
+   */
+  OutputImagePointer TakeSlice(unsigned int tp, unsigned int dir, const SliceState &state);
+
+  /** Discard requests and slices for all time points not in the list */
+  void Retain(const std::vector<unsigned int> &time_points);
+
+protected:
+
+  TimePointSlicePrefetcher();
+  ~TimePointSlicePrefetcher();
+
+  typedef std::pair<unsigned int, unsigned int> KeyType;
+  typedef itk::SmartPointer<SlicerType> SlicerPointer;
+
+  // A requested slice. Once the slice is computed, the pipeline is released
+  struct Entry
+  {
+    SliceState State;
+    SlicerPointer Pipeline;
+    OutputImagePointer Slice;
+  };
+
+  typedef std::map<KeyType, Entry> EntryMap;
+
+  // Body of the background thread
+  void ThreadLoop();
+
+  EntryMap m_Entries;
+  std::deque<KeyType> m_Queue;
+
+  std::mutex m_Mutex;
+  std::condition_variable m_Condition;
+  std::thread m_Thread;
+  bool m_Stop;
+};
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "TimePointSlicePrefetcher.txx"
+#endif
+
+#endif // TIMEPOINTSLICEPREFETCHER_H
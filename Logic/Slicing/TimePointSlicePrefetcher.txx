@@ -0,0 +1,204 @@
+#ifndef TIMEPOINTSLICEPREFETCHER_TXX
+#define TIMEPOINTSLICEPREFETCHER_TXX
+
+#include "TimePointSlicePrefetcher.h"
+#include "ImageCoordinateTransform.h"
+#include <algorithm>
+
+template<typename TInputImage, typename TOutputImage, typename TPreviewImage>
+TimePointSlicePrefetcher<TInputImage, TOutputImage, TPreviewImage>
+::TimePointSlicePrefetcher()
+{
+  m_Stop = false;
+  m_Thread = std::thread(&Self::ThreadLoop, this);
+}
+
+template<typename TInputImage, typename TOutputImage, typename TPreviewImage>
+TimePointSlicePrefetcher<TInputImage, TOutputImage, TPreviewImage>
+::~TimePointSlicePrefetcher()
+{
+  // Let the thread finish the slice it is working on
+    {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Stop = true;
+    }
+  m_Condition.notify_all();
+  m_Thread.join();
+}
+
+template<typename TInputImage, typename TOutputImage, typename TPreviewImage>
+bool
+TimePointSlicePrefetcher<TInputImage, TOutputImage, TPreviewImage>
+::GetSliceState(SlicerType *slicer, itk::ModifiedTimeType data_mtime, SliceState &state)
+{
+  if(slicer->GetPreviewImage())
+    return false;
+
+  // The slicer's own time stamp covers the slice index, the slicing mode and
+  // the assignment of the transforms and the reference image. Their contents
+  // may also change in place, so their time stamps are checked as well
+  state.Slicer = slicer->GetMTime();
+  state.Data = data_mtime;
+  state.Transform = 0;
+  state.Reference = 0;
+
+  if(slicer->GetUseOrthogonalSlicing())
+    {
+    if(slicer->GetOrthogonalTransform())
+      state.Transform = slicer->GetOrthogonalTransform()->GetMTime();
+    }
+  else
+    {
+    if(slicer->GetObliqueTransform())
+      state.Transform = slicer->GetObliqueTransform()->GetMTime();
+    if(slicer->GetObliqueReferenceImage())
+      state.Reference = slicer->GetObliqueReferenceImage()->GetMTime();
+    }
+
+  return true;
+}
+
+template<typename TInputImage, typename TOutputImage, typename TPreviewImage>
+bool
+TimePointSlicePrefetcher<TInputImage, TOutputImage, TPreviewImage>
+::HasRequest(unsigned int tp, unsigned int dir, const SliceState &state)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  typename EntryMap::iterator it = m_Entries.find(KeyType(tp, dir));
+  return it != m_Entries.end() && it->second.State == state;
+}
+
+template<typename TInputImage, typename TOutputImage, typename TPreviewImage>
+void
+TimePointSlicePrefetcher<TInputImage, TOutputImage, TPreviewImage>
+::Request(unsigned int tp, unsigned int dir, const SliceState &state,
+          SlicerType *slicer, InputImageType *image)
+{
+  // Set up a pipeline that slices the image the same way as the slicer. It
+  // gets its own copies of the transforms and the reference space, because
+  // the wrapper may change them in place while the slice is being computed,
+  // and the pipeline updates the information of its inputs
+  SlicerPointer pipeline = SlicerType::New();
+  pipeline->SetInput(image);
+  pipeline->SetUseOrthogonalSlicing(slicer->GetUseOrthogonalSlicing());
+  pipeline->SetSliceIndex(slicer->GetSliceIndex());
+  if(slicer->GetUseOrthogonalSlicing())
+    {
+    const OrthogonalTransformType *tran = slicer->GetOrthogonalTransform();
+    if(tran)
+      {
+      typename OrthogonalTransformType::Pointer tran_copy = OrthogonalTransformType::New();
+      tran_copy->SetTransform(tran);
+      pipeline->SetOrthogonalTransform(tran_copy);
+      }
+    }
+  else
+    {
+    const ObliqueTransformType *tran = slicer->GetObliqueTransform();
+    if(tran)
+      {
+      // Cloning a transform copies its fixed and regular parameters
+      typename ObliqueTransformType::Pointer tran_copy = tran->Clone();
+      pipeline->SetObliqueTransform(tran_copy);
+      }
+    const ReferenceSpaceType *ref = slicer->GetObliqueReferenceImage();
+    if(ref)
+      {
+      typename ReferenceSpaceType::Pointer ref_copy = ReferenceSpaceType::New();
+      ref_copy->CopyInformation(ref);
+      ref_copy->SetRegions(ref->GetLargestPossibleRegion());
+      pipeline->SetObliqueReferenceImage(ref_copy);
+      }
+    }
+
+  KeyType key(tp, dir);
+    {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Entry &entry = m_Entries[key];
+    entry.State = state;
+    entry.Pipeline = pipeline;
+    entry.Slice = NULL;
+    m_Queue.push_back(key);
+    }
+  m_Condition.notify_one();
+}
+
+template<typename TInputImage, typename TOutputImage, typename TPreviewImage>
+typename TimePointSlicePrefetcher<TInputImage, TOutputImage, TPreviewImage>::OutputImagePointer
+TimePointSlicePrefetcher<TInputImage, TOutputImage, TPreviewImage>
+::TakeSlice(unsigned int tp, unsigned int dir, const SliceState &state)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  typename EntryMap::iterator it = m_Entries.find(KeyType(tp, dir));
+  if(it == m_Entries.end() || !(it->second.State == state) || !it->second.Slice)
+    return NULL;
+
+  OutputImagePointer slice = it->second.Slice;
+  m_Entries.erase(it);
+  return slice;
+}
+
+template<typename TInputImage, typename TOutputImage, typename TPreviewImage>
+void
+TimePointSlicePrefetcher<TInputImage, TOutputImage, TPreviewImage>
+::Retain(const std::vector<unsigned int> &time_points)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  for(typename EntryMap::iterator it = m_Entries.begin(); it != m_Entries.end(); )
+    {
+    if(std::find(time_points.begin(), time_points.end(), it->first.first) == time_points.end())
+      m_Entries.erase(it++);
+    else
+      ++it;
+    }
+}
+
+template<typename TInputImage, typename TOutputImage, typename TPreviewImage>
+void
+TimePointSlicePrefetcher<TInputImage, TOutputImage, TPreviewImage>
+::ThreadLoop()
+{
+  std::unique_lock<std::mutex> lock(m_Mutex);
+  while(true)
+    {
+    m_Condition.wait(lock, [this] { return m_Stop || !m_Queue.empty(); });
+    if(m_Stop)
+      return;
+
+    // Skip requests that were discarded or replaced since they were queued
+    KeyType key = m_Queue.front();
+    m_Queue.pop_front();
+    typename EntryMap::iterator it = m_Entries.find(key);
+    if(it == m_Entries.end() || !it->second.Pipeline)
+      continue;
+
+    // Compute the slice without holding the lock
+    SlicerPointer pipeline = it->second.Pipeline;
+    lock.unlock();
+
+    OutputImagePointer slice;
+    try
+      {
+      pipeline->Update();
+      slice = OutputImageType::New();
+      slice->Graft(pipeline->GetOutput());
+      }
+    catch(...)
+      {
+      // The slice will be computed by the wrapper's own slicer
+      slice = NULL;
+      }
+
+    lock.lock();
+
+    // Store the slice unless the request was replaced while it was computed
+    it = m_Entries.find(key);
+    if(it != m_Entries.end() && it->second.Pipeline == pipeline)
+      {
+      it->second.Pipeline = NULL;
+      it->second.Slice = slice;
+      }
+    }
+}
+
+#endif // TIMEPOINTSLICEPREFETCHER_TXX
@@ -0,0 +1,164 @@
+#include "DisplaySliceCache.h"
+#include <itkImage.h>
+#include <itkImageSource.h>
+#include <itkRGBAPixel.h>
+#include <iostream>
+
+/**
+ * Tests for DisplaySliceCache: cache hits, invalidation when the data of a
+ * time point or the display mapping change, and least recently used eviction
+ * when the slices exceed the memory limit.
+ */
+
+typedef itk::RGBAPixel<unsigned char> PixelType;
+typedef itk::Image<PixelType, 2> SliceType;
+typedef DisplaySliceCache<SliceType> CacheType;
+
+// Stand-in for the display pipeline. It fills the slice with the slice index
+// and the time point, and counts how many times it has been run
+class TestSliceSource : public itk::ImageSource<SliceType>
+{
+public:
+  typedef TestSliceSource Self;
+  typedef itk::ImageSource<SliceType> Superclass;
+  typedef itk::SmartPointer<Self> Pointer;
+
+  itkNewMacro(Self)
+  itkTypeMacro(TestSliceSource, ImageSource)
+
+  // Select the slice to produce
+  void Select(long index, unsigned int tp)
+  {
+    m_Index = index;
+    m_TimePoint = tp;
+    this->Modified();
+  }
+
+  long m_Index = 0;
+  unsigned int m_TimePoint = 0;
+  unsigned int m_Executions = 0;
+
+protected:
+
+  virtual void GenerateOutputInformation() ITK_OVERRIDE
+  {
+    SliceType::RegionType region;
+    region.SetSize(0, 64);
+    region.SetSize(1, 64);
+    this->GetOutput()->SetLargestPossibleRegion(region);
+  }
+
+  virtual void GenerateData() ITK_OVERRIDE
+  {
+    SliceType *output = this->GetOutput();
+    output->SetBufferedRegion(output->GetRequestedRegion());
+    output->Allocate();
+
+    PixelType px;
+    px.Set((unsigned char) m_Index, (unsigned char) m_TimePoint, 0, 255);
+    output->FillBuffer(px);
+    m_Executions++;
+  }
+};
+
+// State that the test slices depend on
+struct TestState
+{
+  TestSliceSource *Source;
+  itk::ModifiedTimeType Data[2], Mapping;
+};
+
+static size_t SliceBytes = 64 * 64 * sizeof(PixelType);
+
+// Show a slice through the cache, returning false if it has the wrong content
+bool ShowSlice(CacheType *cache, TestSliceSource *source, long index, unsigned int tp)
+{
+  source->Select(index, tp);
+  cache->UpdateOutputInformation();
+  cache->GetOutput()->SetRequestedRegionToLargestPossibleRegion();
+  cache->Update();
+
+  SliceType::IndexType idx = {{ 5, 7 }};
+  PixelType px = cache->GetOutput()->GetPixel(idx);
+  if(px.GetRed() != index || px.GetGreen() != tp)
+    {
+    std::cerr << "Slice " << index << " of time point " << tp << " has wrong contents" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+#define TEST_CHECK(cond) \
+  if(!(cond)) { std::cerr << "Check failed: " #cond " at line " << __LINE__ << std::endl; return EXIT_FAILURE; }
+
+int main(int, char *[])
+{
+  TestSliceSource::Pointer source = TestSliceSource::New();
+  TestState state = { source.GetPointer(), { 1, 1 }, 1 };
+
+  CacheType::Pointer cache = CacheType::New();
+  cache->SetUpstreamSlice(source->GetOutput());
+  cache->SetKeyFunction([&state](CacheType::SliceKey &key)
+  {
+    key.SliceIndex = state.Source->m_Index;
+    key.TimePoint = state.Source->m_TimePoint;
+    key.Data = state.Data[state.Source->m_TimePoint];
+    key.Mapping = state.Mapping;
+    key.Transform = 1;
+    return true;
+  });
+
+  // Room for three slices
+  cache->SetMaximumMemory(3 * SliceBytes);
+
+  // Cache hit: going back to a slice does not run the pipeline
+  TEST_CHECK(ShowSlice(cache, source, 10, 0));
+  TEST_CHECK(ShowSlice(cache, source, 11, 0));
+  TEST_CHECK(source->m_Executions == 2);
+  TEST_CHECK(ShowSlice(cache, source, 10, 0));
+  TEST_CHECK(source->m_Executions == 2);
+  TEST_CHECK(cache->GetNumberOfSlices() == 2);
+  TEST_CHECK(cache->GetMemoryFootprint() == 2 * SliceBytes);
+
+  // Editing one time point only invalidates the slices of that time point
+  TEST_CHECK(ShowSlice(cache, source, 10, 1));
+  TEST_CHECK(source->m_Executions == 3);
+  state.Data[0] = 2;
+  TEST_CHECK(ShowSlice(cache, source, 10, 1));
+  TEST_CHECK(source->m_Executions == 3);
+  TEST_CHECK(ShowSlice(cache, source, 10, 0));
+  TEST_CHECK(source->m_Executions == 4);
+
+  // Changing the display mapping invalidates all slices
+  state.Mapping = 2;
+  TEST_CHECK(ShowSlice(cache, source, 10, 1));
+  TEST_CHECK(source->m_Executions == 5);
+  TEST_CHECK(cache->GetNumberOfSlices() == 1);
+
+  // Eviction: the least recently used slice goes first, and the memory never
+  // exceeds the limit
+  TEST_CHECK(ShowSlice(cache, source, 20, 1));
+  TEST_CHECK(ShowSlice(cache, source, 21, 1));
+  TEST_CHECK(ShowSlice(cache, source, 10, 1));
+  TEST_CHECK(source->m_Executions == 7);
+  TEST_CHECK(ShowSlice(cache, source, 22, 1));
+  TEST_CHECK(source->m_Executions == 8);
+  TEST_CHECK(cache->GetNumberOfSlices() == 3);
+  TEST_CHECK(cache->GetMemoryFootprint() <= cache->GetMaximumMemory());
+  TEST_CHECK(ShowSlice(cache, source, 10, 1));
+  TEST_CHECK(source->m_Executions == 8);
+  TEST_CHECK(ShowSlice(cache, source, 20, 1));
+  TEST_CHECK(source->m_Executions == 9);
+
+  // Slices larger than the limit are passed through without being kept
+  cache->SetMaximumMemory(SliceBytes / 2);
+  TEST_CHECK(cache->GetNumberOfSlices() == 0);
+  TEST_CHECK(ShowSlice(cache, source, 30, 1));
+  TEST_CHECK(ShowSlice(cache, source, 31, 1));
+  TEST_CHECK(ShowSlice(cache, source, 30, 1));
+  TEST_CHECK(source->m_Executions == 12);
+  TEST_CHECK(cache->GetMemoryFootprint() == 0);
+
+  std::cout << "DisplaySliceCacheTest passed" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+#include "EMGaussianMixtures.h"
+#include "ImageCollectionEMDataSource.h"
+#include <itkImage.h>
+#include <itkVectorImage.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+/**
+ * Regression test for the EM iterations over all the voxels of an image: the
+ * iterations of EMGaussianMixtures over an image data source must give the
+ * same mixture as the in-memory iterations over the same voxels.
+ */
+
+typedef itk::Image<GreyType, 3> ImageType;
+typedef itk::VectorImage<GreyType, 3> VectorImageType;
+typedef ImageCollectionEMDataSource<ImageType, VectorImageType> DataSourceType;
+
+// The image is larger than one chunk of the data source, and its last chunk
+// and block are partial
+static const int SIZE[] = { 48, 40, 37 };
+static const int NUM_CLUSTERS = 3, NUM_COMPONENTS = 3;
+
+// The centers of the clusters of voxels, and their spread
+static const double CENTERS[NUM_CLUSTERS][NUM_COMPONENTS] =
+  { { 100, 200, 50 }, { 300, 250, 400 }, { 450, 100, 300 } };
+static const double SPREAD = 60;
+
+// Relative difference, measured against the scale of the values
+double RelativeDifference(double a, double b, double scale)
+{
+  return fabs(a - b) / std::max(scale, fabs(a));
+}
+
+#define TEST_CHECK(cond) \
+  if(!(cond)) { std::cerr << "Check failed: " #cond " at line " << __LINE__ << std::endl; return EXIT_FAILURE; }
+
+int main(int, char *[])
+{
+  // A scalar and a two-component image. Each voxel belongs to one of the
+  // overlapping clusters
+  ImageType::RegionType region;
+  VectorImageType::RegionType vregion;
+  for(int d = 0; d < 3; d++)
+    {
+    region.SetSize(d, SIZE[d]);
+    vregion.SetSize(d, SIZE[d]);
+    }
+
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(region);
+  image->Allocate();
+
+  VectorImageType::Pointer vimage = VectorImageType::New();
+  vimage->SetRegions(vregion);
+  vimage->SetVectorLength(2);
+  vimage->Allocate();
+
+  int n = (int) region.GetNumberOfPixels();
+  GreyType *buffer = image->GetBufferPointer();
+  GreyType *vbuffer = vimage->GetBufferPointer();
+
+  std::mt19937 rng(1234);
+  std::normal_distribution<double> noise(0.0, SPREAD);
+  for(int i = 0; i < n; i++)
+    {
+    int c = (i / 7 + i / 301) % NUM_CLUSTERS;
+    buffer[i] = (GreyType) (CENTERS[c][0] + noise(rng));
+    vbuffer[2 * i] = (GreyType) (CENTERS[c][1] + noise(rng));
+    vbuffer[2 * i + 1] = (GreyType) (CENTERS[c][2] + noise(rng));
+    }
+
+  // The same voxels in memory, component by component
+  std::vector<double> x((size_t) n * NUM_COMPONENTS);
+  for(int i = 0; i < n; i++)
+    {
+    x[i] = buffer[i];
+    x[n + i] = vbuffer[2 * i];
+    x[2 * n + i] = vbuffer[2 * i + 1];
+    }
+
+  DataSourceType source(region);
+  source.AddImage(image.GetPointer());
+  source.AddImage(vimage.GetPointer());
+  TEST_CHECK(source.GetNumberOfSamples() == (itk::SizeValueType) n);
+  TEST_CHECK(source.GetNumberOfComponents() == NUM_COMPONENTS);
+
+  // The data source reads the voxels in the same order
+  std::vector<double> block(NUM_COMPONENTS * 100);
+  source.GetSamples(n - 100, 100, &block[0]);
+  for(int k = 0; k < NUM_COMPONENTS; k++)
+    for(int s = 0; s < 100; s++)
+      TEST_CHECK(block[k * 100 + s] == x[(size_t) k * n + n - 100 + s]);
+
+  // Start both from the same mixture, away from the clusters
+  EMGaussianMixtures emMemory(&x[0], n, NUM_COMPONENTS, NUM_CLUSTERS);
+  EMGaussianMixtures emStream(&x[0], n, NUM_COMPONENTS, NUM_CLUSTERS);
+  for(int j = 0; j < NUM_CLUSTERS; j++)
+    {
+    EMGaussianMixtures::VectorType mean(NUM_COMPONENTS);
+    EMGaussianMixtures::MatrixType cov(NUM_COMPONENTS, NUM_COMPONENTS, 0.0);
+    for(int k = 0; k < NUM_COMPONENTS; k++)
+      {
+      mean[k] = CENTERS[j][k] + 80 * (k - 1);
+      cov(k, k) = 4 * SPREAD * SPREAD;
+      }
+    emMemory.SetParameters(j, mean, cov, 1.0 / NUM_CLUSTERS);
+    emStream.SetParameters(j, mean, cov, 1.0 / NUM_CLUSTERS);
+    }
+
+  double worst = 0;
+  for(int iter = 0; iter < 10; iter++)
+    {
+    emMemory.UpdateOnce();
+    emStream.UpdateOnceFromDataSource(&source);
+
+    worst = std::max(worst, RelativeDifference(
+                       emMemory.GetLogLikelihood(), emStream.GetLogLikelihood(), 1.0));
+
+    GaussianMixtureModel *gm = emMemory.GetGaussianMixtureModel();
+    GaussianMixtureModel *gs = emStream.GetGaussianMixtureModel();
+    for(int j = 0; j < NUM_CLUSTERS; j++)
+      {
+      worst = std::max(worst, RelativeDifference(gm->GetWeight(j), gs->GetWeight(j), 1.0));
+      for(int k = 0; k < NUM_COMPONENTS; k++)
+        {
+        worst = std::max(worst, RelativeDifference(
+                           gm->GetMean(j)[k], gs->GetMean(j)[k], 1.0));
+        for(int l = 0; l < NUM_COMPONENTS; l++)
+          worst = std::max(worst, RelativeDifference(
+                             gm->GetCovariance(j)(k, l), gs->GetCovariance(j)(k, l),
+                             SPREAD * SPREAD));
+        }
+      }
+    }
+
+  std::cout << "Largest relative difference: " << worst << std::endl;
+  TEST_CHECK(worst < 1e-9);
+
+  std::cout << "GaussianMixtureStreamingTest passed" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,270 @@
+#include "LookupTableIntensityMappingFilter.h"
+#include "RGBALookupTableIntensityMappingFilter.h"
+#include "LookupTableMappingKernels.h"
+#include "LookupTableTraits.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <itkImage.h>
+#include <itkRGBAPixel.h>
+#include <itkTimeProbe.h>
+
+// Measures the mapping of display slices to RGBA through the lookup tables,
+// for the scanline kernels with each instruction set supported by this
+// machine, and for the intensity mapping filters that call them. Slices are
+// 2048x2048 and of GreyType, float and three-channel GreyType intensities.
+// The results are checked against the per-pixel mapping that the filters
+// used before the kernels, both for image ranges that contain zero and for
+// ranges that do not, where zero marks pixels outside of the image.
+
+typedef itk::RGBAPixel<unsigned char> RGBAPixel;
+typedef itk::Image<RGBAPixel, 2> DisplaySliceType;
+typedef itk::Image<short, 2> ShortSliceType;
+typedef itk::Image<float, 2> FloatSliceType;
+
+const unsigned int SLICE_SIZE = 2048;
+const size_t NPIX = SLICE_SIZE * SLICE_SIZE;
+
+template <class TImage>
+typename TImage::Pointer makeSlice(const typename TImage::PixelType *data)
+{
+    typename TImage::Pointer img = TImage::New();
+    typename TImage::SizeType size = {{ SLICE_SIZE, SLICE_SIZE }};
+    img->SetRegions(size);
+    img->Allocate();
+    std::copy(data, data + NPIX, img->GetBufferPointer());
+    return img;
+}
+
+template <class TLUT>
+typename TLUT::Pointer makeLUT(int first, int last)
+{
+    typename TLUT::Pointer lut = TLUT::New();
+    typename TLUT::IndexType index = {{ first }};
+    typename TLUT::SizeType size = {{ (itk::SizeValueType) (last - first + 1) }};
+    lut->SetRegions(typename TLUT::RegionType(index, size));
+    lut->Allocate();
+    return lut;
+}
+
+// Run a function nrep times and report the mean time in ms
+template <class TFunc>
+double timeIt(TFunc f, int nrep)
+{
+    itk::TimeProbe tp;
+    for (int i = 0; i < nrep; i++)
+    {
+        tp.Start();
+        f();
+        tp.Stop();
+    }
+    return tp.GetMean() * 1000;
+}
+
+// The per-pixel mapping that the filters used before the scanline kernels
+template <class TPixel>
+void mapPerPixel(const TPixel *in, uint32_t *out, size_t n, const uint32_t *lutp,
+                 TPixel imin, TPixel imax)
+{
+    float scale;
+    TPixel shift;
+    LookupTableTraits<TPixel>::ComputeLinearMappingToLUT(imin, imax, scale, shift);
+    for (size_t i = 0; i < n; i++)
+    {
+        if (in[i] == 0 && (imin > 0 || imax < 0))
+            out[i] = 0;
+        else
+            out[i] = lutp[LookupTableTraits<TPixel>::ComputeLUTOffset(scale, shift, in[i])];
+    }
+}
+
+void report(const char *what, const char *isa, double ms, bool match)
+{
+    std::cout << std::setw(24) << what << std::setw(10) << isa
+        << std::setw(12) << std::fixed << std::setprecision(2) << ms
+        << std::setw(12) << std::setprecision(1) << NPIX / (ms * 1000.0)
+        << (match ? "" : "   MISMATCH") << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    int nrep = argc > 1 ? atoi(argv[1]) : 10;
+
+    typedef LookupTableMappingKernels K;
+    typedef SIMDInstructionSet ISA;
+    ISA::InstructionSet best = ISA::GetBestInstructionSet();
+    std::cout << "Best instruction set: " << ISA::GetInstructionSetName(best) << std::endl;
+    std::cout << std::setw(24) << "input" << std::setw(10) << "kernel"
+        << std::setw(12) << "ms" << std::setw(12) << "Mpix/s" << std::endl;
+
+    // Intensities: a noisy ramp, with some zeros to exercise the outside test.
+    // The positive images are the same ramps moved above zero, keeping the
+    // zeros, which then lie outside of the image range.
+    srand(1234);
+    const short smin = -1024, smax = 3071, pmin = 16384, pmax = 20479;
+    std::vector<short> sdata(NPIX), sdata1(NPIX), sdata2(NPIX), pdata(NPIX);
+    std::vector<float> fdata(NPIX), gdata(NPIX);
+    for (size_t i = 0; i < NPIX; i++)
+    {
+        int ramp = smin + (int) ((i % SLICE_SIZE) * (smax - smin) / SLICE_SIZE);
+        int noise = rand() % 64 - 32;
+        bool zero = (rand() % 16 == 0);
+        sdata[i] = (short) std::min(std::max(ramp + noise, (int) smin), (int) smax);
+        sdata1[i] = (short) (smax - (sdata[i] - smin));
+        sdata2[i] = (short) (rand() % (smax - smin + 1) + smin);
+        pdata[i] = zero ? 0 : (short) (sdata[i] - smin + pmin);
+        fdata[i] = zero ? 0.0f : 0.1f + sdata[i] * 0.37f;
+        gdata[i] = zero ? 0.0f : 0.1f + pdata[i] * 0.37f;
+    }
+
+    // Tables with a distinct color in each entry. Both GreyType ranges have
+    // the same number of entries.
+    std::vector<uint32_t> slut(smax - smin + 1), flut(10001);
+    std::vector<unsigned char> clut(smax - smin + 1);
+    for (size_t j = 0; j < slut.size(); j++)
+        slut[j] = (uint32_t) (j * 2654435761u) | 0xff000000u;
+    for (size_t j = 0; j < flut.size(); j++)
+        flut[j] = (uint32_t) (j * 2246822519u) | 0xff000000u;
+    for (size_t j = 0; j < clut.size(); j++)
+        clut[j] = (unsigned char) (j * 7);
+
+    float fmin = 0.1f + smin * 0.37f, fmax = 0.1f + smax * 0.37f;
+    float gmin = 0.1f + pmin * 0.37f, gmax = 0.1f + pmax * 0.37f;
+
+    std::vector<uint32_t> ref(NPIX), out(NPIX);
+    int status = 0;
+
+    // Kernels, for every instruction set up to the best one
+    struct ShortCase { const char *kernel, *filter; const std::vector<short> &data; short imin, imax; };
+    ShortCase short_cases[] = {
+        { "GreyType kernel", "GreyType filter", sdata, smin, smax },
+        { "GreyType > 0 kernel", "GreyType > 0 filter", pdata, pmin, pmax } };
+    for (const ShortCase &c : short_cases)
+    {
+        const uint32_t *lutp = &slut[0] - c.imin;
+        bool outside = c.imin > 0 || c.imax < 0;
+        mapPerPixel(&c.data[0], &ref[0], NPIX, lutp, c.imin, c.imax);
+        for (int isa = ISA::SCALAR; isa <= best; isa++)
+        {
+            ISA::InstructionSet s = (ISA::InstructionSet) isa;
+            std::fill(out.begin(), out.end(), 0x12345678u);
+            double ms = timeIt([&]() {
+                for (unsigned int y = 0; y < SLICE_SIZE; y++)
+                    K::MapScanline(&c.data[y * SLICE_SIZE], &out[y * SLICE_SIZE], SLICE_SIZE,
+                                   lutp, outside, s);
+            }, nrep);
+            bool match = (out == ref);
+            report(c.kernel, ISA::GetInstructionSetName(s), ms, match);
+            status |= match ? 0 : 1;
+        }
+    }
+
+    struct FloatCase { const char *kernel, *filter; const std::vector<float> &data; float imin, imax; };
+    FloatCase float_cases[] = {
+        { "float kernel", "float filter", fdata, fmin, fmax },
+        { "float > 0 kernel", "float > 0 filter", gdata, gmin, gmax } };
+    for (const FloatCase &c : float_cases)
+    {
+        float scale, shift;
+        LookupTableTraits<float>::ComputeLinearMappingToLUT(c.imin, c.imax, scale, shift);
+        bool outside = c.imin > 0 || c.imax < 0;
+        mapPerPixel(&c.data[0], &ref[0], NPIX, &flut[0], c.imin, c.imax);
+        for (int isa = ISA::SCALAR; isa <= best; isa++)
+        {
+            ISA::InstructionSet s = (ISA::InstructionSet) isa;
+            std::fill(out.begin(), out.end(), 0x12345678u);
+            double ms = timeIt([&]() {
+                for (unsigned int y = 0; y < SLICE_SIZE; y++)
+                    K::MapScanline(&c.data[y * SLICE_SIZE], &out[y * SLICE_SIZE], SLICE_SIZE,
+                                   &flut[0], shift, scale, 0, 10000, outside, s);
+            }, nrep);
+            bool match = (out == ref);
+            report(c.kernel, ISA::GetInstructionSetName(s), ms, match);
+            status |= match ? 0 : 1;
+        }
+    }
+
+    double ms_rgb = timeIt([&]() {
+        for (unsigned int y = 0; y < SLICE_SIZE; y++)
+        {
+            size_t k = y * SLICE_SIZE;
+            K::MapScanline(&sdata[k], &sdata1[k], &sdata2[k], &out[k], SLICE_SIZE,
+                           &clut[0] - smin, true);
+        }
+    }, nrep);
+    report("3 x GreyType kernel", "scalar", ms_rgb, true);
+
+    // The filters, with the default number of threads. Their outputs are
+    // compared to the per-pixel mapping.
+    for (const ShortCase &c : short_cases)
+    {
+        typedef LookupTableIntensityMappingFilter<ShortSliceType, DisplaySliceType> FilterType;
+        typedef FilterType::LookupTableType LUTType;
+        LUTType::Pointer lut = makeLUT<LUTType>(c.imin, c.imax);
+        std::memcpy(lut->GetBufferPointer(), &slut[0], slut.size() * sizeof(uint32_t));
+
+        FilterType::InputPixelObject::Pointer omin = FilterType::InputPixelObject::New();
+        FilterType::InputPixelObject::Pointer omax = FilterType::InputPixelObject::New();
+        omin->Set(c.imin); omax->Set(c.imax);
+
+        FilterType::Pointer filter = FilterType::New();
+        filter->SetInput(makeSlice<ShortSliceType>(&c.data[0]));
+        filter->SetLookupTable(lut);
+        filter->SetImageMinInput(omin);
+        filter->SetImageMaxInput(omax);
+
+        double ms = timeIt([&]() { filter->Modified(); filter->Update(); }, nrep);
+        mapPerPixel(&c.data[0], &ref[0], NPIX, &slut[0] - c.imin, c.imin, c.imax);
+        bool match = !std::memcmp(filter->GetOutput()->GetBufferPointer(), &ref[0], NPIX * 4);
+        report(c.filter, "", ms, match);
+        status |= match ? 0 : 1;
+    }
+
+    for (const FloatCase &c : float_cases)
+    {
+        typedef LookupTableIntensityMappingFilter<FloatSliceType, DisplaySliceType> FilterType;
+        typedef FilterType::LookupTableType LUTType;
+        LUTType::Pointer lut = makeLUT<LUTType>(0, 10000);
+        std::memcpy(lut->GetBufferPointer(), &flut[0], flut.size() * sizeof(uint32_t));
+
+        FilterType::InputPixelObject::Pointer omin = FilterType::InputPixelObject::New();
+        FilterType::InputPixelObject::Pointer omax = FilterType::InputPixelObject::New();
+        omin->Set(c.imin); omax->Set(c.imax);
+
+        FilterType::Pointer filter = FilterType::New();
+        filter->SetInput(makeSlice<FloatSliceType>(&c.data[0]));
+        filter->SetLookupTable(lut);
+        filter->SetImageMinInput(omin);
+        filter->SetImageMaxInput(omax);
+
+        double ms = timeIt([&]() { filter->Modified(); filter->Update(); }, nrep);
+        mapPerPixel(&c.data[0], &ref[0], NPIX, &flut[0], c.imin, c.imax);
+        bool match = !std::memcmp(filter->GetOutput()->GetBufferPointer(), &ref[0], NPIX * 4);
+        report(c.filter, "", ms, match);
+        status |= match ? 0 : 1;
+    }
+
+    {
+        typedef RGBALookupTableIntensityMappingFilter<ShortSliceType> FilterType;
+        typedef FilterType::LookupTableType LUTType;
+        LUTType::Pointer lut = makeLUT<LUTType>(smin, smax);
+        std::memcpy(lut->GetBufferPointer(), &clut[0], clut.size());
+
+        FilterType::Pointer filter = FilterType::New();
+        filter->SetInput(0, makeSlice<ShortSliceType>(&sdata[0]));
+        filter->SetInput(1, makeSlice<ShortSliceType>(&sdata1[0]));
+        filter->SetInput(2, makeSlice<ShortSliceType>(&sdata2[0]));
+        filter->SetLookupTable(lut);
+
+        double ms = timeIt([&]() { filter->Modified(); filter->Update(); }, nrep);
+        K::MapScanline(&sdata[0], &sdata1[0], &sdata2[0], &ref[0], NPIX, &clut[0] - smin, false);
+        bool match = !std::memcmp(filter->GetOutput()->GetBufferPointer(), &ref[0], NPIX * 4);
+        report("3 x GreyType filter", "", ms, match);
+        status |= match ? 0 : 1;
+    }
+
+    return status;
+}
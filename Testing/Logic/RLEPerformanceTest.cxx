@@ -0,0 +1,124 @@
+#include "RLEImageRegionIterator.h"
+#include "RLERegionOfInterestImageFilter.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <itkImageFileReader.h>
+#include <itkMultiThreaderBase.h>
+#include <itkTimeProbe.h>
+#include "itkTestingComparisonImageFilter.h"
+
+// Measures how the whole-image RLE passes (conversion to and from itk::Image,
+// FillBuffer and CleanUp) scale with the number of threads, using a 4D
+// segmentation the way it is loaded by GenericImageData
+
+typedef itk::Image<short, 4> Seg4DImageType;
+typedef RLEImage<short, 4> RLEImage4D;
+
+Seg4DImageType::Pointer loadImage(const std::string filename)
+{
+    typedef itk::ImageFileReader<Seg4DImageType> SegReaderType;
+    SegReaderType::Pointer sr = SegReaderType::New();
+    sr->SetFileName(filename);
+    sr->Update();
+    return sr->GetOutput();
+}
+
+RLEImage4D::Pointer compress(Seg4DImageType *image)
+{
+    typedef itk::RegionOfInterestImageFilter<Seg4DImageType, RLEImage4D> inConverterType;
+    inConverterType::Pointer inConv = inConverterType::New();
+    inConv->SetInput(image);
+    inConv->SetRegionOfInterest(image->GetLargestPossibleRegion());
+    inConv->Update();
+    return inConv->GetOutput();
+}
+
+Seg4DImageType::Pointer uncompress(RLEImage4D *image)
+{
+    typedef itk::RegionOfInterestImageFilter<RLEImage4D, Seg4DImageType> outConverterType;
+    outConverterType::Pointer outConv = outConverterType::New();
+    outConv->SetInput(image);
+    outConv->SetRegionOfInterest(image->GetLargestPossibleRegion());
+    outConv->Update();
+    return outConv->GetOutput();
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage:\n" << argv[0] << " InputSegmentation.ext [Repetitions]" << std::endl;
+        return 1;
+    }
+
+    int nrep = argc > 2 ? atoi(argv[2]) : 3;
+
+    itk::TimeProbe tp;
+    std::cout << "Loading image: "; tp.Start();
+    Seg4DImageType::Pointer inImage = loadImage(argv[1]);
+    tp.Stop(); std::cout << tp.GetMean() * 1000 << " ms " << std::endl; tp.Reset();
+    std::cout << "Image size: " << inImage->GetLargestPossibleRegion().GetSize() << std::endl;
+
+    // Thread counts to test: powers of two up to the maximum supported
+    unsigned int maxThreads = itk::MultiThreaderBase::GetGlobalMaximumNumberOfThreads();
+    std::vector<unsigned int> threadCounts;
+    for (unsigned int n = 1; n < maxThreads && n <= 32; n *= 2)
+        threadCounts.push_back(n);
+    threadCounts.push_back(std::min(maxThreads, 32u));
+
+    std::cout << std::setw(8) << "threads"
+        << std::setw(14) << "itk->RLE ms" << std::setw(14) << "RLE->itk ms"
+        << std::setw(14) << "Fill ms" << std::setw(14) << "CleanUp ms" << std::endl;
+
+    int status = 0;
+    for (size_t i = 0; i < threadCounts.size(); i++)
+    {
+        itk::MultiThreaderBase::SetGlobalDefaultNumberOfThreads(threadCounts[i]);
+        itk::TimeProbe tpIn, tpOut, tpFill, tpClean;
+        for (int rep = 0; rep < nrep; rep++)
+        {
+            tpIn.Start();
+            RLEImage4D::Pointer rle = compress(inImage);
+            tpIn.Stop();
+
+            tpOut.Start();
+            Seg4DImageType::Pointer roundTrip = uncompress(rle);
+            tpOut.Stop();
+
+            // The round trip must reproduce the input exactly
+            if (rep == 0)
+            {
+                typedef itk::Testing::ComparisonImageFilter<Seg4DImageType, Seg4DImageType> DiffType;
+                DiffType::Pointer diff = DiffType::New();
+                diff->SetValidInput(inImage);
+                diff->SetTestInput(roundTrip);
+                diff->UpdateLargestPossibleRegion();
+                if (diff->GetNumberOfPixelsWithDifferences() > 0)
+                {
+                    std::cerr << "Round trip with " << threadCounts[i] << " threads differs in "
+                        << diff->GetNumberOfPixelsWithDifferences() << " pixels" << std::endl;
+                    status = 1;
+                }
+            }
+
+            tpClean.Start();
+            rle->CleanUp();
+            tpClean.Stop();
+
+            tpFill.Start();
+            rle->FillBuffer(0);
+            tpFill.Stop();
+        }
+
+        std::cout << std::setw(8) << threadCounts[i]
+            << std::setw(14) << tpIn.GetMean() * 1000 << std::setw(14) << tpOut.GetMean() * 1000
+            << std::setw(14) << tpFill.GetMean() * 1000 << std::setw(14) << tpClean.GetMean() * 1000
+            << std::endl;
+    }
+
+    return status;
+}
@@ -0,0 +1,388 @@
+#include "GlobalUIModel.h"
+#include "GenericSliceModel.h"
+#include "PaintbrushModel.h"
+#include "IRISApplication.h"
+#include "IRISException.h"
+#include "GenericImageData.h"
+#include "SNAPImageData.h"
+#include "LayerIterator.h"
+#include "ImageWrapperBase.h"
+#include "LabelImageWrapper.h"
+#include "MeshManager.h"
+#include "PreprocessingFilterConfigTraits.h"
+#include "RFClassificationEngine.h"
+#include "SegmentationStatistics.h"
+#include "SegmentationUpdateIterator.h"
+#include "SlicePreviewFilterWrapper.h"
+#include "UIReporterDelegates.h"
+#include "itksys/SystemTools.hxx"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <vector>
+
+// Headless benchmark of the operations that users of the application wait
+// for: opening a workspace, loading images, extracting display slices in all
+// views, painting, relabeling, undo and redo, mesh generation, statistics,
+// random forest training and classification, and active contour iterations.
+// The same logic and model classes as the GUI are used, without Qt. Each
+// phase is repeated and the timings are written as JSON, so that they can be
+// compared between builds.
+
+class BenchmarkSystemInfoDelegate : public SystemInfoDelegate
+{
+public:
+
+    BenchmarkSystemInfoDelegate(const char *argv0) : m_ExecutableName(argv0) {}
+
+    virtual std::string GetApplicationDirectory()
+        { return itksys::SystemTools::GetFilenamePath(m_ExecutableName); }
+
+    virtual std::string GetApplicationFile()
+        { return m_ExecutableName; }
+
+    virtual std::string GetApplicationPermanentDataLocation()
+        { return std::string(".itksnap.benchmark"); }
+
+    virtual std::string GetUserDocumentsLocation()
+        { return std::string(".itksnap.benchmark"); }
+
+    virtual std::string EncodeServerURL(const std::string &url)
+        { return url; }
+
+    virtual void LoadResourceAsImage2D(std::string tag, GrayscaleImage *image) {}
+    virtual void LoadResourceAsRegistry(std::string tag, Registry &reg) {}
+    virtual void WriteRGBAImage2D(std::string file, RGBAImageType *image) {}
+
+protected:
+    std::string m_ExecutableName;
+};
+
+// Slice views report a fixed viewport size, as if shown in a 512x512 window
+class BenchmarkViewportReporter : public ViewportSizeReporter
+{
+public:
+    irisITKObjectMacro(BenchmarkViewportReporter, ViewportSizeReporter)
+
+    bool CanReportSize() ITK_OVERRIDE { return true; }
+    Vector2ui GetViewportSize() ITK_OVERRIDE { return Vector2ui(512, 512); }
+    float GetViewportPixelRatio() ITK_OVERRIDE { return 1.0f; }
+    Vector2ui GetLogicalViewportSize() ITK_OVERRIDE { return Vector2ui(512, 512); }
+
+protected:
+    BenchmarkViewportReporter() {}
+    virtual ~BenchmarkViewportReporter() {}
+};
+
+// Timings of the repetitions of each phase, in the order the phases ran
+class BenchmarkReport
+{
+public:
+
+    template <class TFunc>
+    void time(const std::string &phase, TFunc f)
+    {
+        typedef std::chrono::steady_clock Clock;
+        Clock::time_point t0 = Clock::now();
+        f();
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+        if (m_Samples.find(phase) == m_Samples.end())
+            m_Order.push_back(phase);
+        m_Samples[phase].push_back(ms);
+    }
+
+    void print(std::ostream &os) const
+    {
+        os << std::setw(24) << "phase" << std::setw(8) << "n"
+           << std::setw(12) << "mean ms" << std::setw(12) << "min ms"
+           << std::setw(12) << "max ms" << std::endl;
+        for (size_t i = 0; i < m_Order.size(); i++)
+        {
+            const std::vector<double> &s = m_Samples.find(m_Order[i])->second;
+            os << std::setw(24) << m_Order[i] << std::setw(8) << s.size()
+               << std::fixed << std::setprecision(2)
+               << std::setw(12) << mean(s)
+               << std::setw(12) << *std::min_element(s.begin(), s.end())
+               << std::setw(12) << *std::max_element(s.begin(), s.end()) << std::endl;
+        }
+    }
+
+    void writeJSON(std::ostream &os, int nrep) const
+    {
+        os << "{\n  \"benchmark\": \"SNAPBenchmark\",\n"
+           << "  \"repetitions\": " << nrep << ",\n  \"phases\": [";
+        for (size_t i = 0; i < m_Order.size(); i++)
+        {
+            const std::vector<double> &s = m_Samples.find(m_Order[i])->second;
+            os << (i ? "," : "") << "\n    { \"name\": \"" << m_Order[i] << "\""
+               << std::fixed << std::setprecision(3)
+               << ", \"count\": " << s.size()
+               << ", \"mean_ms\": " << mean(s)
+               << ", \"min_ms\": " << *std::min_element(s.begin(), s.end())
+               << ", \"max_ms\": " << *std::max_element(s.begin(), s.end())
+               << ", \"samples_ms\": [";
+            for (size_t j = 0; j < s.size(); j++)
+                os << (j ? ", " : "") << s[j];
+            os << "] }";
+        }
+        os << "\n  ]\n}\n";
+    }
+
+private:
+
+    static double mean(const std::vector<double> &s)
+    {
+        double sum = 0;
+        for (size_t i = 0; i < s.size(); i++)
+            sum += s[i];
+        return sum / s.size();
+    }
+
+    std::vector<std::string> m_Order;
+    std::map<std::string, std::vector<double> > m_Samples;
+};
+
+// Bring the display slices of all the layers in all three views up to date
+void updateDisplaySlices(GenericImageData *gid)
+{
+    for (LayerIterator it = gid->GetLayers(MAIN_ROLE | OVERLAY_ROLE | LABEL_ROLE);
+         !it.IsAtEnd(); ++it)
+    {
+        for (unsigned int i = 0; i < 3; i++)
+            it.GetLayer()->GetDisplaySlice(i)->Update();
+    }
+}
+
+// Paint a stroke with the paintbrush across the slice view through the
+// cursor, from one quarter to three quarters of the image extent
+void paintStroke(GlobalUIModel *gui, unsigned int view)
+{
+    IRISApplication *driver = gui->GetDriver();
+    GenericSliceModel *sm = gui->GetSliceModel(view);
+    PaintbrushModel *pm = gui->GetPaintbrushModel(view);
+
+    Vector3ui size = driver->GetCurrentImageData()->GetVolumeExtents();
+    Vector3d pa = to_double(driver->GetCursorPosition()) + 0.5, pb = pa;
+    for (unsigned int d = 0; d < 3; d++)
+    {
+        if (d != sm->GetSliceDirectionInImageSpace())
+        {
+            pa[d] = 0.25 * size[d];
+            pb[d] = 0.75 * size[d];
+        }
+    }
+
+    Vector3d xa = sm->MapImageToSlice(pa), xb = sm->MapImageToSlice(pb);
+    pm->ProcessPushEvent(xa, Vector2ui(0, 0), false);
+
+    const int nsteps = 32;
+    Vector3d xlast = xa;
+    for (int i = 1; i <= nsteps; i++)
+    {
+        Vector3d x = xa + (xb - xa) * (i * 1.0 / nsteps);
+        pm->ProcessDragEvent(x, xlast, (x - xlast).magnitude(), i == nsteps);
+        xlast = x;
+    }
+}
+
+// Fill a box around a point with a label, as the examples for the classifier
+void paintExample(LabelImageWrapper *seg, const Vector3ui &center,
+                  unsigned int radius, LabelType label)
+{
+    itk::ImageRegion<3> region;
+    for (unsigned int d = 0; d < 3; d++)
+    {
+        region.SetIndex(d, center[d] - std::min(center[d], radius));
+        region.SetSize(d, 2 * radius + 1);
+    }
+    region.Crop(seg->GetBufferedRegion());
+
+    SegmentationUpdateIterator it(seg, region, label, DrawOverFilter());
+    it.PaintRegionAsForeground();
+    it.Finalize("Benchmark example");
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage:\n" << argv[0]
+                  << " TestDataDirectory [Output.json] [Repetitions]" << std::endl;
+        return 1;
+    }
+
+    std::string dir = argv[1];
+    std::string json = argc > 2 ? argv[2] : "";
+    int nrep = argc > 3 ? atoi(argv[3]) : 3;
+
+    BenchmarkSystemInfoDelegate sidel(argv[0]);
+    SystemInterface::SetSystemInfoDelegate(&sidel);
+
+    SmartPtr<GlobalUIModel> gui = GlobalUIModel::New();
+    IRISApplication *driver = gui->GetDriver();
+    GlobalState *gs = driver->GetGlobalState();
+
+    SmartPtr<BenchmarkViewportReporter> reporter = BenchmarkViewportReporter::New();
+    for (unsigned int i = 0; i < 3; i++)
+        gui->GetSliceModel(i)->SetSizeReporter(reporter);
+
+    BenchmarkReport report;
+
+    try
+    {
+        // Opening a 4D workspace with a segmentation and meshes
+        for (int rep = 0; rep < nrep; rep++)
+        {
+            IRISWarningList warnings;
+            report.time("workspace_open", [&]() {
+                driver->OpenProject(dir + "/segmentation_mesh.itksnap", warnings);
+            });
+        }
+
+        // Loading the main image, its segmentation and an overlay
+        for (int rep = 0; rep < nrep; rep++)
+        {
+            IRISWarningList warnings;
+            report.time("main_load", [&]() {
+                driver->OpenImage((dir + "/MRIcrop-orig.gipl.gz").c_str(), MAIN_ROLE, warnings);
+                driver->OpenImage((dir + "/MRIcrop-seg.gipl.gz").c_str(), LABEL_ROLE, warnings);
+            });
+            report.time("overlay_load", [&]() {
+                driver->OpenImage((dir + "/MRIcrop-orig.gipl.gz").c_str(), OVERLAY_ROLE, warnings);
+            });
+        }
+
+        GenericImageData *gid = driver->GetCurrentImageData();
+        Vector3ui size = gid->GetVolumeExtents();
+        Vector3ui center = size / 2u;
+        for (unsigned int i = 0; i < 3; i++)
+            gui->GetSliceModel(i)->InitializeSlice(gid);
+
+        // Every slice along each of the image axes, in all views and layers
+        for (int rep = 0; rep < nrep; rep++)
+        {
+            report.time("slice_extraction", [&]() {
+                for (unsigned int d = 0; d < 3; d++)
+                {
+                    for (unsigned int k = 0; k < size[d]; k++)
+                    {
+                        Vector3ui cursor = center;
+                        cursor[d] = k;
+                        driver->SetCursorPosition(cursor);
+                        updateDisplaySlices(gid);
+                    }
+                }
+            });
+        }
+        driver->SetCursorPosition(center);
+
+        // Paintbrush strokes in each view
+        PaintbrushSettings pbs = gs->GetPaintbrushSettings();
+        pbs.radius = 4;
+        pbs.mode = PAINTBRUSH_ROUND;
+        pbs.volumetric = false;
+        gs->SetPaintbrushSettings(pbs);
+        gs->SetDrawingColorLabel(1);
+        for (int rep = 0; rep < nrep; rep++)
+        {
+            for (unsigned int view = 0; view < 3; view++)
+                report.time("paintbrush_stroke", [&]() { paintStroke(gui, view); });
+        }
+
+        // Relabeling back and forth, and undoing and redoing it
+        for (int rep = 0; rep < nrep; rep++)
+        {
+            report.time("replace_label", [&]() { driver->ReplaceLabel(100, 1); });
+            report.time("replace_label", [&]() { driver->ReplaceLabel(1, 100); });
+        }
+
+        int nundo = 0;
+        while (driver->IsUndoPossible())
+        {
+            report.time("undo", [&]() { driver->Undo(); });
+            nundo++;
+        }
+        for (int i = 0; i < nundo && driver->IsRedoPossible(); i++)
+            report.time("redo", [&]() { driver->Redo(); });
+
+        // Meshes of all labels, after the segmentation has been modified
+        MeshManager *mesh = driver->GetMeshManager();
+        for (int rep = 0; rep < nrep; rep++)
+        {
+            driver->ReplaceLabel(rep % 2 ? 1 : 100, rep % 2 ? 100 : 1);
+            report.time("mesh_update", [&]() {
+                mesh->UpdateVTKMeshes(nullptr, driver->GetCursorTimePoint());
+            });
+        }
+
+        // Label statistics over the main image and overlay
+        for (int rep = 0; rep < nrep; rep++)
+        {
+            SegmentationStatistics stats;
+            report.time("statistics", [&]() { stats.Compute(driver); });
+        }
+
+        // Random forest classification over the whole image, with two boxes
+        // of examples, followed by active contour evolution from a bubble
+        driver->SetSnakeMode(IN_OUT_SNAKE);
+        driver->InitializeSNAPImageData(gs->GetSegmentationROISettings());
+        driver->SetCurrentImageDataToSNAP();
+        driver->EnterPreprocessingMode(PREPROCESS_RF);
+
+        SNAPImageData *sid = driver->GetSNAPImageData();
+        LabelImageWrapper *seg = sid->GetFirstSegmentationLayer();
+        unsigned int radius = std::max(1u, size.min_value() / 16);
+        paintExample(seg, center, radius, 1);
+        paintExample(seg, Vector3ui(radius, radius, radius), radius, 2);
+
+        // As in the GUI, the classifier is handed to the preview filters after
+        // each training, which makes them classify the image again
+        typedef SlicePreviewFilterWrapper<RFPreprocessingFilterConfigTraits> RFPreviewWrapper;
+        RFPreviewWrapper *rfpreview = static_cast<RFPreviewWrapper *>(
+                    driver->GetPreprocessingFilterPreviewer(PREPROCESS_RF));
+        IRISApplication::RFEngine *rf = driver->GetClassificationEngine();
+        for (int rep = 0; rep < nrep; rep++)
+        {
+            report.time("rf_training", [&]() { rf->TrainClassifier(); });
+            rf->GetClassifier()->SetForegroundClassLabel(1);
+            rfpreview->SetParameters(rf->GetClassifier());
+            report.time("rf_classification", [&]() {
+                driver->ApplyCurrentPreprocessingModeToSpeedVolume();
+            });
+        }
+        driver->EnterPreprocessingMode(PREPROCESS_NONE);
+
+        Bubble bubble;
+        bubble.center = to_int(center);
+        bubble.radius = radius * sid->GetImageSpacing().min_value();
+        driver->GetBubbleArray().push_back(bubble);
+        if (!driver->InitializeActiveContourPipeline())
+            throw IRISException("Failed to initialize the active contour");
+
+        for (int rep = 0; rep < nrep; rep++)
+            report.time("snake_iterations", [&]() { sid->RunSegmentation(10); });
+
+        driver->SetCurrentImageDataToIRIS();
+        driver->ReleaseSNAPImageData();
+    }
+    catch (std::exception &exc)
+    {
+        std::cerr << "Benchmark failed: " << exc.what() << std::endl;
+        return 1;
+    }
+
+    report.print(std::cout);
+    if (json.size())
+    {
+        std::ofstream fout(json.c_str());
+        report.writeJSON(fout, nrep);
+    }
+
+    return 0;
+}
@@ -51,6 +51,11 @@
 #include "ColorLabelTable.h"
 
 #include "IRISApplication.h"
+#include "GenericImageData.h"
+#include "GlobalState.h"
+#include "SegmentationStatistics.h"
+#include "SystemInterface.h"
+#include "UIReporterDelegates.h"
 #include "AffineTransformHelper.h"
 #include "itkTransform.h"
 
@@ -128,6 +133,10 @@ int usage(int rc)
   cout << "                                      renaming with C printf pattern (e.g. 'left %s')" << endl;
   cout << "Annotation object commands" << endl;
   cout << "  -annot-list                       : List all annotations in the workspace" << endl;
+  cout << "Statistics commands (these load the images in the workspace)" << endl;
+  cout << "  -stats-seg [file]                 : Print or save the volume and the mean/sd of each image" << endl;
+  cout << "                                      for each label in the first segmentation layer (CSV)" << endl;
+  cout << "  -stats-threads <n>                : Number of threads for statistics (default: all cores)" << endl;
   cout << "Distributed segmentation server (DSS) user commands: " << endl;
   cout << "  -dss-auth <url> [user] [passwd]   : Sign in to the server. This will create a token" << endl;
   cout << "                                      that may be used in future -dss calls" << endl;
@@ -238,6 +247,86 @@ void print_string_with_prefix(ostream &sout, const string &text, const string &p
     sout << prefix << line << endl;
 }
 
+/**
+ * The IRISApplication needs a system info delegate. The tool has no
+ * resources or GUI, so this one only knows about the executable.
+ */
+class WorkspaceToolSystemInfoDelegate : public SystemInfoDelegate
+{
+public:
+  WorkspaceToolSystemInfoDelegate(const char *argv0)
+    : m_ExecutableName(argv0) {}
+
+  virtual std::string GetApplicationDirectory()
+    { return SystemTools::GetFilenamePath(m_ExecutableName); }
+
+  virtual std::string GetApplicationFile()
+    { return m_ExecutableName; }
+
+  virtual std::string GetApplicationPermanentDataLocation()
+    {
+    std::string home;
+    SystemTools::GetEnv("HOME", home);
+    return home + "/.itksnap.org/ITK-SNAP";
+    }
+
+  virtual std::string GetUserDocumentsLocation()
+    { return SystemTools::GetFilenamePath(m_ExecutableName); }
+
+  virtual std::string EncodeServerURL(const std::string &url)
+    { return url; }
+
+  virtual void LoadResourceAsImage2D(std::string tag, GrayscaleImage *image) {}
+  virtual void LoadResourceAsRegistry(std::string tag, Registry &reg) {}
+  virtual void WriteRGBAImage2D(std::string file, RGBAImageType *image) {}
+
+protected:
+  std::string m_ExecutableName;
+};
+
+/**
+ * Compute the label statistics for the workspace without the GUI. The main
+ * image, the overlays and the first segmentation are loaded into an
+ * IRISApplication, as if the workspace was opened in ITK-SNAP.
+ */
+void ComputeSegmentationStatistics(WorkspaceAPI &ws, const char *argv0,
+                                   unsigned int n_threads, ostream &sout)
+{
+  static WorkspaceToolSystemInfoDelegate sidel(argv0);
+  SystemInterface::SetSystemInfoDelegate(&sidel);
+  IRISApplication::Pointer app = IRISApplication::New();
+
+  string key_main = ws.FindLayerByRole("MainRole", 0);
+  string key_seg = ws.FindLayerByRole("SegmentationRole", 0);
+  if(key_main.empty())
+    throw IRISException("Workspace has no main image");
+
+  // Load the layers in the same order as the project loader does
+  IRISWarningList warn;
+  list<pair<string, LayerRole> > to_load;
+  to_load.push_back(make_pair(key_main, MAIN_ROLE));
+  string key;
+  for(int i = 0; !(key = ws.FindLayerByRole("OverlayRole", i)).empty(); i++)
+    to_load.push_back(make_pair(key, OVERLAY_ROLE));
+  if(!key_seg.empty())
+    to_load.push_back(make_pair(key_seg, LABEL_ROLE));
+
+  for(list<pair<string, LayerRole> >::iterator it = to_load.begin(); it != to_load.end(); ++it)
+    {
+    Registry &folder = ws.GetLayerFolder(it->first);
+    string fn = ws.GetLayerActualPath(folder);
+    app->OpenImage(fn.c_str(), it->second, warn, &folder, ws.GetLayerIOHints(folder));
+    }
+
+  app->GetGlobalState()->SetSelectedSegmentationLayerId(
+        app->GetCurrentImageData()->GetFirstSegmentationLayer()->GetUniqueId());
+
+  SegmentationStatistics stats;
+  stats.SetNumberOfThreads(n_threads);
+  stats.Compute(app);
+  stats.Export(sout, ",", *app->GetColorLabelTable());
+}
+
 void simple_rest_get(const char *url, const char *exception_message, const char *prefix, ...)
 {
   // Handle the ...
@@ -371,6 +460,9 @@ int main(int argc, char *argv[])
   // The command index for which the temporary prefix should be used
   int temp_prefix_cmd_index = -1;
 
+  // Number of threads used to compute statistics, zero for default
+  unsigned int stats_threads = 0;
+
   // Context ticket id, i.e., the ticket id substituted for '--' in the input
   // TODO: implement this
   int context_ticket_id;
@@ -748,6 +840,27 @@ int main(int argc, char *argv[])
         {
         ws.PrintAnnotationList(cout, prefix);
         }
+      else if(arg == "-stats-threads")
+        {
+        stats_threads = (unsigned int) cl.read_integer();
+        }
+      else if(arg == "-stats-seg")
+        {
+        if(cl.command_arg_count() > 0)
+          {
+          string fn = cl.read_output_filename();
+          ofstream fout(fn.c_str());
+          if(!fout.good())
+            throw IRISException("Can not open file %s for writing", fn.c_str());
+          ComputeSegmentationStatistics(ws, argv[0], stats_threads, fout);
+          }
+        else
+          {
+          ostringstream oss;
+          ComputeSegmentationStatistics(ws, argv[0], stats_threads, oss);
+          print_string_with_prefix(cout, oss.str(), prefix);
+          }
+        }
       else if(arg == "-dss-auth")
         {
         // Read the url of the server